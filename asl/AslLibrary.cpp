@@ -0,0 +1,111 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    AslLibrary - Compile Asl programs and run their subroutines
+//                 inside another program
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "AslLibrary.h"
+#include "Compiler.h"
+
+#include "antlr4-runtime.h"
+
+#include <string>
+#include <vector>
+#include <sstream>    // ostringstream
+
+#include <cstdlib>    // EXIT_SUCCESS
+
+// using namespace std;
+
+
+//////////////////////////////////////////////////////////////////////
+// AslProgram
+
+bool AslProgram::compile(const std::string & source, std::string & errors,
+                         unsigned int optLevel) {
+  Compiler::Options options;
+  options.optLevel = optLevel;
+  Compiler compiler(options);
+  antlr4::ANTLRInputStream input(source);
+  // no arena is used, so the code outlives the compilation
+  code generated;
+  std::ostringstream messages;
+  if (compiler.compile(input, generated, messages, messages) != EXIT_SUCCESS) {
+    errors = messages.str();
+    return false;
+  }
+  return load(generated, errors);
+}
+
+bool AslProgram::load(const code & program, std::string & errors) {
+  Code = program;
+  return Binary.build(Code, errors);
+}
+
+const code & AslProgram::getCode() const {
+  return Code;
+}
+
+const BinaryCode & AslProgram::getBinary() const {
+  return Binary;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+// AslInstance
+
+AslInstance::AslInstance(const AslProgram & program) :
+  VM{program.getBinary()} {
+}
+
+void AslInstance::setInput(ReadFunction read) {
+  Input.set_function(read);
+}
+
+void AslInstance::setOutput(WriteFunction write) {
+  Output.set_function(write);
+}
+
+void AslInstance::setLimits(const vmachine::Limits & limits) {
+  VM.set_limits(limits);
+}
+
+bool AslInstance::call(const std::string & name, const std::vector<vmachine::Value> & args,
+                       vmachine::Value & result) {
+  return VM.call(name, args, result, Input, Output);
+}
+
+bool AslInstance::run() {
+  return VM.execute(Input, Output);
+}
+
+const std::string & AslInstance::getError() const {
+  return VM.get_error();
+}
+
+const vmachine::Status & AslInstance::getStatus() const {
+  return VM.get_status();
+}
@@ -0,0 +1,130 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    AslLibrary - Compile Asl programs and run their subroutines
+//                 inside another program
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "../common/code.h"
+#include "../common/BinaryCode.h"
+#include "../common/vmachine.h"
+#include "../common/BufferedIO.h"
+
+#include <string>
+#include <vector>
+
+// using namespace std;
+
+
+//////////////////////////////////////////////////////////////////////
+// The asl library (libasl.a, built with asl) lets a host program run
+// Asl code without starting tvm or vm for each evaluation:
+//
+//    AslProgram program;
+//    std::string errors;
+//    if (not program.compile(source, errors)) ...
+//    AslInstance vm(program);
+//    vmachine::Value result;
+//    if (vm.call("fact", {vmachine::Value(5)}, result)) ... result.as_int()
+//
+// An AslProgram is compiled once and then only read, so it can be
+// shared by any number of AslInstance's, and each instance can be
+// used from its own thread at the same time as the others.
+
+
+//////////////////////////////////////////////////////////////////////
+// Class AslProgram: a compiled program, both as code and as binary
+// t-code ready to be run.
+
+class AslProgram {
+
+public:
+
+  // Constructor (an empty program)
+  AslProgram() = default;
+
+  AslProgram (const AslProgram &) = delete;
+  AslProgram & operator= (const AslProgram &) = delete;
+
+  // Compile an Asl program at the given optimization level. Returns
+  // false, with the messages of asl in 'errors', if it has errors
+  bool compile (const std::string & source, std::string & errors,
+                unsigned int optLevel = 1);
+  // Take code already generated (e.g. by Compiler::compile)
+  bool load (const code & program, std::string & errors);
+
+  const code       & getCode   () const;
+  const BinaryCode & getBinary () const;
+
+private:
+
+  // Attributes
+  code       Code;
+  BinaryCode Binary;
+
+};  // class AslProgram
+
+
+//////////////////////////////////////////////////////////////////////
+// Class AslInstance: a virtual machine running an AslProgram, which
+// must outlive it. What the program reads and writes goes through
+// functions of the host (by default there is no input and the output
+// is lost). The input is not rewound between calls.
+
+class AslInstance {
+
+public:
+
+  // Constructor
+  AslInstance(const AslProgram & program);
+
+  // Functions that give the input and take the output of the program
+  void setInput  (ReadFunction read);
+  void setOutput (WriteFunction write);
+  // Limits of each call (see vmachine::Limits)
+  void setLimits (const vmachine::Limits & limits);
+
+  // Call the subroutine 'name' with the values of its params, and
+  // get its _result (0 for a procedure). Returns false if it can not
+  // be called or stops before returning (see getError)
+  bool call (const std::string & name, const std::vector<vmachine::Value> & args,
+             vmachine::Value & result);
+  // Run 'main'
+  bool run ();
+
+  // Message of the last failed call, and how it ended
+  const std::string      & getError  () const;
+  const vmachine::Status & getStatus () const;
+
+private:
+
+  // Attributes
+  vmachine   VM;
+  HostInput  Input;
+  HostOutput Output;
+
+};  // class AslInstance
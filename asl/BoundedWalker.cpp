@@ -0,0 +1,62 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    BoundedWalker - Walk the parser tree until the limit of
+//                    semantic errors is reached
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "BoundedWalker.h"
+
+#include "antlr4-runtime.h"
+#include "tree/ParseTreeWalker.h"
+
+#include "../common/SemErrors.h"
+
+// using namespace std;
+
+
+// Constructor
+BoundedWalker::BoundedWalker(const SemErrors & Errors) :
+  Errors{Errors} {
+}
+
+// Terminal and error nodes are visited by the ParseTreeWalker
+void BoundedWalker::walk(antlr4::tree::ParseTreeListener *listener,
+                         antlr4::tree::ParseTree *t) const {
+  if (Errors.limitReached()) return;
+  auto ctx = dynamic_cast<antlr4::ParserRuleContext *>(t);
+  if (ctx == nullptr) {
+    antlr4::tree::ParseTreeWalker::walk(listener, t);
+    return;
+  }
+  listener->enterEveryRule(ctx);
+  ctx->enterRule(listener);
+  for (auto child : ctx->children) {
+    walk(listener, child);
+    if (Errors.limitReached()) return;
+  }
+  ctx->exitRule(listener);
+  listener->exitEveryRule(ctx);
+}
@@ -0,0 +1,62 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    BoundedWalker - Walk the parser tree until the limit of
+//                    semantic errors is reached
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "antlr4-runtime.h"
+#include "tree/ParseTreeWalker.h"
+
+#include "../common/SemErrors.h"
+
+// using namespace std;
+
+
+//////////////////////////////////////////////////////////////////////
+// Class BoundedWalker: derived from ParseTreeWalker. Walks the tree
+// in the same way, calling the same methods of the listener, but
+// stops as soon as the SemErrors has reached its limit of errors
+// (the nodes entered are then not exited). With no limit it does
+// the whole walk.
+
+class BoundedWalker : public antlr4::tree::ParseTreeWalker {
+
+public:
+
+  // Constructor
+  BoundedWalker(const SemErrors & Errors);
+
+  void walk(antlr4::tree::ParseTreeListener *listener,
+            antlr4::tree::ParseTree *t) const override;
+
+private:
+
+  // Attributes
+  const SemErrors & Errors;
+
+};  // class BoundedWalker
@@ -53,16 +53,30 @@ CodeGenListener::CodeGenListener(TypesMgr       & Types,
   Types{Types},
   Symbols{Symbols},
   Decorations{Decorations},
+  Generated{Decorations},
   Code{Code} {
 }
 
+CodeGenListener::CodeGenListener(TypesMgr       & Types,
+				 SymTable       & Symbols,
+				 TreeDecoration & Decorations,
+				 TreeDecoration & Generated,
+				 code           & Code) :
+  Types{Types},
+  Symbols{Symbols},
+  Decorations{Decorations},
+  Generated{Generated},
+  Code{Code} {
+}
+
+void CodeGenListener::setFunctionEmitter(std::function<void (subroutine &)> emit) {
+  EmitFunction = emit;
+}
+
 void CodeGenListener::enterProgram(AslParser::ProgramContext *ctx) {
   DEBUG_ENTER();
-  SymTable::ScopeId sc = getScopeDecor(ctx);
-  Symbols.pushThisScope(sc);
 }
 void CodeGenListener::exitProgram(AslParser::ProgramContext *ctx) {
-  Symbols.popScope();
   DEBUG_EXIT();
 }
 
@@ -73,14 +87,16 @@ void CodeGenListener::enterFunction(AslParser::FunctionContext *ctx) {
   if (ctx->returnSt() != NULL) {
     subrRef.add_param("_result");
   }
-  //add params
+  //add params (arrays are passed by reference, the VM needs to know)
   for(uint i = 1; i < ctx->ID().size(); ++i){
       std::string name = ctx->ID(i)->getText();
-      subrRef.add_param(name);
+      TypesMgr::TypeId t = getTypeDecor(ctx->type(i-1));
+      std::size_t cells = 0;
+      if (Types.isArrayTy(t))
+        cells = Types.getArraySize(t) * Types.getSizeOfType(Types.getArrayElemType(t));
+      subrRef.add_param(name, cells);
   }
   Code.add_subroutine(subrRef);
-  SymTable::ScopeId sc = getScopeDecor(ctx);
-  Symbols.pushThisScope(sc);
   codeCounters.reset();
 }
 void CodeGenListener::exitFunction(AslParser::FunctionContext *ctx) {
@@ -105,10 +121,16 @@ void CodeGenListener::exitFunction(AslParser::FunctionContext *ctx) {
     else if (Types.isCharacterTy(tRet)){
       code = code || instruction::CHLOAD("_result",addrRet);
     }
+    antlr4::Token *ret = ctx->returnSt()->getStart();
+    code.set_position(ret->getLine(), ret->getCharPositionInLine());
   }
   code = code || instruction::RETURN();
+  code.set_position(ctx->getStop()->getLine(), ctx->getStop()->getCharPositionInLine());
   subrRef.set_instructions(code);
-  Symbols.popScope();
+  if (EmitFunction) {
+    EmitFunction(subrRef);
+    Code.remove_last_subroutine();
+  }
   DEBUG_EXIT();
 }
 
@@ -119,8 +141,9 @@ void CodeGenListener::enterCallfunctionStmt(AslParser::CallfunctionStmtContext *
 void CodeGenListener::exitCallfunctionStmt(AslParser::CallfunctionStmtContext *ctx) {
   instructionList code;
   //std::string name = ctx->ident()->ID()->getSymbol()->getText();
-  std::string name = ctx->ID()->getText();
-  TypesMgr::TypeId t = Symbols.getType(name);
+  SymTable::Binding b = getBindingDecor(ctx);
+  const std::string & name = Symbols.identName(b.ident);
+  TypesMgr::TypeId t = b.type;
   TypesMgr:: TypeId tRet = Types.getFuncReturnType(t);
   std::string temp = "%" + codeCounters.newTEMP();
   
@@ -171,8 +194,9 @@ void CodeGenListener::enterCallfunction(AslParser::CallfunctionContext *ctx) {
 void CodeGenListener::exitCallfunction(AslParser::CallfunctionContext *ctx) {
  //std::string name = ctx->ident()->ID()->getSymbol()->getText();
   instructionList code;
-  std::string name = ctx->ID()->getText();
-  TypesMgr::TypeId t = Symbols.getType(name);
+  SymTable::Binding b = getBindingDecor(ctx);
+  const std::string & name = Symbols.identName(b.ident);
+  TypesMgr::TypeId t = b.type;
   TypesMgr:: TypeId tRet = Types.getFuncReturnType(t);
   std::string temp = "%" + codeCounters.newTEMP();
   
@@ -304,8 +328,12 @@ void CodeGenListener::exitAssignStmt(AslParser::AssignStmtContext *ctx) {
   std::string temp = "%"+codeCounters.newTEMP();
   code = code1 || code2;
   
-  if (offs1 != ""){
-    code = code || instruction::XLOAD(addr1,offs1,addr2);
+  if (Types.isArrayTy(tid1)) {
+    // whole array assignment (both have the same type)
+    code = code || instruction::COPY(addr1, addr2, std::to_string(Types.getSizeOfType(tid1)));
+  }
+  else if (offs1 != ""){
+    code = code || instruction::XLOAD(addr1,offs1,addr2,arrayBound(ctx->left_expr()));
   }
   else{
     code = code || instruction::LOAD(addr1, addr2);
@@ -387,7 +415,7 @@ void CodeGenListener::exitReadStmt(AslParser::ReadStmtContext *ctx) {
     else{
       code = code1 || instruction::READI(temp);
     }
-    code = code || instruction::XLOAD(addr1,offs1,temp);
+    code = code || instruction::XLOAD(addr1,offs1,temp,arrayBound(ctx->left_expr()));
   }
   
   else if(Types.isFloatTy(tid1)){
@@ -430,38 +458,11 @@ void CodeGenListener::enterWriteString(AslParser::WriteStringContext *ctx) {
   DEBUG_ENTER();
 }
 void CodeGenListener::exitWriteString(AslParser::WriteStringContext *ctx) {
-  instructionList code;
+  // The whole literal is written at once; the temporal is only used
+  // if it is expanded to one 'writec' per character
   std::string s = ctx->STRING()->getText();
   std::string temp = "%"+codeCounters.newTEMP();
-  int i = 1;
-  while (i < int(s.size())-1) {
-    if (s[i] != '\\') {
-      code = code ||
-	     instruction::CHLOAD(temp, s.substr(i,1)) ||
-	     instruction::WRITEC(temp);
-      i += 1;
-    }
-    else {
-      assert(i < int(s.size())-2);
-      if (s[i+1] == 'n') {
-        code = code || instruction::WRITELN();
-        i += 2;
-      }
-      else if (s[i+1] == 't' or s[i+1] == '"' or s[i+1] == '\\') {
-        code = code ||
-               instruction::CHLOAD(temp, s.substr(i,2)) ||
-	       instruction::WRITEC(temp);
-        i += 2;
-      }
-      else {
-        code = code ||
-               instruction::CHLOAD(temp, s.substr(i,1)) ||
-	       instruction::WRITEC(temp);
-        i += 1;
-      }
-    }
-  }
-  putCodeDecor(ctx, code);
+  putCodeDecor(ctx, instruction::WRITES(temp, s));
   DEBUG_EXIT();
 }
 
@@ -470,7 +471,7 @@ void CodeGenListener::enterLeft_expr(AslParser::Left_exprContext *ctx) {
 }
 void CodeGenListener::exitLeft_expr(AslParser::Left_exprContext *ctx) {
   if (ctx->expr() == NULL) {
-    putAddrDecor(ctx, ctx->ID()->getText());
+    putAddrDecor(ctx, Symbols.identName(getBindingDecor(ctx).ident));
     putOffsetDecor(ctx, "");
     putCodeDecor(ctx, instructionList());
   }
@@ -479,16 +480,17 @@ void CodeGenListener::exitLeft_expr(AslParser::Left_exprContext *ctx) {
     std::string addr = getAddrDecor(ctx->expr());
     instructionList code = getCodeDecor(ctx->expr());
     
-    std::string nameVector = ctx->ID()->getText();
+    SymTable::Binding b = getBindingDecor(ctx);
+    const std::string & nameVector = Symbols.identName(b.ident);
     std::string offset = "%"+codeCounters.newTEMP();
     std::string i = "%"+codeCounters.newTEMP();
     std::string temp = "%"+codeCounters.newTEMP();
 
-    TypesMgr::TypeId t = Symbols.getType(nameVector);
+    TypesMgr::TypeId t = b.type;
     TypesMgr::TypeId tVector = Types.getArrayElemType(t);
     int size = Types.getSizeOfType(tVector);
   
-    if (Symbols.isParameterClass(nameVector)) {
+    if (b.symClass == SymTable::ParameterClass) {
       code = code || instruction::ILOAD(i,std::to_string(size)) || instruction::MUL(offset,i,addr) || instruction::LOAD(temp,nameVector);
       putAddrDecor(ctx, temp);
     }
@@ -777,24 +779,28 @@ void CodeGenListener::exitArrayvalue(AslParser::ArrayvalueContext *ctx) {
   std::string addr = getAddrDecor(ctx->expr());
   instructionList code = getCodeDecor(ctx->expr());
   
-  std::string nameVector = ctx->ID()->getText();
+  SymTable::Binding b = getBindingDecor(ctx);
+  const std::string & nameVector = Symbols.identName(b.ident);
   
   std::string offset = "%"+codeCounters.newTEMP();
   std::string i = "%"+codeCounters.newTEMP();
   std::string temp = "%"+codeCounters.newTEMP();
   
-  TypesMgr::TypeId t = Symbols.getType(nameVector);
+  TypesMgr::TypeId t = b.type;
   TypesMgr::TypeId tVector = Types.getArrayElemType(t);
   int size = Types.getSizeOfType(tVector);
 
+  // cells of the array, so the VM can check the offset
+  unsigned int bound = Types.getArraySize(t) * size;
+
   code = code || instruction::ILOAD(i,std::to_string(size)) || instruction::MUL(offset,i,addr);
-  if (Symbols.isParameterClass(nameVector)) {
+  if (b.symClass == SymTable::ParameterClass) {
     std::string temp2 = "%"+codeCounters.newTEMP();
     code = code || instruction::LOAD(temp2, nameVector) 
-                || instruction::LOADX(temp, temp2, offset);
+                || instruction::LOADX(temp, temp2, offset, bound);
   }
   else{
-    code = code || instruction::LOADX(temp, nameVector, offset);
+    code = code || instruction::LOADX(temp, nameVector, offset, bound);
   }
   putAddrDecor(ctx, temp);
   putCodeDecor(ctx, code);
@@ -822,7 +828,7 @@ void CodeGenListener::exitAtom(AslParser::AtomContext *ctx) {
   instructionList code;
   
   if(ctx->ID() != NULL) {
-    putAddrDecor(ctx, ctx->ID()->getText());
+    putAddrDecor(ctx, Symbols.identName(getBindingDecor(ctx).ident));
     putOffsetDecor(ctx, "");
     putCodeDecor(ctx, instructionList());
   }
@@ -894,31 +900,43 @@ void CodeGenListener::exitIdent(AslParser::IdentContext *ctx) {
 
 
 // Getters for the necessary tree node atributes:
-//   Scope, Type, Addr, Offset and Code
+//   Scope, Type, Binding, Addr, Offset and Code
 SymTable::ScopeId CodeGenListener::getScopeDecor(antlr4::ParserRuleContext *ctx) {
   return Decorations.getScope(ctx);
 }
 TypesMgr::TypeId CodeGenListener::getTypeDecor(antlr4::ParserRuleContext *ctx) {
   return Decorations.getType(ctx);
 }
+SymTable::Binding CodeGenListener::getBindingDecor(antlr4::ParserRuleContext *ctx) {
+  return Decorations.getBinding(ctx);
+}
 std::string CodeGenListener::getAddrDecor(antlr4::ParserRuleContext *ctx) {
-  return Decorations.getAddr(ctx);
+  return Generated.getAddr(ctx);
 }
 std::string  CodeGenListener::getOffsetDecor(antlr4::ParserRuleContext *ctx) {
-  return Decorations.getOffset(ctx);
+  return Generated.getOffset(ctx);
 }
 instructionList CodeGenListener::getCodeDecor(antlr4::ParserRuleContext *ctx) {
-  return Decorations.getCode(ctx);
+  return Generated.getCode(ctx);
 }
 
 // Setters for the necessary tree node attributes:
 //   Addr, Offset and Code
 void CodeGenListener::putAddrDecor(antlr4::ParserRuleContext *ctx, const std::string & a) {
-  Decorations.putAddr(ctx, a);
+  Generated.putAddr(ctx, a);
 }
 void CodeGenListener::putOffsetDecor(antlr4::ParserRuleContext *ctx, const std::string & o) {
-  Decorations.putOffset(ctx, o);
+  Generated.putOffset(ctx, o);
 }
 void CodeGenListener::putCodeDecor(antlr4::ParserRuleContext *ctx, const instructionList & c) {
-  Decorations.putCode(ctx, c);
+  // the instructions not coming from an inner node belong to this one
+  instructionList code = c;
+  code.set_position(ctx->getStart()->getLine(), ctx->getStart()->getCharPositionInLine());
+  Generated.putCode(ctx, code);
+}
+
+// Number of cells of the array indexed by a left_expr 'a[i]'
+unsigned int CodeGenListener::arrayBound(AslParser::Left_exprContext *ctx) {
+  TypesMgr::TypeId t = getBindingDecor(ctx).type;
+  return Types.getArraySize(t) * Types.getSizeOfType(Types.getArrayElemType(t));
 }
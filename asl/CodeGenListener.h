@@ -38,6 +38,7 @@
 #include "../common/code.h"
 
 #include <string>
+#include <functional>
 
 // using namespace std;
 
@@ -62,6 +63,20 @@ public:
 		  TreeDecoration & TreeNodeProps,
 		  code           & Code);
 
+  // Constructor that keeps the attributes it computes (Addr, Offset
+  // and Code) in Generated instead of in TreeNodeProps, which is only
+  // read. Several listeners built this way can generate different
+  // functions of the same tree at the same time
+  CodeGenListener(TypesMgr       & Types,
+		  SymTable       & Symbols,
+		  TreeDecoration & TreeNodeProps,
+		  TreeDecoration & Generated,
+		  code           & Code);
+
+  // Streaming mode: each function is handed to 'emit' as soon as its
+  // code is complete, and then it is removed from Code
+  void setFunctionEmitter(std::function<void (subroutine &)> emit);
+
   void enterProgram(AslParser::ProgramContext *ctx);
   void exitProgram(AslParser::ProgramContext *ctx);
 
@@ -155,13 +170,16 @@ private:
   TypesMgr        & Types;
   SymTable        & Symbols;
   TreeDecoration  & Decorations;
+  TreeDecoration  & Generated;
   code            & Code;
   counters          codeCounters;
+  std::function<void (subroutine &)> EmitFunction;
 
   // Getters for the necessary tree node atributes:
-  //   Scope, Type, Addr, Offset and Code
-  SymTable::ScopeId getScopeDecor  (antlr4::ParserRuleContext *ctx);
-  TypesMgr::TypeId  getTypeDecor   (antlr4::ParserRuleContext *ctx);
+  //   Scope, Type, Binding, Addr, Offset and Code
+  SymTable::ScopeId getScopeDecor   (antlr4::ParserRuleContext *ctx);
+  TypesMgr::TypeId  getTypeDecor    (antlr4::ParserRuleContext *ctx);
+  SymTable::Binding getBindingDecor (antlr4::ParserRuleContext *ctx);
   std::string       getAddrDecor   (antlr4::ParserRuleContext *ctx);
   std::string       getOffsetDecor (antlr4::ParserRuleContext *ctx);
   instructionList   getCodeDecor   (antlr4::ParserRuleContext *ctx);
@@ -172,4 +190,7 @@ private:
   void putOffsetDecor (antlr4::ParserRuleContext *ctx, const std::string & o);
   void putCodeDecor   (antlr4::ParserRuleContext *ctx, const instructionList & c);
 
+  // Number of cells of the array indexed by a left_expr 'a[i]'
+  unsigned int arrayBound (AslParser::Left_exprContext *ctx);
+
 };
@@ -0,0 +1,140 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    CompileServer - Keep asl running and compile the programs
+//                    sent by its clients
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "CompileServer.h"
+#include "Compiler.h"
+
+#include "antlr4-runtime.h"
+
+#include "../common/CompileChannel.h"
+#include "../common/Arena.h"
+
+#include <string>
+#include <vector>
+#include <sstream>    // ostringstream
+#include <thread>
+#include <exception>
+
+#include <cstdlib>    // EXIT_FAILURE
+
+#include <unistd.h>   // close
+#include <sys/socket.h>
+
+// using namespace std;
+
+
+// Constructor
+CompileServer::CompileServer(const std::string & socketPath,
+                             unsigned int numThreads) :
+  SocketPath{socketPath},
+  NumThreads{numThreads} {
+  if (NumThreads == 0) NumThreads = std::thread::hardware_concurrency();
+  if (NumThreads == 0) NumThreads = 1;
+}
+
+int CompileServer::run(std::ostream & log) {
+  std::string error;
+  int listenFd = CompileChannel::listen(SocketPath, error);
+  if (listenFd < 0) {
+    log << error << std::endl;
+    return EXIT_FAILURE;
+  }
+  log << "asl: serving at " << SocketPath << " with " << NumThreads
+      << " threads" << std::endl;
+
+  std::vector<std::thread> pool;
+  for (unsigned int t = 0; t < NumThreads; ++t)
+    pool.push_back(std::thread(&CompileServer::worker, this));
+  while (true) {
+    int fd = ::accept(listenFd, nullptr, nullptr);
+    if (fd < 0) continue;
+    {
+      std::lock_guard<std::mutex> lock(Mutex);
+      Pending.push_back(fd);
+    }
+    Ready.notify_one();
+  }
+}
+
+void CompileServer::worker() {
+  Arena arena;
+  while (true) {
+    int fd;
+    {
+      std::unique_lock<std::mutex> lock(Mutex);
+      Ready.wait(lock, [this] { return not Pending.empty(); });
+      fd = Pending.front();
+      Pending.pop_front();
+    }
+    serve(fd, arena);
+  }
+}
+
+// The input file can not be given in the options: the source comes
+// with the request. A request that fails with an exception (e.g.
+// bad_alloc) gets an error reply and closes its connection, but
+// the server goes on with the others
+void CompileServer::serve(int fd, Arena & arena) {
+  CompileChannel channel(fd);
+  CompileRequest request;
+  while (true) {
+    CompileReply reply;
+    try {
+      if (not channel.receiveRequest(request)) break;
+      Compiler::Options options;
+      std::string fileName;
+      if (not Compiler::parseOptions(request.args, options, fileName) or
+          fileName != "") {
+        reply.status = EXIT_FAILURE;
+        reply.err = "Usage: " + Compiler::usage() + "\n";
+      }
+      else {
+        std::ostringstream out, err;
+        {
+          Arena::Use useArena(arena);
+          antlr4::ANTLRInputStream input(request.source);
+          Compiler compiler(options);
+          reply.status = compiler.compile(input, out, err);
+        }
+        arena.reset();
+        reply.out = out.str();
+        reply.err = err.str();
+      }
+    }
+    catch (const std::exception & e) {
+      arena.reset();
+      reply.status = EXIT_FAILURE;
+      reply.out = "";
+      reply.err = std::string("asl: the request failed: ") + e.what() + "\n";
+      channel.sendReply(reply);
+      break;
+    }
+    if (not channel.sendReply(reply)) break;
+  }
+}
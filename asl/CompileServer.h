@@ -0,0 +1,81 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    CompileServer - Keep asl running and compile the programs
+//                    sent by its clients
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "../common/CompileChannel.h"
+#include "../common/Arena.h"
+
+#include <string>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <iostream>
+
+// using namespace std;
+
+
+//////////////////////////////////////////////////////////////////////
+// Class CompileServer: asl --serve. Listens on a Unix socket and
+// compiles the programs its clients send (see CompileChannel), so
+// the start of the process, the loading of the antlr4 runtime and
+// the warming of the parser tables are paid only once. A fixed pool
+// of threads serves the clients: each thread takes a connection,
+// answers its requests until the client closes it, and then takes
+// the next one. Every thread keeps its own Arena, that is reset
+// (not released) after each compilation.
+
+class CompileServer {
+
+public:
+
+  // Constructor (numThreads == 0 means one thread per core)
+  CompileServer(const std::string & socketPath, unsigned int numThreads);
+
+  // Accept clients until the process is killed. Returns EXIT_FAILURE
+  // (writing the reason to 'log') if the socket can not be created
+  int run (std::ostream & log);
+
+private:
+
+  // Attributes
+  std::string  SocketPath;
+  unsigned int NumThreads;
+
+  // Connections accepted and not yet taken by a thread
+  std::deque<int>         Pending;
+  std::mutex              Mutex;
+  std::condition_variable Ready;
+
+  // Work of each thread of the pool
+  void worker ();
+  // Answer the requests of a client
+  void serve (int fd, Arena & arena);
+
+};  // class CompileServer
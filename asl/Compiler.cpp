@@ -0,0 +1,347 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    Compiler - Compile an Asl program into t-code with the
+//               options of the asl command
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "Compiler.h"
+
+#include "antlr4-runtime.h"
+#include "AslLexer.h"
+#include "AslParser.h"
+#include "tree/ParseTreeWalker.h"
+
+#include "../common/TypesMgr.h"
+#include "../common/SymTable.h"
+#include "../common/TreeDecoration.h"
+#include "../common/SemErrors.h"
+#include "SymbolsListener.h"
+#include "TypeCheckListener.h"
+#include "../common/code.h"
+#include "CodeGenListener.h"
+#include "FusedListener.h"
+#include "ParallelCodeGen.h"
+#include "IncrementalCodeGen.h"
+#include "BoundedWalker.h"
+#include "../common/PassManager.h"
+#include "../common/BinaryCode.h"
+#include "../common/CodeCache.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>    // ostringstream
+#include <string>
+#include <vector>
+#include <algorithm>  // std::find
+#include <functional>
+#include <memory>     // std::unique_ptr
+
+#include <cstdlib>    // EXIT_FAILURE, EXIT_SUCCESS, std::atoi
+
+// using namespace std;
+// using namespace antlr4;
+
+
+namespace {
+
+  // Writes the lexical and syntax errors to a stream, in the same
+  // way as the default listener of antlr4 writes them to std::cerr.
+  // With a limit of errors, the parse is cancelled when it is reached
+  class StreamErrorListener : public antlr4::BaseErrorListener {
+  public:
+    StreamErrorListener(std::ostream & out, std::size_t maxErrors) :
+      out{out}, maxErrors{maxErrors} { }
+    void syntaxError(antlr4::Recognizer *recognizer, antlr4::Token *offendingSymbol,
+                     size_t line, size_t charPositionInLine,
+                     const std::string & msg, std::exception_ptr e) override {
+      out << "line " << line << ":" << charPositionInLine << " " << msg << std::endl;
+      if (maxErrors > 0 and ++numErrors >= maxErrors)
+        throw antlr4::ParseCancellationException();
+    }
+  private:
+    std::ostream & out;
+    std::size_t    maxErrors, numErrors = 0;
+  };
+
+  // Writes a line "function pc line:column" for each instruction of
+  // subr that has a source position
+  void writeLineTable(const subroutine & subr, std::ostream & out) {
+    const instructionList & lins = subr.get_instructions();
+    for (std::size_t pc = 0; pc < lins.size(); ++pc)
+      if (lins[pc].line != 0)
+        out << subr.get_name() << " " << pc << " "
+            << lins[pc].line << ":" << lins[pc].column << "\n";
+  }
+
+}
+
+bool Compiler::parseOptions(const std::vector<std::string> & args,
+                            Options & options, std::string & fileName) {
+  for (std::size_t i = 0; i < args.size(); ++i) {
+    const std::string & arg = args[i];
+    if (arg == "-O0" or arg == "-O1" or arg == "-O2")
+      options.optLevel = arg[2] - '0';
+    else if (arg == "--time-passes")
+      options.timePasses = true;
+    else if (arg == "--fused")
+      options.fused = true;
+    else if (arg.compare(0, 14, "--print-after=") == 0)
+      options.printAfter = arg.substr(14);
+    else if (arg.compare(0, 13, "--line-table=") == 0)
+      options.lineTable = arg.substr(13);
+    else if (arg.compare(0, 8, "--cache=") == 0)
+      options.cacheDir = arg.substr(8);
+    else if (arg == "--stats")
+      options.stats = true;
+    else if (arg == "--max-errors" and i+1 < args.size())
+      options.maxErrors = std::atoi(args[++i].c_str());
+    else if (arg == "-j" and i+1 < args.size())
+      options.jobs = std::atoi(args[++i].c_str());
+    else if (arg == "-o" and i+1 < args.size())
+      options.outputFile = args[++i];
+    else if (arg != "" and arg[0] != '-' and fileName == "")
+      fileName = arg;
+    else
+      return false;
+  }
+  // The cache decides which functions are walked, so it can not be
+  // combined with the fused walk
+  if (options.cacheDir != "") options.fused = false;
+  return true;
+}
+
+std::string Compiler::usage() {
+  return "[-O0|-O1|-O2] [--fused] [-j <threads>] [--cache=<dir>] [--stats] "
+         "[--max-errors <n>] [--time-passes] [--print-after=<pass>] "
+         "[--line-table=<file>] [-o <file.tbc>]";
+}
+
+// Constructor
+Compiler::Compiler(const Options & options) :
+  Opts{options} {
+}
+
+int Compiler::compile(antlr4::ANTLRInputStream & input,
+                      std::ostream & out, std::ostream & err) {
+  return generate(input, nullptr, out, err);
+}
+
+int Compiler::compile(antlr4::ANTLRInputStream & input, code & program,
+                      std::ostream & out, std::ostream & err) {
+  return generate(input, &program, out, err);
+}
+
+int Compiler::generate(antlr4::ANTLRInputStream & input, code * program,
+                       std::ostream & out, std::ostream & err) {
+  // create a lexer that consumes the character stream and produce a token stream
+  StreamErrorListener errorListener(err, Opts.maxErrors);
+  AslLexer lexer(&input);
+  lexer.removeErrorListeners();
+  lexer.addErrorListener(&errorListener);
+  antlr4::CommonTokenStream tokens(&lexer);
+
+  // create a parser that consumes the token stream, and parses it.
+  // The tables of the parser (the ATN and the DFA cache) are shared
+  // by all the parsers, so they stay warm from one compilation to
+  // the next in the same process
+  AslParser parser(&tokens);
+  parser.removeErrorListeners();
+  parser.addErrorListener(&errorListener);
+
+  // call the parser and get the parse tree (none if it was cancelled)
+  AslParser::ProgramContext *tree = nullptr;
+  try {
+    tree = parser.program();
+  }
+  catch (antlr4::ParseCancellationException &) {
+  }
+
+  // check for lexical or syntactical errors
+  if (tree == nullptr or lexer.getNumberOfSyntaxErrors() > 0 or
+      parser.getNumberOfSyntaxErrors() > 0) {
+    out << "Lexical and/or syntactical errors have been found." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // print the parse tree (for debugging purposes)
+  // out << tree->toStringTree(&parser) << std::endl;
+
+  // Auxililary classes we are going to need to store information while
+  // traversing the tree. They are described below in this document
+  TypesMgr       types;
+  SymTable       symbols(types);
+  TreeDecoration decorations;
+  SemErrors      errors(out);
+  errors.setMaxErrors(Opts.maxErrors);
+
+  // create a walker that will traverse the tree and do several things,
+  // like checking variable types or generating code. It stops if the
+  // limit of semantic errors is reached
+  BoundedWalker walker(errors);
+
+  // Create a Listener that looks for variables and function declarations in the tree
+  // and stores required information
+  SymbolsListener symboldecl(types, symbols, decorations, errors);
+  // Create another Listener that will perform type checkings wherever it is needed
+  // (on expressions, assignments, parameter passing, etc)
+  TypeCheckListener typecheck(types, symbols, decorations, errors);
+  // Auxiliary class to store the code we will be creating
+  code mycode;
+  // Create a third listener that will generate code for each part of the tree
+  CodeGenListener codegenerator(types, symbols, decorations, mycode);
+
+  // The passes of the optimization level to run over the generated code
+  PassManager passes;
+  passes.addOptimizationPasses(Opts.optLevel);
+  passes.setTimePasses(Opts.timePasses);
+  if (Opts.printAfter != "") {
+    std::vector<std::string> names = passes.getPassNames();
+    if (std::find(names.begin(), names.end(), Opts.printAfter) == names.end())
+      err << "Warning: pass " << Opts.printAfter << " is not run at -O"
+          << Opts.optLevel << std::endl;
+    passes.setPrintAfter(Opts.printAfter);
+  }
+  bool passesOk = true;
+
+  // The text output is written function by function while the code is
+  // generated; the binary one (and the code given to the caller) needs
+  // the whole program to resolve calls.
+  // In fused mode a semantic error may still appear after some function
+  // has been generated, so the text is kept until the walk finishes
+  std::ostringstream fusedText;
+  std::ostream & textOutput = Opts.fused ? fusedText : out;
+  // Source position of each instruction, once the passes have run
+  std::ostringstream lineTable;
+  bool wholeProgram = (program != nullptr or Opts.outputFile != "");
+  std::function<void (subroutine &)> emitFunction = [&] (subroutine & subr) {
+    if (errors.getNumberOfSemanticErrors() > 0) return;
+    passesOk = passesOk and passes.run(subr, err);
+    // tvm reads the text form, which has no 'writes' nor 'copy'
+    subr.expand_for_tvm();
+    if (passesOk) subr.dump(textOutput);
+    if (passesOk and Opts.lineTable != "") writeLineTable(subr, lineTable);
+  };
+  if (not wholeProgram)
+    codegenerator.setFunctionEmitter(emitFunction);
+  // The functions generated apart from the codegenerator are received
+  // here in the order of the program
+  std::function<void (subroutine &)> receiveFunction = emitFunction;
+  if (wholeProgram)
+    receiveFunction = [&] (subroutine & subr) { mycode.add_subroutine(subr); };
+
+  // With a cache, only the functions that changed since they were
+  // stored there are type checked and generated
+  std::unique_ptr<CodeCache>          cache;
+  std::unique_ptr<IncrementalCodeGen> incremental;
+  if (Opts.cacheDir != "") {
+    cache.reset(new CodeCache(Opts.cacheDir));
+    incremental.reset(new IncrementalCodeGen(types, symbols, decorations,
+                                             errors, typecheck, *cache));
+  }
+  auto printStats = [&] () {
+    if (not Opts.stats) return;
+    if (cache) cache->printStats(err);
+    else err << "cache: not used (see --cache=<dir>)" << std::endl;
+  };
+
+  if (incremental) {
+    // Collect the declarations of the whole program, and then check the
+    // types of the functions that are not in the cache
+    walker.walk(&symboldecl, tree);
+    incremental->typeCheck(tree);
+  }
+  else if (not Opts.fused) {
+    // Traverse the tree using the first listener, to collect information
+    // about declared identifiers, and then using the second one, so all
+    // types are checked
+    walker.walk(&symboldecl, tree);
+    walker.walk(&typecheck, tree);
+  }
+  else {
+    // Declare the functions visiting only their headers, and then check
+    // the types and generate the code in a single traversal
+    symboldecl.declareFunctionHeaders(tree);
+    FusedListener fusedwalk(symboldecl, typecheck, codegenerator, errors);
+    walker.walk(&fusedwalk, tree);
+  }
+
+  if (errors.limitReached()) {
+    // the walk was stopped, so the errors have not been written yet
+    errors.print();
+    out << "Stopped after " << Opts.maxErrors << " errors." << std::endl;
+  }
+  if (errors.getNumberOfSemanticErrors() > 0) {
+    out << "There are semantic errors: no code generated." << std::endl;
+    printStats();
+    return EXIT_FAILURE;
+  }
+
+  // Traverse the tree using the code generator, so code is generated and stored in 'mycode'
+  if (incremental)
+    incremental->generate(tree, receiveFunction);
+  else if (not Opts.fused and Opts.jobs == 1)
+    walker.walk(&codegenerator, tree);
+  else if (not Opts.fused) {
+    // Generate the functions on 'jobs' threads (0: one per core)
+    ParallelCodeGen parallelgen(types, symbols, decorations, Opts.jobs);
+    parallelgen.generate(tree, receiveFunction);
+  }
+  else
+    out << fusedText.str();
+
+  if (program != nullptr) {
+    passesOk = passes.run(mycode, err);
+    if (passesOk) *program = mycode;
+  }
+  else if (Opts.outputFile != "") {
+    passesOk = passes.run(mycode, err);
+    if (passesOk and Opts.lineTable != "")
+      for (auto & subr : mycode.get_subroutines()) writeLineTable(subr, lineTable);
+    BinaryCode binary;
+    std::string error;
+    if (passesOk and (not binary.build(mycode, error) or not binary.save(Opts.outputFile))) {
+      out << "Cannot write " << Opts.outputFile
+          << (error.empty() ? "" : ": " + error) << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  else {
+    out << std::endl;
+  }
+  if (passesOk and Opts.lineTable != "" and program == nullptr) {
+    std::ofstream table(Opts.lineTable);
+    table << lineTable.str();
+    if (not table) {
+      out << "Cannot write " << Opts.lineTable << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  if (Opts.timePasses) passes.printReport(err);
+  printStats();
+  if (not passesOk) return EXIT_FAILURE;
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,100 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    Compiler - Compile an Asl program into t-code with the
+//               options of the asl command
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "antlr4-runtime.h"
+
+#include "../common/code.h"
+
+#include <string>
+#include <vector>
+#include <iostream>
+
+// using namespace std;
+
+
+//////////////////////////////////////////////////////////////////////
+// Class Compiler: compiles one Asl program with the options of the
+// asl command. All it writes goes to the streams given to compile:
+// the code, the semantic errors and the messages of asl to 'out',
+// and the syntax errors, the verifier and the reports of the passes
+// to 'err'. So it can be used by the asl command and by the compile
+// server, that runs several compilations at the same time (each
+// one in its own thread, with its own Arena).
+
+class Compiler {
+
+public:
+
+  // Options of a compilation
+  struct Options {
+    unsigned int optLevel   = 0;
+    bool         timePasses = false;
+    bool         fused      = false;
+    unsigned int jobs       = 1;
+    bool         stats      = false;
+    unsigned int maxErrors  = 0;      // 0: no limit
+    std::string  cacheDir;
+    std::string  printAfter;
+    std::string  outputFile;
+    std::string  lineTable;           // file for the source positions
+  };
+
+  // Read the options in args (the command line, without argv[0]).
+  // The first argument that is not an option is left in fileName.
+  // Returns false if there is some wrong argument
+  static bool parseOptions (const std::vector<std::string> & args,
+                            Options & options, std::string & fileName);
+  // Usage message of the options
+  static std::string usage ();
+
+  // Constructor
+  Compiler(const Options & options);
+
+  // Compile the program read from 'input'; returns the exit status
+  // of asl (EXIT_SUCCESS or EXIT_FAILURE)
+  int compile (antlr4::ANTLRInputStream & input,
+               std::ostream & out, std::ostream & err);
+  // The same, but the code (after the passes) is left in 'program'
+  // instead of being written. The options -o and --line-table are
+  // not used
+  int compile (antlr4::ANTLRInputStream & input, code & program,
+               std::ostream & out, std::ostream & err);
+
+private:
+
+  // Attributes
+  Options Opts;
+
+  // Compile, writing the code or leaving it in 'program' if not null
+  int generate (antlr4::ANTLRInputStream & input, code * program,
+                std::ostream & out, std::ostream & err);
+
+};  // class Compiler
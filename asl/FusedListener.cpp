@@ -0,0 +1,82 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    FusedListener - Walk the parser tree once to do the semantic
+//                    check and the code generation of Asl programs
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "FusedListener.h"
+
+#include "antlr4-runtime.h"
+
+#include "../common/SemErrors.h"
+#include "SymbolsListener.h"
+#include "TypeCheckListener.h"
+#include "CodeGenListener.h"
+
+// using namespace std;
+
+
+// Constructor
+FusedListener::FusedListener(SymbolsListener   & Symbols,
+                             TypeCheckListener & TypeCheck,
+                             CodeGenListener   & CodeGen,
+                             SemErrors         & Errors) :
+  Symbols{Symbols},
+  TypeCheck{TypeCheck},
+  CodeGen{CodeGen},
+  Errors{Errors} {
+}
+
+// The walker calls enterEveryRule and then the enter method of the
+// rule (that does nothing in this listener), so each listener is
+// given the node in the same way
+void FusedListener::enterEveryRule(antlr4::ParserRuleContext *ctx) {
+  Symbols.enterEveryRule(ctx);
+  ctx->enterRule(&Symbols);
+  TypeCheck.enterEveryRule(ctx);
+  ctx->enterRule(&TypeCheck);
+  if (generateCode(ctx)) {
+    CodeGen.enterEveryRule(ctx);
+    ctx->enterRule(&CodeGen);
+  }
+}
+
+void FusedListener::exitEveryRule(antlr4::ParserRuleContext *ctx) {
+  ctx->exitRule(&Symbols);
+  Symbols.exitEveryRule(ctx);
+  ctx->exitRule(&TypeCheck);
+  TypeCheck.exitEveryRule(ctx);
+  if (generateCode(ctx)) {
+    ctx->exitRule(&CodeGen);
+    CodeGen.exitEveryRule(ctx);
+  }
+}
+
+bool FusedListener::generateCode(antlr4::ParserRuleContext *ctx) const {
+  return (Errors.getNumberOfSemanticErrors() == 0 or
+          dynamic_cast<AslParser::ProgramContext *>(ctx) != nullptr or
+          dynamic_cast<AslParser::FunctionContext *>(ctx) != nullptr);
+}
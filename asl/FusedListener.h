@@ -0,0 +1,83 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    FusedListener - Walk the parser tree once to do the semantic
+//                    check and the code generation of Asl programs
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "antlr4-runtime.h"
+#include "AslBaseListener.h"
+
+#include "../common/SemErrors.h"
+#include "SymbolsListener.h"
+#include "TypeCheckListener.h"
+#include "CodeGenListener.h"
+
+// using namespace std;
+
+
+//////////////////////////////////////////////////////////////////////
+// Class FusedListener: derived from AslBaseListener.
+// Does the work of the SymbolsListener, the TypeCheckListener and the
+// CodeGenListener in a single walk of the parse tree: on entering a
+// node the three listeners enter it, in this order, and on exiting
+// it they exit it in the same order. So when a listener works on a
+// node, the listeners before it have already finished with the node
+// and its whole subtree, like in three separate walks.
+// The SymbolsListener must have declared the functions before the
+// walk (see SymbolsListener::declareFunctionHeaders), since the type
+// check of a call needs the functions declared later in the program.
+// The code generation stops as soon as a semantic error is found
+// (only the program and function nodes, that open and close the
+// subroutines, are still visited), and the generated code must then
+// be discarded.
+
+class FusedListener final : public AslBaseListener {
+
+public:
+
+  // Constructor
+  FusedListener(SymbolsListener   & Symbols,
+                TypeCheckListener & TypeCheck,
+                CodeGenListener   & CodeGen,
+                SemErrors         & Errors);
+
+  void enterEveryRule(antlr4::ParserRuleContext *ctx);
+  void exitEveryRule(antlr4::ParserRuleContext *ctx);
+
+private:
+
+  // Attributes
+  SymbolsListener   & Symbols;
+  TypeCheckListener & TypeCheck;
+  CodeGenListener   & CodeGen;
+  SemErrors         & Errors;
+
+  // Returns true if the CodeGenListener has to visit the node ctx
+  bool generateCode (antlr4::ParserRuleContext *ctx) const;
+
+};  // class FusedListener
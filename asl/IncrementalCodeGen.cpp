@@ -0,0 +1,155 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    IncrementalCodeGen - Check and generate only the functions
+//                         of an Asl program that have changed
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "IncrementalCodeGen.h"
+#include "TypeCheckListener.h"
+#include "CodeGenListener.h"
+#include "BoundedWalker.h"
+
+#include "antlr4-runtime.h"
+#include "tree/ParseTreeWalker.h"
+
+#include "../common/TypesMgr.h"
+#include "../common/SymTable.h"
+#include "../common/TreeDecoration.h"
+#include "../common/SemErrors.h"
+#include "../common/CodeCache.h"
+#include "../common/code.h"
+
+#include <string>
+#include <vector>
+#include <cstddef>    // std::size_t
+
+// using namespace std;
+
+
+// Constructor
+IncrementalCodeGen::IncrementalCodeGen(TypesMgr          & Types,
+                                       SymTable          & Symbols,
+                                       TreeDecoration    & Decorations,
+                                       SemErrors         & Errors,
+                                       TypeCheckListener & TypeCheck,
+                                       CodeCache         & Cache) :
+  Types{Types},
+  Symbols{Symbols},
+  Decorations{Decorations},
+  Errors{Errors},
+  TypeCheck{TypeCheck},
+  Cache{Cache} {
+}
+
+// The program node is entered and exited as in a whole walk (so the
+// global scope is open while the keys are computed, and the checks
+// on the whole program are done), but only the functions missing in
+// the cache are walked
+void IncrementalCodeGen::typeCheck(AslParser::ProgramContext *ctx) {
+  std::vector<AslParser::FunctionContext *> functions = ctx->function();
+  Keys.clear();
+  Cached.clear();
+  Found.clear();
+  TypeCheck.enterProgram(ctx);
+  for (auto f : functions) {
+    Keys.push_back(functionKey(f));
+    Cached.push_back(subroutine(f->ID(0)->getText()));
+    Found.push_back(Cache.lookup(Keys.back(), Cached.back()));
+    if (Found.back()) relocate(Cached.back(), f, true);
+  }
+  BoundedWalker walker(Errors);
+  for (std::size_t i = 0; i < functions.size(); ++i)
+    if (not Found[i]) walker.walk(&TypeCheck, functions[i]);
+  if (not Errors.limitReached()) TypeCheck.exitProgram(ctx);
+}
+
+void IncrementalCodeGen::generate(AslParser::ProgramContext *ctx,
+                                  std::function<void (subroutine &)> emit) {
+  std::vector<AslParser::FunctionContext *> functions = ctx->function();
+  antlr4::tree::ParseTreeWalker walker;
+  for (std::size_t i = 0; i < functions.size(); ++i) {
+    if (Found[i]) {
+      emit(Cached[i]);
+      continue;
+    }
+    code funcCode;
+    CodeGenListener codegen(Types, Symbols, Decorations, funcCode);
+    walker.walk(&codegen, functions[i]);
+    subroutine & subr = funcCode.get_last_subroutine();
+    // stored before 'emit' runs the passes on it
+    subroutine relative = subr;
+    relocate(relative, functions[i], false);
+    Cache.store(Keys[i], relative);
+    emit(subr);
+  }
+  Cached.clear();
+}
+
+std::string IncrementalCodeGen::functionKey(AslParser::FunctionContext *ctx) {
+  CodeCache::Key key;
+  antlr4::misc::Interval source(ctx->getStart()->getStartIndex(),
+                                ctx->getStop()->getStopIndex());
+  key.add(ctx->getStart()->getInputStream()->getText(source));
+  std::vector<std::string> callees;
+  collectCalls(ctx, callees);
+  for (auto & name : callees) {
+    SymTable::Binding b = Symbols.resolve(Symbols.lookupIdent(name));
+    key.add(name);
+    key.add(b.symClass == SymTable::FunctionClass ? Types.to_string(b.type) : "");
+  }
+  return key.str();
+}
+
+// Line 0 is an unknown position, so the first line of the function is
+// line 1. Only the columns of that line depend on where it starts
+void IncrementalCodeGen::relocate(subroutine & subr, AslParser::FunctionContext *ctx,
+                                  bool absolute) {
+  unsigned int line = ctx->getStart()->getLine() - 1;
+  unsigned int column = ctx->getStart()->getCharPositionInLine();
+  instructionList lins = subr.get_instructions();
+  for (auto & inst : lins) {
+    if (inst.line == 0) continue;
+    if (absolute) {
+      if (inst.line == 1) inst.column += column;
+      inst.line += line;
+    }
+    else {
+      inst.line -= line;
+      if (inst.line == 1) inst.column -= column;
+    }
+  }
+  subr.set_instructions(lins);
+}
+
+void IncrementalCodeGen::collectCalls(antlr4::tree::ParseTree *t,
+                                      std::vector<std::string> & names) {
+  if (auto call = dynamic_cast<AslParser::CallfunctionContext *>(t))
+    names.push_back(call->ID()->getText());
+  else if (auto call = dynamic_cast<AslParser::CallfunctionStmtContext *>(t))
+    names.push_back(call->ID()->getText());
+  for (auto child : t->children)
+    collectCalls(child, names);
+}
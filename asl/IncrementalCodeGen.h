@@ -0,0 +1,109 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    IncrementalCodeGen - Check and generate only the functions
+//                         of an Asl program that have changed
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "antlr4-runtime.h"
+#include "AslParser.h"
+
+#include "../common/TypesMgr.h"
+#include "../common/SymTable.h"
+#include "../common/TreeDecoration.h"
+#include "../common/SemErrors.h"
+#include "../common/CodeCache.h"
+#include "../common/code.h"
+#include "TypeCheckListener.h"
+
+#include <string>
+#include <vector>
+#include <functional>
+
+// using namespace std;
+
+
+//////////////////////////////////////////////////////////////////////
+// Class IncrementalCodeGen: does the type check and the code
+// generation of a program (once the SymbolsListener has visited it)
+// using a CodeCache. The key of each function hashes its source
+// text and the name and type of every function it calls, so any
+// change in the function or in the signature of a callee gives it a
+// new key. The cached positions are relative to the start of the
+// function, so moving it in the file keeps its entry. The functions
+// found in the cache are neither type checked nor generated: their
+// code is taken from the cache. The rest are visited as usual by the
+// TypeCheckListener and then, if there are no semantic errors, by a
+// CodeGenListener, and their code is added to the cache.
+
+class IncrementalCodeGen {
+
+public:
+
+  // Constructor
+  IncrementalCodeGen(TypesMgr          & Types,
+                     SymTable          & Symbols,
+                     TreeDecoration    & Decorations,
+                     SemErrors         & Errors,
+                     TypeCheckListener & TypeCheck,
+                     CodeCache         & Cache);
+
+  // Look up every function in the cache and type check the ones
+  // that are not there
+  void typeCheck (AslParser::ProgramContext *ctx);
+
+  // Generate the code of the functions not found in the cache, and
+  // call 'emit' with every subroutine, in the order of the program
+  void generate (AslParser::ProgramContext *ctx,
+                 std::function<void (subroutine &)> emit);
+
+private:
+
+  // Attributes
+  TypesMgr          & Types;
+  SymTable          & Symbols;
+  TreeDecoration    & Decorations;
+  SemErrors         & Errors;
+  TypeCheckListener & TypeCheck;
+  CodeCache         & Cache;
+
+  // Key and cached code (if Found[i]) of each function
+  std::vector<std::string> Keys;
+  std::vector<subroutine>  Cached;
+  std::vector<bool>        Found;
+
+  // Key of a function: its text and the signatures of the callees
+  std::string functionKey (AslParser::FunctionContext *ctx);
+  // Names of the functions called in the subtree of t
+  static void collectCalls (antlr4::tree::ParseTree *t,
+                            std::vector<std::string> & names);
+  // Make the source positions of subr relative to the start of the
+  // function ctx, or (with 'absolute') turn them back
+  static void relocate (subroutine & subr, AslParser::FunctionContext *ctx,
+                        bool absolute);
+
+};  // class IncrementalCodeGen
@@ -0,0 +1,129 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    ParallelCodeGen - Generate the code of the functions of an
+//                      Asl program on several threads
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "ParallelCodeGen.h"
+#include "CodeGenListener.h"
+
+#include "antlr4-runtime.h"
+#include "tree/ParseTreeWalker.h"
+
+#include "../common/TypesMgr.h"
+#include "../common/SymTable.h"
+#include "../common/TreeDecoration.h"
+#include "../common/code.h"
+#include "../common/Arena.h"
+
+#include <vector>
+#include <thread>
+#include <algorithm>  // std::min
+#include <cstddef>    // std::size_t
+
+// using namespace std;
+
+
+// Constructor
+ParallelCodeGen::ParallelCodeGen(TypesMgr       & Types,
+                                 SymTable       & Symbols,
+                                 TreeDecoration & Decorations,
+                                 unsigned int     numThreads) :
+  Types{Types},
+  Symbols{Symbols},
+  Decorations{Decorations},
+  NumThreads{numThreads} {
+  if (NumThreads == 0) NumThreads = std::thread::hardware_concurrency();
+  if (NumThreads == 0) NumThreads = 1;
+}
+
+unsigned int ParallelCodeGen::getNumThreads() const {
+  return NumThreads;
+}
+
+void ParallelCodeGen::generate(AslParser::ProgramContext *ctx,
+                               std::function<void (subroutine &)> emit) {
+  std::vector<AslParser::FunctionContext *> functions = ctx->function();
+  Results.assign(functions.size(), nullptr);
+  Done.assign(functions.size(), false);
+
+  std::size_t next = 0;
+  std::vector<std::thread> pool;
+  unsigned int numWorkers = std::min<std::size_t>(NumThreads, functions.size());
+  for (unsigned int t = 0; t < numWorkers; ++t)
+    pool.push_back(std::thread(&ParallelCodeGen::worker, this,
+                               std::cref(functions), std::ref(next)));
+
+  // Hand over the subroutines in order, while the rest are generated
+  for (std::size_t i = 0; i < functions.size(); ++i) {
+    subroutine * subr;
+    {
+      std::unique_lock<std::mutex> lock(Mutex);
+      Ready.wait(lock, [&] { return Done[i]; });
+      subr = Results[i];
+      Results[i] = nullptr;
+    }
+    emit(*subr);
+    delete subr;
+  }
+  for (auto & t : pool) t.join();
+}
+
+// The attributes and the code of the function are allocated in an
+// arena of its own. The subroutine is then copied out of it while
+// the thread has no current arena, so the copy comes from the heap
+// and can be freed by the thread that receives it
+subroutine * ParallelCodeGen::generateFunction(AslParser::FunctionContext *ctx) {
+  Arena arena;
+  code  funcCode;
+  {
+    Arena::Use useArena(arena);
+    TreeDecoration  generated;
+    CodeGenListener codegen(Types, Symbols, Decorations, generated, funcCode);
+    antlr4::tree::ParseTreeWalker walker;
+    walker.walk(&codegen, ctx);
+  }
+  return new subroutine(funcCode.get_last_subroutine());
+}
+
+void ParallelCodeGen::worker(const std::vector<AslParser::FunctionContext *> & functions,
+                             std::size_t & next) {
+  while (true) {
+    std::size_t i;
+    {
+      std::lock_guard<std::mutex> lock(Mutex);
+      if (next == functions.size()) return;
+      i = next++;
+    }
+    subroutine * subr = generateFunction(functions[i]);
+    {
+      std::lock_guard<std::mutex> lock(Mutex);
+      Results[i] = subr;
+      Done[i] = true;
+    }
+    Ready.notify_one();
+  }
+}
@@ -0,0 +1,101 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    ParallelCodeGen - Generate the code of the functions of an
+//                      Asl program on several threads
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "antlr4-runtime.h"
+#include "AslParser.h"
+
+#include "../common/TypesMgr.h"
+#include "../common/SymTable.h"
+#include "../common/TreeDecoration.h"
+#include "../common/code.h"
+
+#include <vector>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>    // std::size_t
+
+// using namespace std;
+
+
+//////////////////////////////////////////////////////////////////////
+// Class ParallelCodeGen: generates the code of the functions of a
+// program (once the SymbolsListener and the TypeCheckListener have
+// finished with no semantic errors) on a pool of threads. Each thread
+// takes the next function not yet generated and walks its subtree
+// with a CodeGenListener of its own, that only reads the shared tree
+// decorations and the symbol table, and keeps the attributes it
+// computes in a TreeDecoration of the function. The subroutines are
+// handed over in the order of the program, as soon as all the ones
+// before them are done, so the result does not depend on the number
+// of threads nor on how the work was split.
+
+class ParallelCodeGen {
+
+public:
+
+  // Constructor (numThreads == 0 means one thread per core)
+  ParallelCodeGen(TypesMgr       & Types,
+                  SymTable       & Symbols,
+                  TreeDecoration & Decorations,
+                  unsigned int     numThreads);
+
+  // Generate the code of every function of the program; 'emit' is
+  // called (in the calling thread) with each subroutine, in order
+  void generate (AslParser::ProgramContext *ctx,
+                 std::function<void (subroutine &)> emit);
+
+  // Number of threads used to generate the code
+  unsigned int getNumThreads () const;
+
+private:
+
+  // Attributes
+  TypesMgr       & Types;
+  SymTable       & Symbols;
+  TreeDecoration & Decorations;
+  unsigned int     NumThreads;
+
+  // Subroutines generated and not yet handed over (Done[i] tells if
+  // Results[i] is ready), guarded by Mutex
+  std::vector<subroutine *> Results;
+  std::vector<bool>         Done;
+  std::mutex                Mutex;
+  std::condition_variable   Ready;
+
+  // Generate the code of one function
+  subroutine * generateFunction (AslParser::FunctionContext *ctx);
+
+  // Work of each thread: take the next function until there are none
+  void worker (const std::vector<AslParser::FunctionContext *> & functions,
+               std::size_t & next);
+
+};  // class ParallelCodeGen
@@ -62,8 +62,25 @@ SymbolsListener::SymbolsListener(TypesMgr       & Types,
 
 
 
+void SymbolsListener::declareFunctionHeaders(AslParser::ProgramContext *ctx) {
+  SymTable::ScopeId sc = Symbols.pushNewScope("$global$");
+  putScopeDecor(ctx, sc);
+  for (auto fctx : ctx->function()) {
+    declareFunction(fctx);
+    Symbols.popScope();
+    VisibleFunctions.push_back(NumFunctions);
+  }
+  Symbols.popScope();
+  HeadersDeclared = true;
+  NextFunction = 0;
+}
+
 void SymbolsListener::enterProgram(AslParser::ProgramContext *ctx) {
   DEBUG_ENTER();
+  if (HeadersDeclared) {
+    Symbols.pushThisScope(getScopeDecor(ctx));
+    return;
+  }
   SymTable::ScopeId sc = Symbols.pushNewScope("$global$");
   putScopeDecor(ctx, sc);
 }
@@ -124,6 +141,15 @@ TypesMgr::TypeId SymbolsListener::ReturnType(AslParser::FunctionContext *ctx, bo
 
 void SymbolsListener::enterFunction(AslParser::FunctionContext *ctx) {
   DEBUG_ENTER();
+  if (HeadersDeclared) {
+    Symbols.pushThisScope(getScopeDecor(ctx));
+    VisibleNow = VisibleFunctions[NextFunction++];
+    return;
+  }
+  declareFunction(ctx);
+}
+
+void SymbolsListener::declareFunction(AslParser::FunctionContext *ctx) {
   std::string ident = ctx->ID(0)->getText();
   std::vector<std::string> names;
   if (Symbols.findInStack(ident) > -1) 
@@ -148,12 +174,14 @@ void SymbolsListener::enterFunction(AslParser::FunctionContext *ctx) {
         TypesMgr::TypeId t =  ReturnType(ctx, true,0); 
         TypesMgr::TypeId tFunc = Types.createFunctionTy(lParamsTy, t); 
         Symbols.addFunction(ident, tFunc);
+        ++NumFunctions;
         putTypeDecor(ctx,tFunc);
     }
     else {
       TypesMgr::TypeId tRet = Types.createVoidTy();
       TypesMgr::TypeId tFunc = Types.createFunctionTy(lParamsTy, tRet); 
       Symbols.addFunction(ident, tFunc);
+      ++NumFunctions;
       putTypeDecor(ctx,tFunc);
     }
     
@@ -264,7 +292,7 @@ void SymbolsListener::enterCallfunctionStmt(AslParser::CallfunctionStmtContext *
 }
 void SymbolsListener::exitCallfunctionStmt(AslParser::CallfunctionStmtContext *ctx) {
   std::string ident = ctx->ID()->getText();
-  TypesMgr::TypeId t1 = Symbols.getType(ident);
+  TypesMgr::TypeId t1 = visibleType(ident);
   putTypeDecor(ctx, t1);
   DEBUG_EXIT();  
 }
@@ -274,7 +302,7 @@ void SymbolsListener::enterCallfunction(AslParser::CallfunctionContext *ctx) {
 }
 void SymbolsListener::exitCallfunction(AslParser::CallfunctionContext *ctx) {
   std::string ident = ctx->ID()->getText();
-  TypesMgr::TypeId t1 = Symbols.getType(ident);
+  TypesMgr::TypeId t1 = visibleType(ident);
   putTypeDecor(ctx, t1);
   t1 = getTypeDecor(ctx);
   DEBUG_EXIT();
@@ -306,7 +334,7 @@ void SymbolsListener::exitWriteString(AslParser::WriteStringContext *ctx) {
 
 void SymbolsListener::enterLeft_expr(AslParser::Left_exprContext *ctx) {
   std::string ident = ctx->ID()->getText();
-  if (Symbols.findInStack(ident) == -1) {
+  if (not isVisible(ident)) {
     Errors.undeclaredIdent(ctx->ID());
   }
   DEBUG_ENTER();
@@ -335,7 +363,7 @@ void SymbolsListener::enterAtom(AslParser::AtomContext *ctx){
 void SymbolsListener::exitAtom(AslParser::AtomContext *ctx){
     if(ctx->ID() != NULL) {
     std::string ident = ctx->ID()->getText();
-    if(Symbols.findInStack(ident) <= -1) {
+    if(not isVisible(ident)) {
         Errors.undeclaredIdent(ctx->ID());
     }
   }
@@ -348,9 +376,8 @@ void SymbolsListener::enterArrayvalue(AslParser::ArrayvalueContext *ctx){
 
 void SymbolsListener::exitArrayvalue(AslParser::ArrayvalueContext *ctx) {
   std::string ident = ctx->ID()->getText();
-  TypesMgr::TypeId t1 = Symbols.getType(ident);
   
-  if(Symbols.findInStack(ident) == -1){
+  if(not isVisible(ident)){
       Errors.undeclaredIdent(ctx->ID());
   }
   DEBUG_EXIT();
@@ -390,6 +417,23 @@ void SymbolsListener::exitIdent(AslParser::IdentContext *ctx) {
 // void SymbolsListener::visitErrorNode(antlr4::tree::ErrorNode *node) {
 // }
 
+// Visibility of the identifiers. In fused mode all the functions
+// are already in the global scope, but only the ones declared up
+// to the current function header would be found by a separate walk
+bool SymbolsListener::isVisible(const std::string & ident) {
+  if (Symbols.findInStack(ident) == -1)
+    return false;
+  if (not HeadersDeclared or Symbols.findInCurrentScope(ident))
+    return true;
+  return Symbols.resolve(Symbols.lookupIdent(ident)).slot < VisibleNow;
+}
+
+TypesMgr::TypeId SymbolsListener::visibleType(const std::string & ident) {
+  if (not isVisible(ident))
+    return Types.createErrorTy();
+  return Symbols.getType(ident);
+}
+
 // Getters for the necessary tree node atributes:
 //   Scope and Type
 SymTable::ScopeId SymbolsListener::getScopeDecor(antlr4::ParserRuleContext *ctx) {
@@ -37,6 +37,11 @@
 #include "../common/TreeDecoration.h"
 #include "../common/SemErrors.h"
 
+#include <string>
+#include <vector>
+
+#include <cstddef>    // std::size_t
+
 // using namespace std;
 
 
@@ -57,6 +62,14 @@ public:
 		  TreeDecoration & TreeNodeProps,
 		  SemErrors      & Errors);
 
+  // Fused mode: declares all the functions of the program (and
+  // their parameters) visiting only the function headers. Then the
+  // listener must be used in the same walk as the TypeCheckListener
+  // (see FusedListener); it only adds the local variables, and keeps
+  // hidden the functions declared after the one being visited, just
+  // like in a separate walk
+  void declareFunctionHeaders(AslParser::ProgramContext *ctx);
+
   void enterProgram(AslParser::ProgramContext *ctx);
   void exitProgram(AslParser::ProgramContext *ctx);
 
@@ -146,6 +159,23 @@ private:
   TreeDecoration & Decorations;
   SemErrors      & Errors;
   bool Function_error;
+  //   - fused mode: functions already declared by declareFunctionHeaders
+  bool                     HeadersDeclared = false;
+  //   - number of functions added to the global scope
+  std::size_t              NumFunctions = 0;
+  //   - for each function, the number of functions declared up to its header
+  std::vector<std::size_t> VisibleFunctions;
+  std::size_t              NextFunction = 0;
+  std::size_t              VisibleNow = 0;
+
+  // Adds the function to the global scope, creates its scope and
+  // adds its parameters. The scope of the function is left pushed
+  void declareFunction (AslParser::FunctionContext *ctx);
+
+  // Returns true if ident is declared at this point of the program,
+  // and its type ('error' if not)
+  bool             isVisible   (const std::string & ident);
+  TypesMgr::TypeId visibleType (const std::string & ident);
 
   // Getters for the necessary tree node atributes:
   //   Scope and Type
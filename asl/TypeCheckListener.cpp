@@ -72,6 +72,8 @@ void TypeCheckListener::exitProgram(AslParser::ProgramContext *ctx) {
 
 void TypeCheckListener::enterFunction(AslParser::FunctionContext *ctx) {
   DEBUG_ENTER();
+  // the errors of the previous lines can already be written
+  Errors.flush(ctx->getStart()->getLine());
   SymTable::ScopeId sc = getScopeDecor(ctx);
   Symbols.pushThisScope(sc);
   
@@ -165,10 +167,10 @@ void TypeCheckListener::enterCallfunctionStmt(AslParser::CallfunctionStmtContext
 }
 
 void TypeCheckListener::exitCallfunctionStmt(AslParser::CallfunctionStmtContext *ctx) {
-    std::string ident = ctx->ID()->getText();
-    TypesMgr::TypeId t1 = Symbols.getType(ident);
+    SymTable::Binding ident = resolveIdent(ctx, ctx->ID());
+    TypesMgr::TypeId t1 = ident.type;
     
-    if(Symbols.findInStack(ident) == -1) {
+    if(ident.depth == -1) {
       Errors.undeclaredIdent(ctx->ID());
     }
   
@@ -227,8 +229,8 @@ void TypeCheckListener::enterLeft_expr(AslParser::Left_exprContext *ctx) {
   DEBUG_ENTER();
 }
 void TypeCheckListener::exitLeft_expr(AslParser::Left_exprContext *ctx) {
-  std::string ident = ctx->ID()->getText();
-  TypesMgr::TypeId t1 = Symbols.getType(ident);
+  SymTable::Binding ident = resolveIdent(ctx, ctx->ID());
+  TypesMgr::TypeId t1 = ident.type;
   int error = 0;
   if(ctx->expr() != NULL and not Types.isErrorTy(t1)) 
   {
@@ -368,10 +370,10 @@ void TypeCheckListener::enterCallfunction(AslParser::CallfunctionContext *ctx) {
   DEBUG_ENTER();
 }
 void TypeCheckListener::exitCallfunction(AslParser::CallfunctionContext *ctx) {
-  std::string ident = ctx->ID()->getText();
-  TypesMgr::TypeId t1 = Symbols.getType(ident);
+  SymTable::Binding ident = resolveIdent(ctx, ctx->ID());
+  TypesMgr::TypeId t1 = ident.type;
   
-  if(Symbols.findInStack(ident) == -1) {
+  if(ident.depth == -1) {
       Errors.undeclaredIdent(ctx->ID());
   }
 
@@ -461,8 +463,8 @@ void TypeCheckListener::enterArrayvalue(AslParser::ArrayvalueContext *ctx) {
   
 
 void TypeCheckListener::exitArrayvalue(AslParser::ArrayvalueContext *ctx) {
-  std::string ident = ctx->ID()->getText();
-  TypesMgr::TypeId t1 = Symbols.getType(ident);
+  SymTable::Binding ident = resolveIdent(ctx, ctx->ID());
+  TypesMgr::TypeId t1 = ident.type;
   
   if(!Types.isArrayTy(t1) and not Types.isErrorTy(t1)) {
     Errors.nonArrayInArrayAccess(ctx);
@@ -491,9 +493,9 @@ void TypeCheckListener::enterAtom(AslParser::AtomContext *ctx) {
 
 void TypeCheckListener::exitAtom(AslParser::AtomContext *ctx) {
   if(ctx->ID() != NULL) {
-    std::string ident = ctx->ID()->getText();
-    if(Symbols.findInStack(ident) > -1) {
-      TypesMgr::TypeId t1 = Symbols.getType(ident);
+    SymTable::Binding ident = resolveIdent(ctx, ctx->ID());
+    if(ident.depth > -1) {
+      TypesMgr::TypeId t1 = ident.type;
       putTypeDecor(ctx, t1);
       t1 = getTypeDecor(ctx);
     }
@@ -545,3 +547,14 @@ void TypeCheckListener::putTypeDecor(antlr4::ParserRuleContext *ctx, TypesMgr::T
 void TypeCheckListener::putIsLValueDecor(antlr4::ParserRuleContext *ctx, bool b) {
   Decorations.putIsLValue(ctx, b);
 }
+void TypeCheckListener::putBindingDecor(antlr4::ParserRuleContext *ctx, const SymTable::Binding & b) {
+  Decorations.putBinding(ctx, b);
+}
+
+// Resolution of the identifiers
+SymTable::Binding TypeCheckListener::resolveIdent(antlr4::ParserRuleContext *ctx,
+                                                  antlr4::tree::TerminalNode *id) {
+  SymTable::Binding b = Symbols.resolve(Symbols.lookupIdent(id->getText()));
+  putBindingDecor(ctx, b);
+  return b;
+}
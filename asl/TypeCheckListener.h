@@ -166,9 +166,15 @@ private:
   bool              getIsLValueDecor (antlr4::ParserRuleContext *ctx);
 
   // Setters for the necessary tree node attributes:
-  //   Scope, Type ans IsLValue
+  //   Scope, Type, IsLValue and Binding
   void putScopeDecor    (antlr4::ParserRuleContext *ctx, SymTable::ScopeId s);
   void putTypeDecor     (antlr4::ParserRuleContext *ctx, TypesMgr::TypeId t);
   void putIsLValueDecor (antlr4::ParserRuleContext *ctx, bool b);
+  void putBindingDecor  (antlr4::ParserRuleContext *ctx, const SymTable::Binding & b);
+
+  // Resolves the identifier used in the node ctx and keeps the result
+  // as its Binding attribute, so it is not searched again later
+  SymTable::Binding resolveIdent (antlr4::ParserRuleContext *ctx,
+                                  antlr4::tree::TerminalNode *id);
 
 };  // class TypeCheckListener
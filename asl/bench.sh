@@ -0,0 +1,59 @@
+#!/bin/bash
+# Times the code generation of asl on a large program: bench/program.sh
+# writes FUNCTIONS functions (10000 by default) of STATEMENTS statements
+# (40), which are compiled to t-code and to binary t-code (-o) with
+# -j 1, 2 and 4. It prints the best of RUNS runs of each compilation
+# for every asl given (./asl by default), so that two builds can be
+# compared:
+#     ./bench.sh ./asl /tmp/old/asl
+# The output of an asl must not depend on -j, and it is checked.
+
+cd "$(dirname "$0")"
+RUNS=${RUNS:-3}
+FUNCTIONS=${FUNCTIONS:-10000}
+STATEMENTS=${STATEMENTS:-40}
+ASLS=("$@")
+[ ${#ASLS[@]} -eq 0 ] && ASLS=(./asl)
+
+dir=$(mktemp -d)
+trap 'rm -rf "$dir"' EXIT
+bench/program.sh $FUNCTIONS $STATEMENTS > "$dir/program.asl" || exit 1
+
+# best wall time of RUNS runs of a command, in ms
+best() {
+    local b=
+    for r in $(seq $RUNS); do
+        local t0=$(date +%s%N)
+        "$@" > /dev/null || return 1
+        local t=$((($(date +%s%N) - t0) / 1000000))
+        [ -z "$b" ] || [ $t -lt $b ] && b=$t
+    done
+    echo $b
+}
+# a compilation by an asl (1) with -j (2) to t-code, kept in the
+# file (3)
+text() {
+    "$1" -j $2 "$dir/program.asl" > "$3"
+}
+# the same, to binary t-code
+binary() {
+    "$1" -j $2 -o "$3" "$dir/program.asl"
+}
+report() {
+    local name=$1 asl=$2 t
+    shift 2
+    t=$(best "$@") && t="$t ms" || t=failed
+    printf "%-24s %-20s %11s\n" "$name" "$asl" "$t"
+}
+
+echo "$FUNCTIONS functions of $STATEMENTS statements, $(nproc) cores:"
+for asl in "${ASLS[@]}"; do
+    for j in 1 2 4; do
+        report "  -j $j" "$asl" text "$asl" $j "$dir/$j.t"
+        report "  -j $j -o" "$asl" binary "$asl" $j "$dir/$j.tbc"
+    done
+    for j in 2 4; do
+        cmp -s "$dir/1.t" "$dir/$j.t" && cmp -s "$dir/1.tbc" "$dir/$j.tbc" ||
+            echo "$asl: the output of -j $j is not the one of -j 1"
+    done
+done
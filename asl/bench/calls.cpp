@@ -0,0 +1,111 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    Calls benchmark - Throughput of a host program calling an
+//                      Asl function through libasl.a
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "../AslLibrary.h"
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+
+#include <cstdlib>    // std::atol, EXIT_SUCCESS
+#include <cstdint>    // std::int32_t
+
+// using namespace std;
+
+
+// The function called: a few instructions, so the time measured is
+// mostly the cost of a call from the host
+static const char *Source = R"(func poly(x: int, y: int) : int
+    return x*x + 3*y + 1;
+endfunc
+
+func main()
+endfunc
+)";
+
+// Usage: ./calls [<calls> [<threads>]]
+//   Calls poly(i % 1000, i % 7) for i in 0 .. calls-1 (1M by default)
+//   from the given threads (1 by default), each one with its own
+//   AslInstance of the same AslProgram.
+int main(int argc, const char* argv[]) {
+  long calls = (argc > 1 ? std::atol(argv[1]) : 1000000);
+  long threads = (argc > 2 ? std::atol(argv[2]) : 1);
+  if (calls <= 0 or threads <= 0) {
+    std::cerr << "Usage: ./calls [<calls> [<threads>]]" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  AslProgram program;
+  std::string errors;
+  if (not program.compile(Source, errors, 2)) {
+    std::cerr << errors;
+    return EXIT_FAILURE;
+  }
+
+  std::atomic<long long> sum(0);
+  std::atomic<bool> failed(false);
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> workers;
+  for (long t = 0; t < threads; ++t)
+    workers.emplace_back([&, t] {
+      AslInstance vm(program);
+      std::vector<vmachine::Value> args(2);
+      vmachine::Value result;
+      long long partial = 0;
+      for (long i = t; i < calls; i += threads) {
+        args[0] = vmachine::Value(std::int32_t(i % 1000));
+        args[1] = vmachine::Value(std::int32_t(i % 7));
+        if (not vm.call("poly", args, result)) {
+          std::cerr << vm.getError() << std::endl;
+          failed = true;
+          return;
+        }
+        partial += result.as_int();
+      }
+      sum += partial;
+    });
+  for (auto & w : workers) w.join();
+  double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  if (failed) return EXIT_FAILURE;
+
+  // the results are checked, so that the calls can not be skipped
+  long long expected = 0;
+  for (long i = 0; i < calls; ++i)
+    expected += (i % 1000) * (i % 1000) + 3 * (i % 7) + 1;
+  if (sum != expected) {
+    std::cerr << "wrong results: " << sum << " instead of " << expected << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::cout << calls << " calls of poly, " << threads << " threads: " << ms << " ms, "
+            << 1000 * ms / calls << " us/call" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,27 @@
+#!/bin/bash
+# Writes an Asl program to time the code generation of asl (see
+# ../bench.sh): FUNCTIONS functions (10000 by default, the first
+# argument) of about STATEMENTS statements each (40 by default, the
+# second one). Each function fills a local array in a loop, updates
+# a sum with assignments and ifs, and calls the function before it.
+#     ./program.sh 10000 40 > big.asl
+
+awk -v functions="${1:-10000}" -v statements="${2:-40}" 'BEGIN {
+    for (k = 0; k < functions; ++k) {
+        printf "func f%d(a: array[10] of int, n: int) : int\n", k
+        printf "  var i, s: int\n  var v: array[10] of int\n"
+        printf "  i = 0;\n  s = n;\n"
+        printf "  while i < 10 do\n    v[i] = a[i] * i + n;\n    i = i + 1;\n  endwhile\n"
+        for (j = 6; j < statements; ++j) {
+            if (j % 4 == 0)
+                printf "  if s < %d then\n    s = s + v[%d];\n  else\n    s = s - %d;\n  endif\n", j * k, j % 10, j
+            else
+                printf "  s = s + v[%d] * %d;\n", j % 10, j
+        }
+        if (k > 0) printf "  s = f%d(v, s);\n", k - 1
+        printf "  return s;\nendfunc\n\n"
+    }
+    printf "func main()\n  var a: array[10] of int\n  var i: int\n"
+    printf "  i = 0;\n  while i < 10 do\n    read a[i];\n    i = i + 1;\n  endwhile\n"
+    printf "  write f%d(a, 1);\n  write \"\\n\";\nendfunc\n", functions - 1
+}'
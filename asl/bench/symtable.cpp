@@ -0,0 +1,229 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    SymTable benchmark - Time of building the scopes of a large
+//                         program and of looking its symbols up
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "../../common/TypesMgr.h"
+#include "../../common/SymTable.h"
+
+#include <map>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <iostream>
+
+#include <cstdlib>    // std::atoi, EXIT_SUCCESS
+
+// using namespace std;
+
+
+// Milliseconds since 'start'
+static double elapsed(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// The scopes as SymTable kept them before the identifiers were
+// interned, as the baseline: a std::map from the name to the symbol
+// in each scope, and every lookup walks the stack finding the name
+// in the map of each scope (twice in the scope that has it)
+class MapSymTable {
+public:
+  typedef std::size_t ScopeId;
+
+  MapSymTable(TypesMgr & Types) : Types(Types) { }
+
+  ScopeId pushNewScope(const std::string & name) {
+    ScopesVec.push_back(ScopeInfo{name, {}, {}});
+    ScopeIdsStack.push_back(ScopesVec.size() - 1);
+    return ScopesVec.size() - 1;
+  }
+  void popScope() { ScopeIdsStack.pop_back(); }
+  void pushThisScope(ScopeId sc) { ScopeIdsStack.push_back(sc); }
+
+  void addLocalVar  (const std::string & ident, TypesMgr::TypeId type) { add(ident, LocalVarId, type); }
+  void addParameter (const std::string & ident, TypesMgr::TypeId type) { add(ident, ParameterId, type); }
+  void addFunction  (const std::string & ident, TypesMgr::TypeId type) { add(ident, FunctionId, type); }
+
+  int findInStack(const std::string & ident) const {
+    int d = 0;
+    for (int i = ScopeIdsStack.size() - 1; i >= 0; --i) {
+      if (ScopesVec[ScopeIdsStack[i]].SymbolsMap.count(ident))
+        return d;
+      ++d;
+    }
+    return -1;
+  }
+  bool isParameterClass(const std::string & ident) const { return symbolClass(ident) == ParameterId; }
+  bool isFunctionClass (const std::string & ident) const { return symbolClass(ident) == FunctionId; }
+  TypesMgr::TypeId getType(const std::string & ident) const {
+    for (int i = ScopeIdsStack.size() - 1; i >= 0; --i) {
+      const ScopeInfo & scope = ScopesVec[ScopeIdsStack[i]];
+      if (scope.SymbolsMap.count(ident))
+        return scope.SymbolsMap.find(ident)->second.type;
+    }
+    return Types.createErrorTy();
+  }
+
+private:
+  enum SymClassId {ErrorClassId = -1, LocalVarId, ParameterId, FunctionId};
+  struct SymbolInfo {
+    SymClassId       classId;
+    TypesMgr::TypeId type;
+  };
+  struct ScopeInfo {
+    std::string                       name;
+    std::map<std::string, SymbolInfo> SymbolsMap;
+    std::vector<std::string>          IdentsList;   // in the order of declaration
+  };
+
+  void add(const std::string & ident, SymClassId c, TypesMgr::TypeId type) {
+    ScopeInfo & scope = ScopesVec[ScopeIdsStack.back()];
+    scope.SymbolsMap[ident] = SymbolInfo{c, type};
+    scope.IdentsList.push_back(ident);
+  }
+  SymClassId symbolClass(const std::string & ident) const {
+    for (int i = ScopeIdsStack.size() - 1; i >= 0; --i) {
+      const ScopeInfo & scope = ScopesVec[ScopeIdsStack[i]];
+      if (scope.SymbolsMap.count(ident))
+        return scope.SymbolsMap.find(ident)->second.classId;
+    }
+    return ErrorClassId;
+  }
+
+  TypesMgr               & Types;
+  std::vector<ScopeInfo>   ScopesVec;
+  std::vector<ScopeId>     ScopeIdsStack;
+};
+
+// The scopes of a program in Symbols: a global one with the functions,
+// and one per function with a param and the locals
+template <class Table>
+static std::vector<typename Table::ScopeId> declare(Table & Symbols,
+                                                    const std::vector<std::string> & functions,
+                                                    const std::vector<std::string> & locals,
+                                                    TypesMgr::TypeId intTy, TypesMgr::TypeId funcTy) {
+  Symbols.pushNewScope("$global$");
+  for (auto & name : functions) Symbols.addFunction(name, funcTy);
+  std::vector<typename Table::ScopeId> scopes;
+  for (auto & name : functions) {
+    scopes.push_back(Symbols.pushNewScope(name));
+    Symbols.addParameter("p", intTy);
+    for (auto & l : locals) Symbols.addLocalVar(l, intTy);
+    Symbols.popScope();
+  }
+  return scopes;
+}
+
+// The lookups by name in the scope of each function of Symbols. The
+// sum keeps them from being optimized away, and must be the same with
+// every table and interface
+template <class Table>
+static long long lookupNames(Table & Symbols, const std::vector<typename Table::ScopeId> & scopes,
+                             const std::vector<std::string> & functions,
+                             const std::vector<std::string> & locals, int rounds) {
+  long long sum = 0;
+  int nFunctions = functions.size();
+  for (int f = 0; f < nFunctions; ++f) {
+    Symbols.pushThisScope(scopes[f]);
+    for (int r = 0; r < rounds; ++r) {
+      for (auto & l : locals)
+        sum += Symbols.findInStack(l) + Symbols.getType(l) + Symbols.isParameterClass(l);
+      const std::string & g = functions[(f*7 + r) % nFunctions];
+      sum += Symbols.findInStack(g) + Symbols.getType(g) + Symbols.isFunctionClass(g);
+    }
+    Symbols.popScope();
+  }
+  return sum;
+}
+
+// Usage: ./symtable [<functions> [<locals>]]
+//   Declares the given functions (2000 by default), each one with a
+//   param and the given locals (40 by default). Then, in the scope of
+//   each function, looks up 50 times every local and a function with
+//   findInStack, getType and is*Class: first by name, and then by
+//   the IdentId of the name, as the listeners do. The same is done by
+//   name with the map-based baseline.
+int main(int argc, const char* argv[]) {
+  int nFunctions = (argc > 1 ? std::atoi(argv[1]) : 2000);
+  int nLocals = (argc > 2 ? std::atoi(argv[2]) : 40);
+  const int Rounds = 50;
+
+  TypesMgr Types;
+  TypesMgr::TypeId intTy = Types.createIntegerTy();
+  TypesMgr::TypeId funcTy = Types.createFunctionTy({intTy}, intTy);
+  std::vector<std::string> functions, locals;
+  for (int f = 0; f < nFunctions; ++f) functions.push_back("function_" + std::to_string(f));
+  for (int l = 0; l < nLocals; ++l) locals.push_back("local_variable_" + std::to_string(l));
+
+  SymTable Symbols(Types);
+  auto start = std::chrono::steady_clock::now();
+  std::vector<SymTable::ScopeId> scopes = declare(Symbols, functions, locals, intTy, funcTy);
+  double build = elapsed(start);
+
+  start = std::chrono::steady_clock::now();
+  long long byName = lookupNames(Symbols, scopes, functions, locals, Rounds);
+  double names = elapsed(start);
+
+  long long byId = 0;
+  start = std::chrono::steady_clock::now();
+  for (int f = 0; f < nFunctions; ++f) {
+    Symbols.pushThisScope(scopes[f]);
+    for (int r = 0; r < Rounds; ++r) {
+      for (auto & l : locals) {
+        SymTable::IdentId id = Symbols.lookupIdent(l);
+        byId += Symbols.findInStack(id) + Symbols.getType(id) + Symbols.isParameterClass(id);
+      }
+      SymTable::IdentId id = Symbols.lookupIdent(functions[(f*7 + r) % nFunctions]);
+      byId += Symbols.findInStack(id) + Symbols.getType(id) + Symbols.isFunctionClass(id);
+    }
+    Symbols.popScope();
+  }
+  double ids = elapsed(start);
+
+  MapSymTable Baseline(Types);
+  start = std::chrono::steady_clock::now();
+  std::vector<MapSymTable::ScopeId> mapScopes = declare(Baseline, functions, locals, intTy, funcTy);
+  double mapBuild = elapsed(start);
+
+  start = std::chrono::steady_clock::now();
+  long long byMap = lookupNames(Baseline, mapScopes, functions, locals, Rounds);
+  double maps = elapsed(start);
+
+  if (byName != byId or byName != byMap) {
+    std::cerr << "the tables do not agree: " << byName << ", " << byId
+              << " and " << byMap << std::endl;
+    return EXIT_FAILURE;
+  }
+  long long queries = 3LL * nFunctions * Rounds * (nLocals + 1);
+  std::cout << nFunctions << " functions with " << nLocals << " locals, "
+            << queries << " queries:" << std::endl
+            << "  SymTable: build " << build << " ms, by name " << names
+            << " ms, by IdentId " << ids << " ms" << std::endl
+            << "  std::map: build " << mapBuild << " ms, by name " << maps
+            << " ms" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,185 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    Types benchmark - Time of comparing the array and function
+//                      types of a large program with equalTypes
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "../../common/TypesMgr.h"
+
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+
+#include <cstdlib>    // std::atoi, EXIT_SUCCESS
+
+// using namespace std;
+
+
+// Milliseconds since 'start'
+static double elapsed(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// The types as TypesMgr kept them before they were interned, as the
+// baseline: every declaration creates a new type, and equalTypes
+// walks both types until they differ
+class StructuralTypes {
+public:
+  typedef std::size_t TypeId;
+
+  StructuralTypes() : Types(VoidTy + 1) {
+    for (TypeId t = 0; t <= VoidTy; ++t) Types[t].kind = t;
+  }
+  TypeId createIntegerTy   () { return IntegerTy; }
+  TypeId createFloatTy     () { return FloatTy; }
+  TypeId createBooleanTy   () { return BooleanTy; }
+  TypeId createCharacterTy () { return CharacterTy; }
+  TypeId createVoidTy      () { return VoidTy; }
+  TypeId createFunctionTy(const std::vector<TypeId> & paramsTypes, TypeId returnType) {
+    Types.push_back(Type{FunctionTy, 0, returnType, paramsTypes});
+    return Types.size() - 1;
+  }
+  TypeId createArrayTy(unsigned int size, TypeId elemType) {
+    Types.push_back(Type{ArrayTy, size, elemType, {}});
+    return Types.size() - 1;
+  }
+  bool equalTypes(TypeId tid1, TypeId tid2) const {
+    if (tid1 == tid2) return true;
+    const Type & t1 = Types[tid1];
+    const Type & t2 = Types[tid2];
+    if (t1.kind != t2.kind) return false;
+    if (t1.kind == FunctionTy) {
+      if (t1.params.size() != t2.params.size()) return false;
+      for (std::size_t i = 0; i < t1.params.size(); ++i)
+        if (not equalTypes(t1.params[i], t2.params[i])) return false;
+      return equalTypes(t1.elem, t2.elem);
+    }
+    if (t1.kind == ArrayTy)
+      return t1.size == t2.size and equalTypes(t1.elem, t2.elem);
+    return true;
+  }
+
+private:
+  enum {IntegerTy, FloatTy, BooleanTy, CharacterTy, VoidTy, ArrayTy, FunctionTy};
+  struct Type {
+    std::size_t         kind;
+    unsigned int        size;    // of an array
+    TypeId              elem;    // of an array, or returned by a function
+    std::vector<TypeId> params;
+  };
+  std::vector<Type> Types;
+};
+
+// The types of the declarations of a program, in Types: 'n' arrays
+// (of one to three dimensions) and 'n' functions with up to four
+// params, one per declaration. Declaration d is the same type as
+// declaration d + Distinct, as when a program declares the same
+// arrays and functions over and over.
+const int Distinct = 1000;
+
+template <class Manager>
+static std::vector<typename Manager::TypeId> declare(Manager & Types, int n) {
+  typedef typename Manager::TypeId TypeId;
+  const TypeId basic[4] = {Types.createIntegerTy(), Types.createFloatTy(),
+                           Types.createBooleanTy(), Types.createCharacterTy()};
+  std::vector<TypeId> decls;
+  for (int i = 0; i < n; ++i) {
+    int d = i % Distinct;
+    TypeId t = basic[d % 4];
+    for (int dim = 0; dim <= d % 3; ++dim) t = Types.createArrayTy(1 + (d + dim) % 97, t);
+    decls.push_back(t);
+  }
+  for (int i = 0; i < n; ++i) {
+    int d = i % Distinct;
+    std::vector<TypeId> params;
+    for (int p = 0; p < d % 5; ++p)
+      params.push_back((d + p) % 2 ? decls[(d + p) % Distinct] : basic[(d + p) % 4]);
+    decls.push_back(Types.createFunctionTy(params, d % 7 ? basic[d % 4] : Types.createVoidTy()));
+  }
+  return decls;
+}
+
+// Usage: ./types [<declarations> [<comparisons>]]
+//   Creates the types of the given array and function declarations
+//   (50000 of each by default), and compares pairs of them with
+//   equalTypes (2000000 by default, half of them equal): first with
+//   TypesMgr, and then with the structural baseline.
+int main(int argc, const char* argv[]) {
+  int nDecls = (argc > 1 ? std::atoi(argv[1]) : 50000);
+  long nQueries = (argc > 2 ? std::atol(argv[2]) : 2000000);
+  if (nDecls < Distinct or nQueries < 1) {
+    std::cerr << "usage: " << argv[0] << " [<declarations> (at least "
+              << Distinct << ") [<comparisons>]]" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // the pairs to compare, as indexes of declarations
+  std::vector<std::pair<std::size_t, std::size_t>> pairs;
+  std::uint32_t seed = 12345;
+  auto next = [&seed] () { seed = seed * 1103515245 + 12345; return seed >> 8; };
+  std::size_t total = 2 * std::size_t(nDecls), copies = nDecls / Distinct;
+  for (long q = 0; q < nQueries; ++q) {
+    std::size_t a = next() % total;
+    // another copy of the same array or function
+    std::size_t first = a - a % nDecls;
+    std::size_t b = (q % 2 ? next() % total :
+                     first + (a - first) % Distinct + (next() % copies) * Distinct);
+    pairs.push_back({a, b});
+  }
+
+  TypesMgr Types;
+  auto start = std::chrono::steady_clock::now();
+  std::vector<TypesMgr::TypeId> interned = declare(Types, nDecls);
+  double internedBuild = elapsed(start);
+  long internedEqual = 0;
+  start = std::chrono::steady_clock::now();
+  for (auto & p : pairs) internedEqual += Types.equalTypes(interned[p.first], interned[p.second]);
+  double internedCompare = elapsed(start);
+
+  StructuralTypes Baseline;
+  start = std::chrono::steady_clock::now();
+  std::vector<StructuralTypes::TypeId> structural = declare(Baseline, nDecls);
+  double structuralBuild = elapsed(start);
+  long structuralEqual = 0;
+  start = std::chrono::steady_clock::now();
+  for (auto & p : pairs)
+    structuralEqual += Baseline.equalTypes(structural[p.first], structural[p.second]);
+  double structuralCompare = elapsed(start);
+
+  if (internedEqual != structuralEqual) {
+    std::cerr << "the managers do not agree: " << internedEqual << " and "
+              << structuralEqual << " equal pairs" << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::cout << 2 * nDecls << " declarations, " << nQueries << " comparisons ("
+            << internedEqual << " equal)" << std::endl
+            << "  interned:   build " << internedBuild << " ms, equalTypes "
+            << internedCompare << " ms" << std::endl
+            << "  structural: build " << structuralBuild << " ms, equalTypes "
+            << structuralCompare << " ms" << std::endl;
+  return EXIT_SUCCESS;
+}
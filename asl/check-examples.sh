@@ -60,3 +60,178 @@ echo "END   examples-initial/execution"
 #     rm -f tmp.t tmp.out
 # done
 # echo "END   examples-full/execution"
+
+echo ""
+echo "BEGIN examples-opt/execution"
+for f in ../examples/opt_*.asl; do
+    echo $(basename "$f")
+    ./asl -O2 "$f" > tmp.t
+    ../tvm/tvm tmp.t < "${f/asl/in}" > tmp.out
+    diff tmp.out "${f/asl/out}"
+    rm -f tmp.t tmp.out
+done
+echo "END   examples-opt/execution"
+
+echo ""
+echo "BEGIN examples-initial/binary"
+for f in ../examples/jpbasic_genc_*.asl ../examples/opt_*.asl; do
+    echo $(basename "$f")
+    ./asl -O2 "$f" > tmp.t
+    ./asl -O2 -o tmp.tbc "$f"
+    ../vm/vm --dump tmp.tbc > tmp2.t
+    diff tmp2.t tmp.t
+    ../vm/vm tmp.tbc < "${f/asl/in}" > tmp.out
+    ../tvm/tvm tmp.t < "${f/asl/in}" > tmp2.out
+    diff tmp.out tmp2.out
+    rm -f tmp.t tmp2.t tmp.tbc tmp.out tmp2.out
+done
+echo "END   examples-initial/binary"
+
+echo ""
+echo "BEGIN examples/fused"
+for f in ../examples/*.asl; do
+    echo $(basename "$f")
+    ./asl "$f" > tmp.t
+    ./asl --fused "$f" > tmp2.t
+    diff tmp2.t tmp.t
+    rm -f tmp.t tmp2.t
+done
+echo "END   examples/fused"
+
+echo ""
+echo "BEGIN examples/jobs"
+for f in ../examples/*.asl; do
+    echo $(basename "$f")
+    ./asl "$f" > tmp.t
+    ./asl -j 4 "$f" > tmp2.t
+    diff tmp2.t tmp.t
+    rm -f tmp.t tmp2.t
+done
+echo "END   examples/jobs"
+
+echo ""
+echo "BEGIN examples/cache"
+rm -rf tmp.cache
+for f in ../examples/*.asl; do
+    echo $(basename "$f")
+    ./asl "$f" > tmp.t
+    ./asl --cache=tmp.cache "$f" > tmp2.t
+    diff tmp2.t tmp.t
+    ./asl --cache=tmp.cache "$f" > tmp2.t
+    diff tmp2.t tmp.t
+    # the cached code of a function that has moved keeps its positions
+    { echo; sed 's/^func/  func/' "$f"; } > tmp.asl
+    ./asl -o tmp.tbc tmp.asl
+    ./asl --cache=tmp.cache -o tmp2.tbc tmp.asl
+    cmp tmp2.tbc tmp.tbc
+    rm -f tmp.t tmp2.t tmp.asl tmp.tbc tmp2.tbc
+done
+rm -rf tmp.cache
+echo "END   examples/cache"
+
+echo ""
+echo "BEGIN examples/serve"
+./asl --serve --socket=tmp.sock 2> /dev/null &
+server=$!
+sleep 1
+for f in ../examples/*.asl; do
+    echo $(basename "$f")
+    ./asl -O1 "$f" > tmp.t
+    ../aslc/aslc --socket=tmp.sock -O1 "$f" > tmp2.t
+    diff tmp2.t tmp.t
+    rm -f tmp.t tmp2.t
+done
+kill $server
+rm -f tmp.sock
+echo "END   examples/serve"
+
+echo ""
+echo "BEGIN examples/max-errors"
+for f in ../examples/jpbasic_chkt_*.asl; do
+    echo $(basename "$f")
+    ./asl --max-errors 1000 "$f" | egrep ^L > tmp.err
+    diff tmp.err "${f/asl/err}"
+    n=$(./asl --max-errors 1 "$f" | egrep -c ^L)
+    [ "$n" -le 1 ] || echo "$n errors written with --max-errors 1"
+    rm -f tmp.err
+done
+echo "END   examples/max-errors"
+
+echo ""
+echo "BEGIN examples/profile"
+for f in ../examples/jpbasic_genc_*.asl ../examples/opt_*.asl; do
+    echo $(basename "$f")
+    ./asl -o tmp.tbc "$f"
+    ../vm/vm tmp.tbc < "${f/asl/in}" > tmp.out
+    ../vm/vm --profile=tmp.prof --profile-stacks=tmp.stacks tmp.tbc < "${f/asl/in}" > tmp2.out
+    diff tmp2.out tmp.out
+    total=$(head -1 tmp.prof | cut -d' ' -f3)
+    sum=$(awk '{ s += $NF } END { print s+0 }' tmp.stacks)
+    [ "$total" = "$sum" ] || echo "profile: $total instructions, $sum in the stacks"
+    rm -f tmp.tbc tmp.out tmp2.out tmp.prof tmp.stacks
+done
+echo "END   examples/profile"
+
+echo ""
+echo "BEGIN examples/bounds"
+for f in ../examples/bounds_*.asl; do
+    echo $(basename "$f")
+    for o in -O0 -O2; do
+        ./asl $o -o tmp.tbc "$f"
+        ../vm/vm tmp.tbc < "${f/asl/in}" > tmp.out 2> tmp.err
+        diff tmp.out "${f/asl/out}"
+        grep -o "array index [^(]*(size [0-9?]*)" tmp.err | diff - "${f/asl/err}"
+    done
+    rm -f tmp.tbc tmp.out tmp.err
+done
+echo "END   examples/bounds"
+
+echo ""
+echo "BEGIN examples/calls"
+for f in ../examples/calls_*.asl; do
+    echo $(basename "$f")
+    ./asl -O2 -o tmp.tbc "$f"
+    ../vm/vm tmp.tbc < "${f/asl/in}" > tmp.out
+    diff tmp.out "${f/asl/out}"
+    rm -f tmp.tbc tmp.out
+done
+echo "END   examples/calls"
+
+echo ""
+echo "BEGIN examples/limits"
+for f in ../examples/limits_*.asl; do
+    echo $(basename "$f")
+    ./asl -O2 -o tmp.tbc "$f"
+    ../vm/vm --max-instructions=1M --max-depth=1000 --max-memory=1M tmp.tbc \
+        < "${f/asl/in}" > tmp.out 2> tmp.err
+    [ $? -eq 2 ] || echo "a limit should stop the program"
+    diff tmp.out "${f/asl/out}"
+    head -1 tmp.err | sed 's/.*: //' | diff - "${f/asl/err}"
+    rm -f tmp.tbc tmp.out tmp.err
+done
+echo "END   examples/limits"
+
+echo ""
+echo "BEGIN examples/snapshot"
+for f in ../examples/snapshot_*.asl; do
+    echo $(basename "$f")
+    ./asl -O2 -o tmp.tbc "$f"
+    ../vm/vm --snapshot=tmp.tvs --snapshot-at=work tmp.tbc < "${f/asl/in}" > tmp.out
+    diff tmp.out "${f/asl/out}"
+    ../vm/vm --restore=tmp.tvs tmp.tbc < "${f/asl/in}" > tmp.out
+    diff tmp.out "${f/asl/out}"
+    rm -f tmp.tbc tmp.tvs tmp.out
+done
+echo "END   examples/snapshot"
+
+echo ""
+echo "BEGIN examples/batch"
+mkdir -p tmp.batch
+for f in ../examples/calls_*.asl ../examples/bounds_*.asl; do
+    echo $(basename "$f")
+    ./asl -O2 -o tmp.tbc "$f"
+    ../vm/vm --batch=tmp.batch -j 2 tmp.tbc "${f/asl/in}" 2> /dev/null
+    diff tmp.batch/$(basename "${f/asl/out}") "${f/asl/out}"
+done
+rm -rf tmp.tbc tmp.batch
+echo "END   examples/batch"
@@ -31,108 +31,82 @@
 
 
 #include "antlr4-runtime.h"
-#include "AslLexer.h"
-#include "AslParser.h"
-#include "tree/ParseTreeWalker.h"
 
-#include "../common/TypesMgr.h"
-#include "../common/SymTable.h"
-#include "../common/TreeDecoration.h"
-#include "../common/SemErrors.h"
-#include "SymbolsListener.h"
-#include "TypeCheckListener.h"
-#include "../common/code.h"
-#include "CodeGenListener.h"
+#include "Compiler.h"
+#include "CompileServer.h"
+#include "../common/CompileChannel.h"
+#include "../common/Arena.h"
 
 #include <iostream>
 #include <fstream>    // ifstream
+#include <string>
+#include <vector>
 
 #include <cstdio>     // fopen
-#include <cstdlib>    // EXIT_FAILURE, EXIT_SUCCESS
+#include <cstdlib>    // EXIT_FAILURE, EXIT_SUCCESS, std::atoi
 
 // using namespace std;
 // using namespace antlr4;
 
 
 int main(int argc, const char* argv[]) {
-  // check the correct use of the program
-  if (argc > 2) {
-    std::cout << "Usage: ./main [<file>]" << std::endl;
+  // no need to keep std::cout synchronized with C stdio
+  std::ios::sync_with_stdio(false);
+
+  // check the correct use of the program: the options of the server
+  // are taken here, and the rest are the ones of a compilation
+  bool serve = false;
+  std::string socketPath = CompileChannel::DefaultSocket;
+  unsigned int serverThreads = 0;
+  std::vector<std::string> args;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--serve")
+      serve = true;
+    else if (arg.compare(0, 9, "--socket=") == 0)
+      socketPath = arg.substr(9);
+    else if (arg.compare(0, 16, "--serve-threads=") == 0)
+      serverThreads = std::atoi(arg.substr(16).c_str());
+    else
+      args.push_back(arg);
+  }
+  Compiler::Options options;
+  std::string fileName;
+  if (not Compiler::parseOptions(args, options, fileName) or
+      (serve and not args.empty())) {
+    std::cout << "Usage: ./main " << Compiler::usage() << " [<file>]" << std::endl
+              << "       ./main --serve [--socket=<path>] [--serve-threads=<n>]"
+              << std::endl;
     return EXIT_FAILURE;
   }
-  if (argc == 2 and not std::fopen(argv[1], "r")) {
-    std::cout << "No such file: " << argv[1] << std::endl;
+
+  // Compile the programs sent by the clients, until it is killed
+  if (serve) {
+    CompileServer server(socketPath, serverThreads);
+    return server.run(std::cerr);
+  }
+
+  if (fileName != "" and not std::fopen(fileName.c_str(), "r")) {
+    std::cout << "No such file: " << fileName << std::endl;
     return EXIT_FAILURE;
   }
 
+  // The decorations of the tree, the symbol tables and the instruction
+  // lists are allocated in this arena, and released all at once at exit
+  Arena arena;
+  Arena::Use useArena(arena);
+
   // open input file (or std::cin) and create a character stream
   antlr4::ANTLRInputStream input;
-  if (argc == 2) {  // reads from <file>
+  if (fileName != "") {   // reads from <file>
     std::ifstream stream;
-    stream.open(argv[1]);
+    stream.open(fileName);
     input = antlr4::ANTLRInputStream(stream);
   }
-  else {            // reads fron std::cin
+  else {                  // reads fron std::cin
     input = antlr4::ANTLRInputStream(std::cin);
   }
 
-  // create a lexer that consumes the character stream and produce a token stream
-  AslLexer lexer(&input);
-  antlr4::CommonTokenStream tokens(&lexer);
-
-  // create a parser that consumes the token stream, and parses it.
-  AslParser parser(&tokens);
-
-  // call the parser and get the parse tree
-  antlr4::tree::ParseTree *tree = parser.program();
-
-  // check for lexical or syntactical errors
-  if (lexer.getNumberOfSyntaxErrors() > 0 or
-      parser.getNumberOfSyntaxErrors() > 0) {
-    std::cout << "Lexical and/or syntactical errors have been found." << std::endl;
-    return EXIT_FAILURE;
-  }
-
-  // print the parse tree (for debugging purposes)
-  // std::cout << tree->toStringTree(&parser) << std::endl;
-
-  // create a walker that will traverse the tree and do several things,
-  // like checking variable types or generating code.
-  antlr4::tree::ParseTreeWalker walker;
-
-  // Auxililary classes we are going to need to store information while
-  // traversing the tree. They are described below in this document
-  TypesMgr       types;
-  SymTable       symbols(types);
-  TreeDecoration decorations;
-  SemErrors      errors;
-
-  // Create a Listener that looks for variables and function declarations in the tree
-  // and stores required information
-  SymbolsListener symboldecl(types, symbols, decorations, errors);
-  // Traverse the tree using this listener, to collect information about declared identifiers
-  walker.walk(&symboldecl, tree);
-
-  // Create another Listener that will perform type checkings wherever it is needed
-  // (on expressions, assignments, parameter passing, etc)
-  TypeCheckListener typecheck(types, symbols, decorations, errors);
-  // Traverse the tree using this listener, so all types are checked
-  walker.walk(&typecheck, tree);
-
-  if (errors.getNumberOfSemanticErrors() > 0) {
-    std::cout << "There are semantic errors: no code generated." << std::endl;
-    return EXIT_FAILURE;
-  }
-
-  // Auxiliary class to store the code we will be creating
-  code mycode;
-  // Create a third listener that will generate code for each part of the tree
-  CodeGenListener codegenerator(types, symbols, decorations, mycode);
-  // Traverse the tree using this listener, so code is generated and stored in 'mycode'
-  walker.walk(&codegenerator, tree);
-
-  // print generated code as output
-  std::cout << mycode.dump() << std::endl;
-
-  return EXIT_SUCCESS;
+  Compiler compiler(options);
+  return compiler.compile(input, std::cout, std::cerr);
 }
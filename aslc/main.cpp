@@ -0,0 +1,188 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    aslc - Client of the asl compile server (asl --serve), and
+//           load generator to measure it
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "../common/CompileChannel.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>  // std::sort
+#include <iomanip>    // std::setprecision
+
+#include <cstdlib>    // EXIT_FAILURE, EXIT_SUCCESS, std::atoi
+#include <climits>    // PATH_MAX
+
+#include <unistd.h>   // getcwd
+
+// using namespace std;
+
+
+// The server may run in another directory: the paths of the files it
+// writes are made absolute here
+static std::string absolutePath(const std::string & path) {
+  char cwd[PATH_MAX];
+  if (path.empty() or path[0] == '/' or not ::getcwd(cwd, sizeof(cwd)))
+    return path;
+  return std::string(cwd) + "/" + path;
+}
+
+// Send the same request 'total' times from 'clients' connections at
+// the same time, and report the throughput and the latencies
+static int benchmark(const std::string & socketPath, const CompileRequest & request,
+                     unsigned int total, unsigned int clients) {
+  typedef std::chrono::steady_clock Clock;
+  std::vector<std::vector<double> > latencies(clients);
+  std::atomic<unsigned int> next(0);
+  std::atomic<unsigned int> failed(0);
+  std::atomic<int> status(-1);
+
+  Clock::time_point start = Clock::now();
+  std::vector<std::thread> pool;
+  for (unsigned int c = 0; c < clients; ++c) {
+    pool.push_back(std::thread([&, c] {
+          std::string error;
+          int fd = CompileChannel::connect(socketPath, error);
+          if (fd < 0) {
+            failed += total;
+            return;
+          }
+          CompileChannel channel(fd);
+          CompileReply reply;
+          while (next++ < total) {
+            Clock::time_point sent = Clock::now();
+            if (not channel.sendRequest(request) or not channel.receiveReply(reply)) {
+              ++failed;
+              return;
+            }
+            latencies[c].push_back(
+              std::chrono::duration<double, std::milli>(Clock::now() - sent).count());
+            status = reply.status;
+          }
+        }));
+  }
+  for (auto & t : pool) t.join();
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+  std::vector<double> all;
+  for (auto & l : latencies) all.insert(all.end(), l.begin(), l.end());
+  std::sort(all.begin(), all.end());
+  if (all.empty()) {
+    std::cerr << "aslc: no request was answered" << std::endl;
+    return EXIT_FAILURE;
+  }
+  auto percentile = [&] (double p) {
+    return all[std::min(all.size() - 1, std::size_t(p * all.size()))];
+  };
+  std::cout << std::fixed << std::setprecision(3)
+            << "requests " << all.size() << " (" << failed << " failed), "
+            << clients << " clients, status " << status << std::endl
+            << "time " << seconds << " s, " << all.size() / seconds
+            << " requests/s" << std::endl
+            << "latency p50 " << percentile(0.50) << " ms, p99 "
+            << percentile(0.99) << " ms, max " << all.back() << " ms" << std::endl;
+  return failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+int main(int argc, const char* argv[]) {
+  // check the correct use of the program: the options of asl are sent
+  // to the server as they are, but the input file is read here
+  std::string socketPath = CompileChannel::DefaultSocket;
+  unsigned int bench = 0, clients = 1;
+  std::string fileName;
+  bool wrong = false;
+  CompileRequest request;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg.compare(0, 9, "--socket=") == 0)
+      socketPath = arg.substr(9);
+    else if (arg.compare(0, 8, "--bench=") == 0)
+      bench = std::atoi(arg.substr(8).c_str());
+    else if (arg.compare(0, 10, "--clients=") == 0)
+      clients = std::atoi(arg.substr(10).c_str());
+    else if ((arg == "-o" or arg == "-j" or arg == "--max-errors") and i+1 < argc) {
+      request.args.push_back(arg);
+      std::string value = argv[++i];
+      request.args.push_back(arg == "-o" ? absolutePath(value) : value);
+    }
+    else if (arg.compare(0, 8, "--cache=") == 0)
+      request.args.push_back("--cache=" + absolutePath(arg.substr(8)));
+    else if (arg.compare(0, 13, "--line-table=") == 0)
+      request.args.push_back("--line-table=" + absolutePath(arg.substr(13)));
+    else if (arg[0] == '-')
+      request.args.push_back(arg);
+    else if (fileName.empty())
+      fileName = arg;
+    else
+      wrong = true;
+  }
+  if (wrong or clients == 0) {
+    std::cout << "Usage: ./aslc [--socket=<path>] [--bench=<requests> [--clients=<n>]] "
+              << "[<asl options>] [<file>]" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // read the program
+  std::ostringstream source;
+  if (fileName.empty())
+    source << std::cin.rdbuf();
+  else {
+    std::ifstream stream(fileName);
+    if (not stream) {
+      std::cout << "No such file: " << fileName << std::endl;
+      return EXIT_FAILURE;
+    }
+    source << stream.rdbuf();
+  }
+  request.source = source.str();
+
+  if (bench > 0)
+    return benchmark(socketPath, request, bench, clients);
+
+  // compile it as asl would do
+  std::string error;
+  int fd = CompileChannel::connect(socketPath, error);
+  if (fd < 0) {
+    std::cerr << "aslc: " << error << " (is 'asl --serve' running?)" << std::endl;
+    return EXIT_FAILURE;
+  }
+  CompileChannel channel(fd);
+  CompileReply reply;
+  if (not channel.sendRequest(request) or not channel.receiveReply(reply)) {
+    std::cerr << "aslc: the server closed the connection" << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::cout << reply.out << std::flush;
+  std::cerr << reply.err << std::flush;
+  return reply.status;
+}
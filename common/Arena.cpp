@@ -0,0 +1,158 @@
+/////////////////////////////////////////////////////////////////
+//
+//    Arena - Memory of a compilation, released all at once
+//            for the Asl programming language
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+////////////////////////////////////////////////////////////////
+
+
+#include "Arena.h"
+
+#include <vector>
+#include <new>        // ::operator new
+
+#include <cstddef>    // std::size_t
+
+// using namespace std;
+
+
+namespace {
+  // all the objects are aligned as the most aligned fundamental type
+  const std::size_t Alignment      = 16;
+  const std::size_t SmallLimit     = 512;
+  const std::size_t NumSmallClass  = SmallLimit / Alignment;
+  const std::size_t MaxBlockSize   = 4*1024*1024;
+  const std::size_t NumSizeClasses = NumSmallClass + 8*sizeof(std::size_t);
+}
+
+thread_local Arena * Arena::Current = nullptr;
+
+// Constructor
+Arena::Arena(std::size_t blockSize) :
+  BlockSize{blockSize}, Reserved{0}, Free{nullptr}, BlockEnd{nullptr},
+  FreeLists(NumSizeClasses, nullptr) {
+}
+
+// Destructor
+Arena::~Arena() {
+  release();
+}
+
+// Returns memory for an object: from the free list of its class if
+// there is some, or from the last block
+void * Arena::allocate(std::size_t bytes) {
+  std::size_t c = sizeClass(bytes);
+  if (FreeLists[c] != nullptr) {
+    void * p = FreeLists[c];
+    FreeLists[c] = *static_cast<void **>(p);
+    return p;
+  }
+  std::size_t size = classSize(c);
+  if (Free == nullptr or std::size_t(BlockEnd - Free) < size)
+    newBlock(size);
+  void * p = Free;
+  Free += size;
+  return p;
+}
+
+// The memory of the object is linked in the free list of its class
+void Arena::deallocate(void * p, std::size_t bytes) {
+  if (p == nullptr) return;
+  std::size_t c = sizeClass(bytes);
+  *static_cast<void **>(p) = FreeLists[c];
+  FreeLists[c] = p;
+}
+
+// Gives back all the blocks to the system
+void Arena::release() {
+  for (char * block : Blocks)
+    ::operator delete(block);
+  Blocks.clear();
+  Reserved = 0;
+  Free = BlockEnd = nullptr;
+  FreeLists.assign(NumSizeClasses, nullptr);
+}
+
+void Arena::reset() {
+  if (Blocks.empty()) return;
+  char * last = Blocks.back();
+  std::size_t size = BlockEnd - last;
+  Blocks.pop_back();
+  release();
+  Blocks.push_back(last);
+  Reserved = size;
+  Free = last;
+  BlockEnd = last + size;
+}
+
+std::size_t Arena::getNumBlocks() const {
+  return Blocks.size();
+}
+
+std::size_t Arena::getReservedBytes() const {
+  return Reserved;
+}
+
+// Size classes
+std::size_t Arena::sizeClass(std::size_t bytes) {
+  if (bytes <= SmallLimit)
+    return bytes == 0 ? 0 : (bytes - 1) / Alignment;
+  std::size_t c = NumSmallClass;
+  for (std::size_t size = 2*SmallLimit; size < bytes; size *= 2)
+    ++c;
+  return c;
+}
+
+std::size_t Arena::classSize(std::size_t c) {
+  if (c < NumSmallClass)
+    return (c + 1) * Alignment;
+  return (2*SmallLimit) << (c - NumSmallClass);
+}
+
+// The blocks double their size (up to a limit), and an object bigger
+// than the block size gets a block of its own
+void Arena::newBlock(std::size_t bytes) {
+  std::size_t size = BlockSize;
+  if (size < bytes) size = bytes;
+  else if (BlockSize < MaxBlockSize) BlockSize *= 2;
+  char * block = static_cast<char *>(::operator new(size));
+  Blocks.push_back(block);
+  Reserved += size;
+  Free = block;
+  BlockEnd = block + size;
+}
+
+// The current arena of the thread
+Arena * Arena::current() {
+  return Current;
+}
+
+Arena::Use::Use(Arena & arena) : previous{Arena::Current} {
+  Arena::Current = &arena;
+}
+
+Arena::Use::~Use() {
+  Arena::Current = previous;
+}
@@ -0,0 +1,169 @@
+/////////////////////////////////////////////////////////////////
+//
+//    Arena - Memory of a compilation, released all at once
+//            for the Asl programming language
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <vector>
+#include <new>        // ::operator new
+#include <type_traits>
+
+#include <cstddef>    // std::size_t
+
+// using namespace std;
+
+
+////////////////////////////////////////////////////////////////
+// Class Arena: gives memory for the many small objects created
+// during a compilation (tree decorations, instruction lists,
+// scopes of the symbol table...). The memory is taken from big
+// blocks, and all of them are released at once when the arena is
+// destroyed (or released). Freed memory is kept in a free list per
+// size class and reused by the following allocations of the same
+// class, since instruction lists are copied and concatenated very
+// often and a purely monotonic arena would grow with each copy.
+// An Arena is not thread safe: each thread compiling must use its
+// own arena.
+
+class Arena {
+
+public:
+
+  // Constructor: blockSize is the size of the first block
+  Arena (std::size_t blockSize = 64*1024);
+  // Destructor: releases all the memory
+  ~Arena ();
+
+  Arena (const Arena &) = delete;
+  Arena & operator= (const Arena &) = delete;
+
+  // Returns memory for an object of the given size
+  void * allocate   (std::size_t bytes);
+  // Gives back the memory of an object, to be reused by the arena
+  void   deallocate (void * p, std::size_t bytes);
+  // Releases all the memory (the objects allocated must not be used)
+  void   release    ();
+  // Forgets all the objects, but keeps the last block (the biggest
+  // one, unless some object needed a block of its own) for the next
+  // ones, so a process compiling many programs reuses its memory
+  void   reset      ();
+
+  // Statistics: number of blocks and bytes taken from the system
+  std::size_t getNumBlocks     () const;
+  std::size_t getReservedBytes () const;
+
+  // The arena of the current thread, used by the ArenaAllocator's
+  // created without an explicit arena (nullptr means no arena)
+  static Arena * current ();
+
+  // Makes an arena the current one of this thread while it exists
+  class Use {
+  public:
+    Use (Arena & arena);
+    ~Use ();
+    Use (const Use &) = delete;
+    Use & operator= (const Use &) = delete;
+  private:
+    Arena * previous;
+  };
+
+private:
+
+  // Size classes: multiples of 16 bytes up to 512, and powers of
+  // two for the bigger ones
+  static std::size_t sizeClass (std::size_t bytes);
+  static std::size_t classSize (std::size_t c);
+
+  // Takes a new block with at least bytes free
+  void newBlock (std::size_t bytes);
+
+  // Attributes
+  std::size_t          BlockSize;
+  std::vector<char *>  Blocks;
+  std::size_t          Reserved;
+  char               * Free;        // free memory in the last block
+  char               * BlockEnd;
+  std::vector<void *>  FreeLists;   // one per size class
+
+  static thread_local Arena * Current;
+
+};  // class Arena
+
+
+////////////////////////////////////////////////////////////////
+// Class ArenaAllocator: standard allocator that takes the memory
+// from an Arena. If it has no arena (it was created when there
+// was no current arena) it uses the global operator new.
+
+template <typename T>
+class ArenaAllocator {
+
+public:
+
+  typedef T value_type;
+
+  // Moving or swapping a container moves its allocator too, so the
+  // memory is always given back to the arena it came from
+  typedef std::true_type propagate_on_container_move_assignment;
+  typedef std::true_type propagate_on_container_swap;
+
+  ArenaAllocator () : arena{Arena::current()} { }
+  ArenaAllocator (Arena * a) : arena{a} { }
+  template <typename U>
+  ArenaAllocator (const ArenaAllocator<U> & other) : arena{other.getArena()} { }
+
+  T * allocate (std::size_t n) {
+    if (arena) return static_cast<T *>(arena->allocate(n*sizeof(T)));
+    return static_cast<T *>(::operator new(n*sizeof(T)));
+  }
+  void deallocate (T * p, std::size_t n) {
+    if (arena) arena->deallocate(p, n*sizeof(T));
+    else ::operator delete(p);
+  }
+
+  // A copy of a container takes its memory from the current arena
+  // (or the heap), not from the arena of the original
+  ArenaAllocator select_on_container_copy_construction () const {
+    return ArenaAllocator();
+  }
+
+  Arena * getArena () const { return arena; }
+
+private:
+  Arena * arena;
+
+};  // class ArenaAllocator
+
+template <typename T, typename U>
+bool operator== (const ArenaAllocator<T> & a, const ArenaAllocator<U> & b) {
+  return a.getArena() == b.getArena();
+}
+template <typename T, typename U>
+bool operator!= (const ArenaAllocator<T> & a, const ArenaAllocator<U> & b) {
+  return a.getArena() != b.getArena();
+}
@@ -0,0 +1,116 @@
+/////////////////////////////////////////////////////////////////
+//
+//    TVM - t-Code Virtual Machine
+//
+//    Copyright (C) 2017  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: Lluis Padro (padro@cs.upc.es)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.320 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+////////////////////////////////////////////////////////////////
+
+#include "BatchRunner.h"
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <thread>
+
+using namespace std;
+
+
+/// constructor
+BatchRunner::BatchRunner(const BinaryCode &prog, unsigned int threads) : program(prog) {
+  nThreads = (threads > 0 ? threads : max(1u, thread::hardware_concurrency()));
+  for (unsigned int w = 0; w < nThreads; ++w) queues.emplace_back(new Queue);
+}
+/// destructor
+BatchRunner::~BatchRunner() {}
+
+/// limits of each run
+void BatchRunner::set_limits(const vmachine::Limits &l) { limits = l; }
+
+/// number of threads of the pool
+unsigned int BatchRunner::get_num_threads() const { return nThreads; }
+
+/// run the program on every input
+vector<BatchRunner::Result> BatchRunner::run(const vector<string> &inputs,
+                                             const vector<string> &outputs) {
+  vector<Result> results(inputs.size());
+  // a contiguous share for each thread
+  for (size_t k = 0; k < inputs.size(); ++k)
+    queues[k * nThreads / inputs.size()]->jobs.push_back(k);
+  vector<thread> pool;
+  for (unsigned int w = 1; w < nThreads; ++w)
+    pool.emplace_back(&BatchRunner::worker, this, w, cref(inputs), cref(outputs), ref(results));
+  worker(0, inputs, outputs, results);
+  for (auto &t : pool) t.join();
+  return results;
+}
+
+bool BatchRunner::take(unsigned int w, size_t &job) {
+  {
+    lock_guard<mutex> lock(queues[w]->mutex);
+    if (not queues[w]->jobs.empty()) {
+      job = queues[w]->jobs.front();
+      queues[w]->jobs.pop_front();
+      return true;
+    }
+  }
+  // no job is ever added, so once all the queues are seen empty
+  // there is nothing left to do
+  for (unsigned int k = 1; k < nThreads; ++k) {
+    Queue &victim = *queues[(w + k) % nThreads];
+    lock_guard<mutex> lock(victim.mutex);
+    if (not victim.jobs.empty()) {
+      job = victim.jobs.back();
+      victim.jobs.pop_back();
+      return true;
+    }
+  }
+  return false;
+}
+
+void BatchRunner::worker(unsigned int w, const vector<string> &inputs,
+                         const vector<string> &outputs, vector<Result> &results) {
+  // the machine is kept from one input to the next (and so its stack)
+  vmachine vm(program);
+  vm.set_limits(limits);
+  size_t job;
+  while (take(w, job)) {
+    Result &r = results[job];
+    ifstream in(inputs[job]);
+    ofstream out(outputs[job]);
+    if (not in)
+      r.error = "can not open " + inputs[job];
+    else if (not out)
+      r.error = "can not write " + outputs[job];
+    else {
+      r.ok = vm.execute(in, out);
+      r.error = vm.get_error();
+      r.instructions = vm.get_status().instructions;
+      out.close();
+      if (r.ok and not out) {
+        r.ok = false;
+        r.error = "can not write " + outputs[job];
+      }
+    }
+  }
+}
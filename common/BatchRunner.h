@@ -0,0 +1,96 @@
+/////////////////////////////////////////////////////////////////
+//
+//    TVM - t-Code Virtual Machine
+//
+//    Copyright (C) 2017  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: Lluis Padro (padro@cs.upc.es)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.320 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <memory>
+
+#include <cstddef>    // std::size_t
+#include <cstdint>    // std::uint64_t
+
+#include "BinaryCode.h"
+#include "vmachine.h"
+
+// using namespace std;
+
+
+////////////////////////////////////////////////////////////////////
+/// Class BatchRunner runs one program (loaded once) on many inputs,
+/// writing the output of each one to its own file. The inputs are
+/// split among a pool of threads, each one with its own vmachine
+/// (and so its own stack and buffers). Every thread starts with a
+/// contiguous share of the inputs, and once it has run them all it
+/// steals the last pending ones of the others, so a few slow inputs
+/// do not leave the rest of the threads idle.
+
+class BatchRunner {
+ public:
+  /// how the run of one input has ended
+  struct Result {
+    bool ok = false;
+    std::string error;                ///< message if not ok
+    std::uint64_t instructions = 0;
+  };
+
+  /// constructor (threads == 0 means one thread per core)
+  BatchRunner(const BinaryCode &prog, unsigned int threads);
+  ~BatchRunner();
+
+  /// limits of each run
+  void set_limits(const vmachine::Limits &l);
+  /// run the program with each file of 'inputs' as its input, and
+  /// write what it writes to the file at the same position of
+  /// 'outputs'. The results are in the order of the inputs
+  std::vector<Result> run(const std::vector<std::string> &inputs,
+                          const std::vector<std::string> &outputs);
+  /// number of threads of the pool
+  unsigned int get_num_threads() const;
+
+ private:
+  /// inputs still to be run by a thread (the owner takes them from
+  /// the front, the thieves from the back)
+  struct Queue {
+    std::mutex mutex;
+    std::deque<std::size_t> jobs;
+  };
+
+  const BinaryCode &program;
+  unsigned int nThreads;
+  vmachine::Limits limits;
+  std::vector<std::unique_ptr<Queue>> queues;
+
+  /// the next input for thread w (false if there are none left)
+  bool take(unsigned int w, std::size_t &job);
+  /// work of thread w
+  void worker(unsigned int w, const std::vector<std::string> &inputs,
+              const std::vector<std::string> &outputs, std::vector<Result> &results);
+};
@@ -0,0 +1,683 @@
+/////////////////////////////////////////////////////////////////
+//
+//    TVM - t-Code Virtual Machine
+//
+//    Copyright (C) 2017  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: Lluis Padro (padro@cs.upc.es)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.320 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+////////////////////////////////////////////////////////////////
+
+#include "BinaryCode.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <algorithm>  // std::sort, std::min, std::max, std::set_union
+#include <iterator>   // std::back_inserter
+
+#include <cstring>    // std::memcpy, std::memcmp
+#include <cctype>     // std::isdigit
+#include <cstdlib>    // std::strtol, std::strtof
+
+#include <fcntl.h>    // open
+#include <unistd.h>   // close
+#include <sys/mman.h> // mmap, munmap
+#include <sys/stat.h> // fstat
+
+using namespace std;
+
+
+////////////////////////////////////////////////////////////////////
+/// Auxiliary functions to resolve the operands
+
+namespace {
+
+  /// string table under construction
+  class StringTable {
+   public:
+    StringTable() : blob(1, '\0') {}
+    uint32_t add(const string &s) {
+      if (s.empty()) return 0;
+      auto it = offsets.find(s);
+      if (it != offsets.end()) return it->second;
+      uint32_t off = blob.size();
+      blob += s;
+      blob += '\0';
+      offsets[s] = off;
+      return off;
+    }
+    const string & data() const { return blob; }
+   private:
+    string blob;
+    map<string, uint32_t> offsets;
+  };
+
+  /// value of a literal char, either x, 'x', \n or '\n'
+  bool decode_char(string s, int32_t &value) {
+    if (s.size() >= 3 and s.front() == '\'' and s.back() == '\'')
+      s = s.substr(1, s.size()-2);
+    if (s.size() == 1) { value = (unsigned char)s[0]; return true; }
+    if (s.size() != 2 or s[0] != '\\') return false;
+    switch (s[1]) {
+    case 'n':  value = '\n'; return true;
+    case 't':  value = '\t'; return true;
+    case '\\': value = '\\'; return true;
+    case '"':  value = '"';  return true;
+    case '\'': value = '\''; return true;
+    }
+    return false;
+  }
+
+  /// text of a string literal, "like\tthis\n"
+  string decode_string(const string &s) {
+    string text;
+    size_t i = 1;
+    while (i + 1 < s.size()) {
+      int32_t c;
+      // the same escapes as subroutine::expand_for_tvm
+      if (s[i] == '\\' and i + 2 < s.size() and string("nt\"\\").find(s[i+1]) != string::npos and
+          decode_char(s.substr(i, 2), c)) {
+        text += char(c);
+        i += 2;
+      }
+      else
+        text += s[i++];
+    }
+    return text;
+  }
+
+  /// value of an int, float (stored as its bits) or char constant
+  bool decode_constant(const string &s, int32_t &value) {
+    if (s.empty()) return false;
+    if (s[0] == '\'') return decode_char(s, value);
+    size_t d = (s[0] == '-' or s[0] == '+') ? 1 : 0;
+    if (d >= s.size() or not isdigit(s[d])) return false;
+    char *end;
+    if (s.find_first_of(".eE") == string::npos) {
+      value = strtol(s.c_str(), &end, 10);
+    }
+    else {
+      float f = strtof(s.c_str(), &end);
+      memcpy(&value, &f, sizeof(value));
+    }
+    return *end == '\0';
+  }
+
+  /// rounds a byte count up to a multiple of 4
+  uint32_t align4(size_t n) { return (n + 3) & ~size_t(3); }
+
+  /// role of each argument of an instruction
+  typedef enum {NOARG, VALUE, DEST, BASE, ADDRESS, LABEL, JUMP, CALLEE, CHAR, STRING} ArgRole;
+
+  void arg_roles(instruction::Operation op, ArgRole role[3]) {
+    role[0] = role[1] = role[2] = NOARG;
+    switch (op) {
+    case instruction::_LABEL:   role[0] = LABEL; break;
+    case instruction::_UJUMP:   role[0] = JUMP; break;
+    case instruction::_FJUMP:   role[0] = VALUE; role[1] = JUMP; break;
+    case instruction::_CALL:    role[0] = CALLEE; break;
+    case instruction::_PUSH:
+    case instruction::_WRITEI:
+    case instruction::_WRITEF:
+    case instruction::_WRITEC:  role[0] = VALUE; break;
+    case instruction::_POP:
+    case instruction::_READI:
+    case instruction::_READF:
+    case instruction::_READC:   role[0] = DEST; break;
+    case instruction::_WRITES:  role[1] = STRING; break;
+    case instruction::_RETURN:
+    case instruction::_WRITELN:
+    case instruction::_NOOP:
+    case instruction::_INVALID: break;
+    case instruction::_CHLOAD:  role[0] = DEST; role[1] = CHAR; break;
+    case instruction::_ALOAD:   role[0] = DEST; role[1] = ADDRESS; break;
+    case instruction::_XLOAD:   role[0] = BASE; role[1] = VALUE; role[2] = VALUE; break;
+    case instruction::_COPY:    role[0] = BASE; role[1] = BASE; role[2] = VALUE; break;
+    case instruction::_LOADX:   role[0] = DEST; role[1] = BASE; role[2] = VALUE; break;
+    case instruction::_CLOAD:   role[0] = VALUE; role[1] = VALUE; break;
+    case instruction::_NOT:
+    case instruction::_NEG:
+    case instruction::_FNEG:
+    case instruction::_FLOAT:
+    case instruction::_LOAD:
+    case instruction::_ILOAD:
+    case instruction::_FLOAD:
+    case instruction::_LOADC:   role[0] = DEST; role[1] = VALUE; break;
+    default:                    role[0] = DEST; role[1] = VALUE; role[2] = VALUE; break;
+    }
+  }
+
+  /// whether build gives an argument with that role an operand of that
+  /// kind (only a push or a pop can have no argument)
+  bool valid_kind(instruction::Operation op, ArgRole role, uint8_t kind) {
+    switch (role) {
+    case NOARG:
+    case LABEL:   return kind == tbc::NONE;
+    case VALUE:
+    case CHAR:    return kind == tbc::SLOT or kind == tbc::IMM or
+                         (kind == tbc::NONE and op == instruction::_PUSH);
+    case DEST:    return kind == tbc::SLOT or (kind == tbc::NONE and op == instruction::_POP);
+    case BASE:    return kind == tbc::SLOT or kind == tbc::ADDR;
+    case ADDRESS: return kind == tbc::ADDR;
+    case JUMP:    return kind == tbc::PC;
+    case CALLEE:  return kind == tbc::SUB;
+    case STRING:  return kind == tbc::STR;
+    }
+    return false;
+  }
+
+  /// Slots of the temporals of a subroutine, from 'first' on. Two
+  /// temporals share a slot if they are never alive at the same time,
+  /// so the frames are smaller. A temporal is alive from where it is
+  /// written to its last read (a loop keeps it alive all around), and
+  /// one whose address is taken or that is read before being written
+  /// keeps its slot for the whole subroutine. Returns the number of
+  /// slots used
+  uint32_t allocate_temporals(const instructionList &lins, uint32_t first,
+                              map<string, uint32_t> &slots) {
+    size_t n = lins.size();
+    map<string, size_t> ids;
+    vector<string> names;
+    vector<vector<size_t>> reads(n), writes(n);
+    vector<bool> pinned;
+    map<string, size_t> labels;
+    for (size_t pc = 0; pc < n; ++pc) {
+      const instruction &inst = lins[pc];
+      if (inst.oper == instruction::_LABEL) labels[inst.arg1] = pc;
+      const string *args[3] = {&inst.arg1, &inst.arg2, &inst.arg3};
+      ArgRole role[3];
+      arg_roles(inst.oper, role);
+      for (int a = 0; a < 3; ++a) {
+        const string &arg = *args[a];
+        if (arg.size() < 2 or arg[0] != '%' or role[a] == NOARG or role[a] == LABEL or
+            role[a] == JUMP or role[a] == CALLEE or role[a] == STRING)
+          continue;
+        auto it = ids.find(arg);
+        if (it == ids.end()) {
+          it = ids.insert({arg, names.size()}).first;
+          names.push_back(arg);
+          pinned.push_back(false);
+        }
+        if (role[a] == DEST) writes[pc].push_back(it->second);
+        else reads[pc].push_back(it->second);
+        if (role[a] == ADDRESS) pinned[it->second] = true;
+      }
+    }
+
+    // basic blocks: a label, or what follows a jump or a return, starts one
+    size_t nTemps = names.size();
+    vector<size_t> leader;
+    for (size_t pc = 0; pc < n; ++pc) {
+      instruction::Operation prev = (pc > 0 ? lins[pc - 1].oper : instruction::_RETURN);
+      if (pc == 0 or lins[pc].oper == instruction::_LABEL or prev == instruction::_RETURN or
+          prev == instruction::_UJUMP or prev == instruction::_FJUMP)
+        leader.push_back(pc);
+    }
+    size_t nBlocks = leader.size();
+    leader.push_back(n);
+    map<size_t, size_t> blockAt;
+    for (size_t b = 0; b < nBlocks; ++b) blockAt[leader[b]] = b;
+    vector<vector<size_t>> succs(nBlocks), use(nBlocks), def(nBlocks);
+    vector<size_t> defined(nTemps, n);     // block that last wrote each temporal
+    for (size_t b = 0; b < nBlocks; ++b) {
+      for (size_t pc = leader[b]; pc < leader[b + 1]; ++pc) {
+        for (size_t t : reads[pc]) if (defined[t] != b) use[b].push_back(t);
+        for (size_t t : writes[pc]) { defined[t] = b; def[b].push_back(t); }
+      }
+      for (auto *v : {&use[b], &def[b]}) {
+        sort(v->begin(), v->end());
+        v->erase(unique(v->begin(), v->end()), v->end());
+      }
+      const instruction &inst = lins[leader[b + 1] - 1];
+      if (inst.oper == instruction::_RETURN) continue;
+      if (inst.oper == instruction::_UJUMP or inst.oper == instruction::_FJUMP) {
+        auto it = labels.find(inst.oper == instruction::_UJUMP ? inst.arg1 : inst.arg2);
+        if (it != labels.end()) succs[b].push_back(blockAt[it->second]);
+        if (inst.oper == instruction::_UJUMP) continue;
+      }
+      if (b + 1 < nBlocks) succs[b].push_back(b + 1);
+    }
+
+    // liveness of the blocks, as sorted sets: few temporals live
+    // across blocks, so it does not grow with the size of the code
+    vector<vector<size_t>> liveIn(nBlocks), liveOut(nBlocks);
+    for (bool changed = true; changed; ) {
+      changed = false;
+      for (size_t b = nBlocks; b-- > 0; ) {
+        vector<size_t> out, in;
+        for (size_t next : succs[b]) {
+          vector<size_t> u;
+          set_union(out.begin(), out.end(), liveIn[next].begin(), liveIn[next].end(),
+                    back_inserter(u));
+          out.swap(u);
+        }
+        vector<size_t> kept;
+        set_difference(out.begin(), out.end(), def[b].begin(), def[b].end(),
+                       back_inserter(kept));
+        set_union(use[b].begin(), use[b].end(), kept.begin(), kept.end(), back_inserter(in));
+        liveOut[b].swap(out);
+        if (in != liveIn[b]) {
+          liveIn[b].swap(in);
+          changed = true;
+        }
+      }
+    }
+
+    // interval of each temporal (from its first to its last position
+    // alive, written or read), and linear scan
+    vector<size_t> start(nTemps, n), end(nTemps, 0);
+    auto extend = [&] (size_t t, size_t pc) { start[t] = min(start[t], pc); end[t] = max(end[t], pc); };
+    for (size_t b = 0; b < nBlocks; ++b) {
+      for (size_t t : liveIn[b]) extend(t, leader[b]);
+      for (size_t t : liveOut[b]) extend(t, leader[b + 1] - 1);
+    }
+    for (size_t pc = 0; pc < n; ++pc) {
+      for (size_t t : writes[pc]) extend(t, pc);
+      for (size_t t : reads[pc]) extend(t, pc);
+    }
+    if (nBlocks > 0)
+      for (size_t t : liveIn[0]) pinned[t] = true;
+    for (size_t t = 0; t < nTemps; ++t) {
+      if (pinned[t]) {
+        start[t] = 0;
+        end[t] = n;
+      }
+    }
+    vector<size_t> order(nTemps);
+    for (size_t t = 0; t < nTemps; ++t) order[t] = t;
+    sort(order.begin(), order.end(), [&] (size_t a, size_t b) { return start[a] < start[b]; });
+    vector<size_t> slotEnd;     // end of the temporal using each slot
+    for (size_t t : order) {
+      size_t k = 0;
+      while (k < slotEnd.size() and slotEnd[k] >= start[t]) ++k;
+      if (k == slotEnd.size()) slotEnd.push_back(0);
+      slotEnd[k] = end[t];
+      slots[names[t]] = first + k;
+    }
+    return slotEnd.size();
+  }
+
+}
+
+
+////////////////////////////////////////////////////////////////////
+/// Implementation for class 'BinaryCode'
+
+/// constructor
+BinaryCode::BinaryCode() : mapped(nullptr), mappedSize(0), image(nullptr) {}
+/// destructor
+BinaryCode::~BinaryCode() { unmap(); }
+
+void BinaryCode::unmap() {
+  if (mapped) munmap(mapped, mappedSize);
+  mapped = nullptr;
+  mappedSize = 0;
+  image = nullptr;
+}
+
+/// resolve and encode a program
+bool BinaryCode::build(const code &program, string &error) {
+  unmap();
+  buffer.clear();
+
+  const vector<subroutine> &subrs = program.get_subroutines();
+  map<string, uint32_t> subIndex;
+  for (size_t k = 0; k < subrs.size(); ++k) subIndex[subrs[k].get_name()] = k;
+  if (subIndex.count("main") == 0) {
+    error = "there is no function main";
+    return false;
+  }
+
+  StringTable strings;
+  vector<tbc::Subroutine> subs;
+  vector<tbc::Var> vars;
+  vector<tbc::Instr> instrs;
+  vector<tbc::Position> positions;
+
+  for (auto &subr : subrs) {
+    string where = "function " + subr.get_name() + ": ";
+    tbc::Subroutine bs;
+    bs.name = strings.add(subr.get_name());
+    bs.nParams = subr.params.size();
+    bs.nVars = subr.vars.size();
+    bs.firstVar = vars.size();
+    bs.firstInstr = instrs.size();
+
+    // frame slots: params, vars (local arrays use 'size' slots), temporals
+    struct Slot { uint32_t slot; bool local; uint32_t size; };
+    map<string, Slot> slots;
+    uint32_t next = 0;
+    for (auto &p : subr.params) {
+      vars.push_back({strings.add(p.name), uint32_t(p.size), next});
+      slots[p.name] = {next++, false, 1};
+    }
+    for (auto &v : subr.vars) {
+      vars.push_back({strings.add(v.name), uint32_t(v.size), next});
+      slots[v.name] = {next, true, uint32_t(v.size)};
+      next += v.size;
+    }
+
+    const instructionList &lins = subr.get_instructions();
+    if (lins.empty() or lins.back().oper != instruction::_RETURN) {
+      error = where + "the last instruction is not a return";
+      return false;
+    }
+    map<string, uint32_t> temps;
+    uint32_t nTemps = allocate_temporals(lins, next, temps);
+    for (auto &t : temps)
+      if (slots.count(t.first) == 0) slots[t.first] = {t.second, false, 1};
+    next += nTemps;
+    map<string, uint32_t> labels;
+    for (size_t pc = 0; pc < lins.size(); ++pc) {
+      if (lins[pc].oper == instruction::_LABEL)
+        labels[lins[pc].arg1] = bs.firstInstr + pc;
+    }
+
+    for (auto &inst : lins) {
+      tbc::Instr bi;
+      bi.oper = inst.oper;
+      const string *args[3] = {&inst.arg1, &inst.arg2, &inst.arg3};
+      ArgRole role[3];
+      arg_roles(inst.oper, role);
+      for (int a = 0; a < 3; ++a) {
+        const string &arg = *args[a];
+        bi.text[a] = strings.add(arg);
+        bi.kind[a] = tbc::NONE;
+        bi.value[a] = 0;
+        if (role[a] == NOARG or role[a] == LABEL) continue;
+        if (arg.empty()) {
+          if (inst.oper == instruction::_PUSH or inst.oper == instruction::_POP) continue;
+          error = where + "missing argument";
+          return false;
+        }
+
+        if (role[a] == JUMP) {
+          auto it = labels.find(arg);
+          if (it == labels.end()) {
+            error = where + "undefined label " + arg;
+            return false;
+          }
+          bi.kind[a] = tbc::PC;
+          bi.value[a] = it->second + 1;   // the label itself does nothing
+          continue;
+        }
+        if (role[a] == CALLEE) {
+          auto it = subIndex.find(arg);
+          if (it == subIndex.end()) {
+            error = where + "call to undefined function " + arg;
+            return false;
+          }
+          bi.kind[a] = tbc::SUB;
+          bi.value[a] = it->second;
+          continue;
+        }
+        if (role[a] == STRING) {
+          bi.kind[a] = tbc::STR;
+          bi.value[a] = strings.add(decode_string(arg));
+          continue;
+        }
+        int32_t value;
+        if ((role[a] == CHAR and decode_char(arg, value)) or
+            (role[a] == VALUE and decode_constant(arg, value))) {
+          bi.kind[a] = tbc::IMM;
+          bi.value[a] = value;
+          continue;
+        }
+        // an address: CHLOAD is also used to copy chars (e.g. to _result)
+        auto it = slots.find(arg);
+        if (it == slots.end()) {
+          if (arg[0] != '%') {
+            error = where + "unknown address " + arg;
+            return false;
+          }
+          it = slots.insert({arg, {next++, false, 1}}).first;
+        }
+        bi.value[a] = it->second.slot;
+        if (role[a] == ADDRESS or (role[a] == BASE and it->second.local))
+          bi.kind[a] = tbc::ADDR;
+        else
+          bi.kind[a] = tbc::SLOT;
+      }
+      bi.bound = tbc::Unchecked;
+      if (inst.oper == instruction::_XLOAD or inst.oper == instruction::_LOADX) {
+        // without the size given by asl, a local array still has its own
+        const string &base = (inst.oper == instruction::_XLOAD ? inst.arg1 : inst.arg2);
+        auto it = slots.find(base);
+        bool local = (it != slots.end() and it->second.local);
+        uint32_t size = inst.bound;
+        if (size == 0 and local) size = it->second.size;
+        // a proved index needs no check, but the base of an array that
+        // is not local comes from memory, so it still has to be checked
+        if (size == 0) bi.bound = tbc::UnknownBound;
+        else if (not inst.inRange) bi.bound = size;
+        else if (not local) bi.bound = size | tbc::InRange;
+      }
+      instrs.push_back(bi);
+      positions.push_back({inst.line, inst.column});
+    }
+    bs.nInstrs = lins.size();
+    bs.frameSize = next;
+    subs.push_back(bs);
+  }
+
+  // lay out the image
+  tbc::Header h;
+  memcpy(h.magic, tbc::Magic, sizeof(h.magic));
+  h.version = tbc::Version;
+  h.nSubroutines = subs.size();
+  h.subroutinesOffset = sizeof(tbc::Header);
+  h.nVars = vars.size();
+  h.varsOffset = h.subroutinesOffset + subs.size() * sizeof(tbc::Subroutine);
+  h.nInstrs = instrs.size();
+  h.instrsOffset = h.varsOffset + vars.size() * sizeof(tbc::Var);
+  h.positionsOffset = h.instrsOffset + instrs.size() * sizeof(tbc::Instr);
+  h.stringsSize = align4(strings.data().size());
+  h.stringsOffset = h.positionsOffset + positions.size() * sizeof(tbc::Position);
+  h.mainSubroutine = subIndex["main"];
+
+  size_t total = h.stringsOffset + h.stringsSize;
+  buffer.assign(total / sizeof(uint32_t), 0);
+  char *p = reinterpret_cast<char *>(buffer.data());
+  memcpy(p, &h, sizeof(h));
+  if (not subs.empty())
+    memcpy(p + h.subroutinesOffset, subs.data(), subs.size() * sizeof(tbc::Subroutine));
+  if (not vars.empty())
+    memcpy(p + h.varsOffset, vars.data(), vars.size() * sizeof(tbc::Var));
+  if (not instrs.empty())
+    memcpy(p + h.instrsOffset, instrs.data(), instrs.size() * sizeof(tbc::Instr));
+  if (not positions.empty())
+    memcpy(p + h.positionsOffset, positions.data(), positions.size() * sizeof(tbc::Position));
+  memcpy(p + h.stringsOffset, strings.data().data(), strings.data().size());
+  image = p;
+  return true;
+}
+
+/// write the image to a file
+bool BinaryCode::save(const string &fileName) const {
+  if (not image) return false;
+  ofstream out(fileName, ios::binary);
+  out.write(image, header().stringsOffset + header().stringsSize);
+  return bool(out);
+}
+
+/// map a .tbc file
+bool BinaryCode::load(const string &fileName, string &error) {
+  unmap();
+  buffer.clear();
+
+  int fd = open(fileName.c_str(), O_RDONLY);
+  if (fd < 0) {
+    error = "can not open " + fileName;
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 or size_t(st.st_size) < sizeof(tbc::Header)) {
+    close(fd);
+    error = fileName + " is not a binary t-code file";
+    return false;
+  }
+  mappedSize = st.st_size;
+  mapped = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapped == MAP_FAILED) {
+    mapped = nullptr;
+    error = "can not map " + fileName;
+    return false;
+  }
+  image = static_cast<const char *>(mapped);
+
+  // check the header and the bounds of everything the VM will trust
+  const tbc::Header &h = header();
+  error = "";
+  if (memcmp(h.magic, tbc::Magic, sizeof(h.magic)) != 0)
+    error = fileName + " is not a binary t-code file";
+  else if (h.version != tbc::Version)
+    error = fileName + ": unsupported version " + to_string(h.version) +
+            " (expected " + to_string(tbc::Version) + ")";
+  else if (h.subroutinesOffset + uint64_t(h.nSubroutines) * sizeof(tbc::Subroutine) > h.varsOffset or
+           h.varsOffset + uint64_t(h.nVars) * sizeof(tbc::Var) > h.instrsOffset or
+           h.instrsOffset + uint64_t(h.nInstrs) * sizeof(tbc::Instr) > h.positionsOffset or
+           h.positionsOffset + uint64_t(h.nInstrs) * sizeof(tbc::Position) > h.stringsOffset or
+           h.stringsOffset + uint64_t(h.stringsSize) > mappedSize or
+           h.subroutinesOffset % 4 != 0 or h.varsOffset % 4 != 0 or
+           h.instrsOffset % 4 != 0 or h.positionsOffset % 4 != 0 or h.stringsSize == 0 or
+           image[h.stringsOffset + h.stringsSize - 1] != '\0' or
+           h.mainSubroutine >= h.nSubroutines)
+    error = fileName + ": corrupted file";
+  for (uint32_t k = 0; error.empty() and k < h.nSubroutines; ++k) {
+    const tbc::Subroutine &s = get_subroutine(k);
+    bool ok = (s.name < h.stringsSize and
+               uint64_t(s.firstVar) + s.nParams + s.nVars <= h.nVars and
+               uint64_t(s.firstInstr) + s.nInstrs <= h.nInstrs and s.nInstrs > 0 and
+               instructions()[s.firstInstr + s.nInstrs - 1].oper == instruction::_RETURN);
+    for (uint32_t v = 0; ok and v < s.nParams + s.nVars; ++v) {
+      const tbc::Var &var = get_var(s.firstVar + v);
+      uint32_t cells = (v < s.nParams ? 1 : max(var.size, 1u));
+      ok = (var.name < h.stringsSize and uint64_t(var.slot) + cells <= s.frameSize);
+    }
+    for (uint32_t pc = s.firstInstr; ok and pc < s.firstInstr + s.nInstrs; ++pc) {
+      const tbc::Instr &in = instructions()[pc];
+      ok = (in.oper < instruction::_INVALID);
+      // each operand must be of a kind the VM expects in its place
+      ArgRole role[3];
+      if (ok) arg_roles(instruction::Operation(in.oper), role);
+      for (int a = 0; ok and a < 3; ++a) {
+        int32_t v = in.value[a];
+        ok = valid_kind(instruction::Operation(in.oper), role[a], in.kind[a]);
+        if (not ok) break;
+        switch (in.kind[a]) {
+        case tbc::NONE: case tbc::IMM: break;
+        case tbc::SLOT: case tbc::ADDR: ok = (v >= 0 and uint32_t(v) < s.frameSize); break;
+        case tbc::PC:   ok = (uint32_t(v) >= s.firstInstr and uint32_t(v) < s.firstInstr + s.nInstrs); break;
+        case tbc::SUB:  ok = (v >= 0 and uint32_t(v) < h.nSubroutines); break;
+        case tbc::STR:  ok = (v >= 0 and uint32_t(v) < h.stringsSize); break;
+        default:        ok = false;
+        }
+        ok = ok and in.text[a] < h.stringsSize;
+      }
+      // only the base of a local array is trusted, and all of it must be in the frame
+      if (ok and (in.oper == instruction::_XLOAD or in.oper == instruction::_LOADX)) {
+        int k = (in.oper == instruction::_XLOAD ? 0 : 1);
+        if (in.kind[k] != tbc::ADDR)
+          ok = (in.kind[k] == tbc::SLOT and in.bound != tbc::Unchecked);
+        else
+          ok = (in.bound != tbc::UnknownBound and
+                uint64_t(in.value[k]) + (in.bound & ~tbc::InRange) <= s.frameSize);
+      }
+    }
+    if (not ok) error = fileName + ": corrupted function " + to_string(k);
+  }
+  if (not error.empty()) {
+    unmap();
+    return false;
+  }
+  return true;
+}
+
+/// rebuild the text form of the program
+code BinaryCode::to_code() const {
+  code program;
+  const tbc::Header &h = header();
+  for (uint32_t k = 0; k < h.nSubroutines; ++k) {
+    const tbc::Subroutine &s = get_subroutine(k);
+    subroutine subr(get_string(s.name));
+    for (uint32_t v = 0; v < s.nParams; ++v)
+      subr.add_param(get_string(get_var(s.firstVar + v).name), get_var(s.firstVar + v).size);
+    for (uint32_t v = s.nParams; v < s.nParams + s.nVars; ++v)
+      subr.add_var(get_string(get_var(s.firstVar + v).name), get_var(s.firstVar + v).size);
+    instructionList lins;
+    for (uint32_t pc = s.firstInstr; pc < s.firstInstr + s.nInstrs; ++pc) {
+      const tbc::Instr &in = instructions()[pc];
+      lins.push_back(instruction(instruction::Operation(in.oper), get_string(in.text[0]),
+                                 get_string(in.text[1]), get_string(in.text[2])));
+      lins.back().line = get_position(pc).line;
+      lins.back().column = get_position(pc).column;
+      if (in.oper == instruction::_XLOAD or in.oper == instruction::_LOADX) {
+        if (in.bound != tbc::UnknownBound) {
+          lins.back().inRange = (in.bound == tbc::Unchecked or (in.bound & tbc::InRange));
+          lins.back().bound = in.bound & ~tbc::InRange;
+        }
+      }
+    }
+    subr.set_instructions(lins);
+    program.add_subroutine(subr);
+  }
+  return program;
+}
+
+/// access to the image
+const tbc::Header & BinaryCode::header() const {
+  return *reinterpret_cast<const tbc::Header *>(image);
+}
+const tbc::Subroutine & BinaryCode::get_subroutine(size_t i) const {
+  return reinterpret_cast<const tbc::Subroutine *>(image + header().subroutinesOffset)[i];
+}
+const tbc::Var & BinaryCode::get_var(size_t i) const {
+  return reinterpret_cast<const tbc::Var *>(image + header().varsOffset)[i];
+}
+const tbc::Instr * BinaryCode::instructions() const {
+  return reinterpret_cast<const tbc::Instr *>(image + header().instrsOffset);
+}
+const tbc::Position & BinaryCode::get_position(size_t pc) const {
+  return reinterpret_cast<const tbc::Position *>(image + header().positionsOffset)[pc];
+}
+string BinaryCode::position_string(size_t pc) const {
+  const tbc::Position &p = get_position(pc);
+  if (p.line == 0) return "?";
+  return to_string(p.line) + ":" + to_string(p.column);
+}
+const char * BinaryCode::get_string(uint32_t offset) const {
+  return image + header().stringsOffset + offset;
+}
+int BinaryCode::find_subroutine(const string &name) const {
+  for (uint32_t k = 0; k < header().nSubroutines; ++k)
+    if (name == get_string(get_subroutine(k).name)) return k;
+  return -1;
+}
+
+uint32_t BinaryCode::checksum() const {
+  uint32_t h = 2166136261u;
+  size_t size = header().stringsOffset + header().stringsSize;
+  for (size_t k = 0; k < size; ++k) h = (h ^ (unsigned char)image[k]) * 16777619u;
+  return h;
+}
@@ -0,0 +1,180 @@
+/////////////////////////////////////////////////////////////////
+//
+//    TVM - t-Code Virtual Machine
+//
+//    Copyright (C) 2017  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: Lluis Padro (padro@cs.upc.es)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.320 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <cstddef>    // std::size_t
+#include <cstdint>    // std::uint32_t ...
+
+#include "code.h"
+
+// using namespace std;
+
+
+////////////////////////////////////////////////////////////////////
+/// Binary t-code (.tbc). All the fields are 32-bit words in the byte
+/// order of the machine that wrote the file, and every section starts
+/// at a multiple of 4, so a mapped file can be used directly:
+///
+///    header | subroutines | vars (params first) | instructions | positions | strings
+///
+/// Names, labels and the text of the operands are offsets into the
+/// string table (offset 0 is the empty string). Besides its text, each
+/// operand is already resolved: frame slot, immediate value, target pc
+/// of a jump or index of the called subroutine (temporals that are
+/// never alive at the same time share a slot). The positions section
+/// has the source line and column of each instruction (line 0 if
+/// unknown).
+///
+/// Each xload and loadx has in 'bound' the number of cells of its
+/// array, and the VM checks the index against it. When asl has proved
+/// the index in range, InRange is added to the bound: the index is not
+/// checked, but a base read from a slot still is, since all of
+/// [base, base+bound) must be in the stack. Only a local array (a base
+/// in the frame) can be Unchecked, and an array of unknown size has
+/// UnknownBound (the access must just be in the stack). load rejects
+/// an unchecked base that is read from a slot, and a local array with
+/// no known bound or that does not fit in its frame.
+
+namespace tbc {
+
+  const char          Magic[4] = {'T', 'B', 'C', '\0'};
+  const std::uint32_t Version  = 8;
+
+  struct Header {
+    char          magic[4];
+    std::uint32_t version;
+    std::uint32_t nSubroutines, subroutinesOffset;
+    std::uint32_t nVars,        varsOffset;
+    std::uint32_t nInstrs,      instrsOffset;
+    std::uint32_t positionsOffset;  // nInstrs entries
+    std::uint32_t stringsSize,  stringsOffset;
+    std::uint32_t mainSubroutine;
+  };
+
+  struct Subroutine {
+    std::uint32_t name;
+    std::uint32_t nParams, nVars;   // params are the first vars
+    std::uint32_t firstVar;
+    std::uint32_t frameSize;        // params + vars + temporals
+    std::uint32_t firstInstr, nInstrs;
+  };
+
+  struct Var {
+    std::uint32_t name;
+    std::uint32_t size;             // cells (of a param: of the array it refers to, or 0)
+    std::uint32_t slot;             // position in the frame
+  };
+
+  /// how the value of an operand is obtained
+  typedef enum {NONE,     // no operand
+                SLOT,     // contents of a frame slot
+                ADDR,     // address of a frame slot (local arrays, &x)
+                IMM,      // immediate (int, char, or float bits)
+                PC,       // target of a jump (absolute instruction index)
+                SUB,      // index of a subroutine
+                STR       // string offset of the text to write
+               } OperandKind;
+
+  struct Position {
+    std::uint32_t line, column;
+  };
+
+  /// bound of an index that is not checked, or that can only be
+  /// checked to be inside the memory of the program
+  const std::uint32_t Unchecked    = 0;
+  const std::uint32_t UnknownBound = 0xFFFFFFFF;
+  /// added to a known bound when the index is proved to be in range:
+  /// only the base (if it is not a local array) is checked
+  const std::uint32_t InRange      = 0x80000000;
+
+  struct Instr {
+    std::uint8_t  oper;             // instruction::Operation
+    std::uint8_t  kind[3];          // OperandKind of each argument
+    std::int32_t  value[3];
+    std::uint32_t text[3];          // string offset of each argument
+    std::uint32_t bound;            // xload, loadx: cells of the array
+  };
+
+}  // namespace tbc
+
+
+////////////////////////////////////////////////////////////////////
+/// Class BinaryCode holds a program in binary t-code form. It is
+/// built from a 'code' object (resolving all names) or mapped from
+/// a .tbc file, and can be saved or turned back into 'code'.
+
+class BinaryCode {
+ public:
+  /// constructor and destructor
+  BinaryCode();
+  ~BinaryCode();
+  BinaryCode(const BinaryCode &) = delete;
+  BinaryCode & operator=(const BinaryCode &) = delete;
+
+  /// resolve and encode a program. Returns false (with a message in
+  /// 'error') if some name, label or subroutine can not be resolved
+  bool build(const code & program, std::string & error);
+  /// write the image to a file
+  bool save(const std::string & fileName) const;
+  /// map a .tbc file (read only). Returns false if it can not be
+  /// opened or has a wrong header
+  bool load(const std::string & fileName, std::string & error);
+
+  /// rebuild the text form of the program
+  code to_code() const;
+
+  /// access to the image
+  const tbc::Header & header() const;
+  const tbc::Subroutine & get_subroutine(std::size_t i) const;
+  const tbc::Var & get_var(std::size_t i) const;
+  const tbc::Instr * instructions() const;
+  /// source position of the instruction at (absolute) pc
+  const tbc::Position & get_position(std::size_t pc) const;
+  /// the same as "line:column" ("?" if unknown)
+  std::string position_string(std::size_t pc) const;
+  const char * get_string(std::uint32_t offset) const;
+  /// index of a subroutine by name (-1 if it does not exist)
+  int find_subroutine(const std::string & name) const;
+  /// checksum of the whole image (FNV-1a), to recognize a program
+  std::uint32_t checksum() const;
+
+ private:
+  /// image built in memory (empty if mapped)
+  std::vector<std::uint32_t> buffer;
+  /// mapped file
+  void *      mapped;
+  std::size_t mappedSize;
+  /// start of the image (buffer or mapped file)
+  const char *image;
+
+  void unmap();
+};
@@ -0,0 +1,230 @@
+/////////////////////////////////////////////////////////////////
+//
+//    TVM - t-Code Virtual Machine
+//
+//    Copyright (C) 2017  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: Lluis Padro (padro@cs.upc.es)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.320 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+////////////////////////////////////////////////////////////////
+
+#include "BufferedIO.h"
+
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include <cstdio>     // std::snprintf
+#include <cstdlib>    // std::strtof
+#include <cstring>    // std::memcpy
+#include <cctype>     // std::isspace, std::isdigit
+
+using namespace std;
+
+
+////////////////////////////////////////////////////////////////////
+/// Implementation for class 'OutputBuffer'
+
+/// constructor
+OutputBuffer::OutputBuffer(ostream &o, size_t size) : out(o), capacity(size), used(0) {}
+/// destructor
+OutputBuffer::~OutputBuffer() { flush(); }
+
+void OutputBuffer::reserve(size_t n) {
+  if (used + n <= buffer.size()) return;
+  out.write(buffer.data(), used);
+  used = 0;
+  // the buffer is only taken once something is written
+  if (n > buffer.size()) buffer.resize(max(n, capacity));
+}
+
+void OutputBuffer::flush() {
+  out.write(buffer.data(), used);
+  out.flush();
+  used = 0;
+}
+
+void OutputBuffer::put_int(int32_t v) {
+  reserve(12);
+  // digits from the last one, as an unsigned (INT_MIN has no opposite)
+  char digits[12];
+  int n = 0;
+  uint32_t u = (v < 0 ? 0u - uint32_t(v) : uint32_t(v));
+  do {
+    digits[n++] = '0' + u % 10;
+    u /= 10;
+  } while (u != 0);
+  if (v < 0) buffer[used++] = '-';
+  while (n > 0) buffer[used++] = digits[--n];
+}
+
+void OutputBuffer::put_float(float f) {
+  // the default format of an ostream is %g with 6 digits
+  reserve(32);
+  used += snprintf(&buffer[used], 32, "%g", double(f));
+}
+
+void OutputBuffer::put_char(char c) {
+  reserve(1);
+  buffer[used++] = c;
+}
+
+void OutputBuffer::put_string(const char *s, size_t n) {
+  reserve(n);
+  memcpy(&buffer[used], s, n);
+  used += n;
+}
+
+
+////////////////////////////////////////////////////////////////////
+/// Implementation for class 'InputBuffer'
+
+/// constructor
+InputBuffer::InputBuffer(istream &in) : buf(in.rdbuf()), failed(false), consumed(0) {}
+/// destructor
+InputBuffer::~InputBuffer() {}
+
+bool InputBuffer::has_input() const {
+  return buf->in_avail() > 0;
+}
+
+/// chars read, and whether a read has failed
+uint64_t InputBuffer::position() const { return consumed; }
+bool InputBuffer::has_failed() const { return failed; }
+
+void InputBuffer::restore(uint64_t position, bool fail) {
+  while (consumed < position and buf->sgetc() != EOF) next();
+  failed = fail;
+}
+
+int InputBuffer::next() {
+  ++consumed;
+  return buf->snextc();
+}
+
+bool InputBuffer::stop() {
+  failed = true;
+  return false;
+}
+
+bool InputBuffer::skip_blanks() {
+  int c = buf->sgetc();
+  while (c != EOF and isspace(c)) c = next();
+  return c != EOF;
+}
+
+bool InputBuffer::read_int(int32_t &v) {
+  v = 0;
+  if (failed or not skip_blanks()) return stop();
+  int c = buf->sgetc();
+  bool negative = (c == '-');
+  if (c == '-' or c == '+') c = next();
+  if (c == EOF or not isdigit(c)) return stop();
+  uint32_t u = 0;
+  while (c != EOF and isdigit(c)) {
+    u = 10*u + (c - '0');
+    c = next();
+  }
+  v = (negative ? int32_t(0u - u) : int32_t(u));
+  return true;
+}
+
+bool InputBuffer::read_float(float &f) {
+  f = 0;
+  if (failed or not skip_blanks()) return stop();
+  // the longest prefix that looks like a number: [+-]d*[.d*][e[+-]d+]
+  string text;
+  int c = buf->sgetc();
+  auto take = [&] () { text += char(c); c = next(); };
+  if (c == '-' or c == '+') take();
+  while (c != EOF and isdigit(c)) take();
+  if (c == '.') take();
+  while (c != EOF and isdigit(c)) take();
+  if (c == 'e' or c == 'E') {
+    take();
+    if (c == '-' or c == '+') take();
+    while (c != EOF and isdigit(c)) take();
+  }
+  char *end;
+  f = strtof(text.c_str(), &end);
+  if (text.empty() or end != text.c_str() + text.size()) {
+    f = 0;
+    return stop();
+  }
+  return true;
+}
+
+bool InputBuffer::read_char(char &c) {
+  c = 0;
+  if (failed or not skip_blanks()) return stop();
+  ++consumed;
+  c = char(buf->sbumpc());
+  return true;
+}
+
+
+////////////////////////////////////////////////////////////////////
+/// Implementation for classes 'HostInput' and 'HostOutput'
+
+/// constructors and destructors
+HostInput::HostInput(ReadFunction read) : istream(nullptr) {
+  buf.read = read;
+  buf.chars.resize(1 << 12);
+  rdbuf(&buf);
+}
+HostInput::~HostInput() {}
+
+void HostInput::set_function(ReadFunction read) {
+  buf.read = read;
+  buf.discard();
+  clear();
+}
+
+HostOutput::HostOutput(WriteFunction write) : ostream(nullptr) {
+  buf.write = write;
+  rdbuf(&buf);
+}
+HostOutput::~HostOutput() {}
+
+void HostOutput::set_function(WriteFunction write) {
+  buf.write = write;
+  clear();
+}
+
+HostInput::Buf::int_type HostInput::Buf::underflow() {
+  size_t n = (read ? read(chars.data(), chars.size()) : 0);
+  if (n == 0) return traits_type::eof();
+  setg(chars.data(), chars.data(), chars.data() + min(n, chars.size()));
+  return traits_type::to_int_type(*gptr());
+}
+
+streamsize HostOutput::Buf::xsputn(const char *s, streamsize n) {
+  if (write and n > 0) write(s, n);
+  return n;
+}
+
+HostOutput::Buf::int_type HostOutput::Buf::overflow(int_type c) {
+  if (c != traits_type::eof()) {
+    char ch = traits_type::to_char_type(c);
+    xsputn(&ch, 1);
+  }
+  return traits_type::not_eof(c);
+}
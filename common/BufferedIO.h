@@ -0,0 +1,156 @@
+/////////////////////////////////////////////////////////////////
+//
+//    TVM - t-Code Virtual Machine
+//
+//    Copyright (C) 2017  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: Lluis Padro (padro@cs.upc.es)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.320 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <streambuf>
+#include <functional>
+
+#include <cstddef>    // std::size_t
+#include <cstdint>    // std::int32_t
+
+// using namespace std;
+
+
+////////////////////////////////////////////////////////////////////
+/// Class OutputBuffer collects what a program writes in a large
+/// buffer, formatting the numbers itself, and hands it to the stream
+/// only when the buffer is full, on flush, or when it is destroyed.
+/// The text is the same that 'out << value' would write.
+
+class OutputBuffer {
+ public:
+  /// constructor and destructor (which flushes)
+  OutputBuffer(std::ostream &out, std::size_t size = 1 << 16);
+  ~OutputBuffer();
+  OutputBuffer(const OutputBuffer &) = delete;
+  OutputBuffer & operator=(const OutputBuffer &) = delete;
+
+  void put_int(std::int32_t v);
+  void put_float(float f);
+  void put_char(char c);
+  void put_string(const char *s, std::size_t n);
+  /// write the buffer to the stream (and flush it)
+  void flush();
+
+ private:
+  std::ostream &out;
+  std::vector<char> buffer;
+  std::size_t capacity;
+  std::size_t used;
+
+  /// make room for n more chars
+  void reserve(std::size_t n);
+};
+
+
+////////////////////////////////////////////////////////////////////
+/// Class InputBuffer parses the values a program reads directly from
+/// the buffer of the stream. The values are the same that 'in >> v'
+/// would read: blanks are skipped, and once a read fails (or the
+/// input ends) it and all the next ones give 0.
+
+class InputBuffer {
+ public:
+  /// constructor and destructor
+  InputBuffer(std::istream &in);
+  ~InputBuffer();
+
+  /// they return false if the value can not be read
+  bool read_int(std::int32_t &v);
+  bool read_float(float &f);
+  bool read_char(char &c);
+  /// true if the stream has input ready (reading it does not wait)
+  bool has_input() const;
+
+  /// chars read so far, and whether a read has failed
+  std::uint64_t position() const;
+  bool has_failed() const;
+  /// go on as if the first 'position' chars had been read, by
+  /// skipping them
+  void restore(std::uint64_t position, bool failed);
+
+ private:
+  std::streambuf *buf;
+  bool failed;
+  std::uint64_t consumed;
+
+  /// move to the next char and return it
+  int next();
+  /// a read has failed: it and the next ones give 0
+  bool stop();
+  /// skip blanks; false at the end of the input
+  bool skip_blanks();
+};
+
+
+////////////////////////////////////////////////////////////////////
+/// Classes HostInput and HostOutput are streams whose characters come
+/// from and go to functions of a host program that runs t-code in
+/// its own process, instead of stdin and stdout. The read function
+/// fills up to n chars and returns how many (0 at the end of the
+/// input). Without a function there is no input, and the output
+/// is lost. Both are called with large blocks, since the machine
+/// buffers what it reads and writes.
+
+typedef std::function<std::size_t (char *buf, std::size_t n)> ReadFunction;
+typedef std::function<void (const char *buf, std::size_t n)> WriteFunction;
+
+class HostInput : public std::istream {
+ public:
+  HostInput(ReadFunction read = ReadFunction());
+  ~HostInput();
+  /// read from another function (what was read and not used is lost)
+  void set_function(ReadFunction read);
+
+ private:
+  struct Buf : public std::streambuf {
+    ReadFunction read;
+    std::vector<char> chars;
+    void discard() { setg(nullptr, nullptr, nullptr); }
+    int_type underflow() override;
+  } buf;
+};
+
+class HostOutput : public std::ostream {
+ public:
+  HostOutput(WriteFunction write = WriteFunction());
+  ~HostOutput();
+  /// write to another function
+  void set_function(WriteFunction write);
+
+ private:
+  struct Buf : public std::streambuf {
+    WriteFunction write;
+    std::streamsize xsputn(const char *s, std::streamsize n) override;
+    int_type overflow(int_type c) override;
+  } buf;
+};
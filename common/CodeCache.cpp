@@ -0,0 +1,205 @@
+/////////////////////////////////////////////////////////////////
+//
+//    CodeCache - On-disk cache of the generated code of the
+//                functions of Asl programs
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+////////////////////////////////////////////////////////////////
+
+#include "CodeCache.h"
+
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iomanip>    // std::setw, std::setfill
+#include <thread>     // std::this_thread
+#include <functional> // std::hash
+
+#include <cstdio>     // std::rename, std::remove
+
+#include <unistd.h>   // getpid
+#include <sys/stat.h> // mkdir
+
+// using namespace std;
+
+
+// 64-bit FNV-1a of the parts, each one preceded by its length so
+// that ("ab","c") and ("a","bc") get different keys
+CodeCache::Key::Key() : Hash{14695981039346656037ULL} {
+}
+
+void CodeCache::Key::add(const std::string & part) {
+  std::string length = std::to_string(part.size()) + ":";
+  for (unsigned char c : length + part) {
+    Hash ^= c;
+    Hash *= 1099511628211ULL;
+  }
+}
+
+std::string CodeCache::Key::str() const {
+  std::ostringstream out;
+  out << std::hex << std::setw(16) << std::setfill('0') << Hash;
+  return out.str();
+}
+
+
+CodeCache::CodeCache(const std::string & directory) :
+  Directory{directory} {
+  ::mkdir(Directory.c_str(), 0777);
+}
+
+std::string CodeCache::fileName(const std::string & key) const {
+  return Directory + "/" + key + ".tcache";
+}
+
+bool CodeCache::lookup(const std::string & key, subroutine & subr) {
+  std::ifstream in(fileName(key));
+  std::string magic, storedKey;
+  unsigned int version = 0;
+  if (in >> magic >> version >> storedKey and magic == "tcache" and
+      version == Version and storedKey == key and read(in, subr)) {
+    ++Hits;
+    return true;
+  }
+  ++Misses;
+  return false;
+}
+
+// The file is written with a temporary name (unique to the process
+// and thread) and then renamed, so a compilation that reads it at the
+// same time never sees half of it
+bool CodeCache::store(const std::string & key, const subroutine & subr) {
+  std::string name = fileName(key);
+  std::size_t thread = std::hash<std::thread::id>()(std::this_thread::get_id());
+  std::string temporary = name + "." + std::to_string(::getpid()) + "." +
+                          std::to_string(thread);
+  {
+    std::ofstream out(temporary);
+    out << "tcache " << Version << " " << key << "\n";
+    write(out, subr);
+    if (not out) {
+      out.close();
+      std::remove(temporary.c_str());
+      return false;
+    }
+  }
+  if (std::rename(temporary.c_str(), name.c_str()) != 0) {
+    std::remove(temporary.c_str());
+    return false;
+  }
+  ++Stores;
+  return true;
+}
+
+std::size_t CodeCache::getHits() const {
+  return Hits;
+}
+
+std::size_t CodeCache::getMisses() const {
+  return Misses;
+}
+
+std::size_t CodeCache::getStores() const {
+  return Stores;
+}
+
+void CodeCache::printStats(std::ostream & out) const {
+  out << "cache " << Directory << ": " << Hits << " hits, " << Misses
+      << " misses, " << Stores << " stored" << std::endl;
+}
+
+void CodeCache::writeString(std::ostream & out, const std::string & s) {
+  out << s.size() << " " << s;
+}
+
+bool CodeCache::readString(std::istream & in, std::string & s) {
+  std::size_t size;
+  if (not (in >> size) or in.get() != ' ') return false;
+  s.resize(size);
+  return size == 0 or in.read(&s[0], size);
+}
+
+void CodeCache::write(std::ostream & out, const subroutine & subr) {
+  writeString(out, subr.get_name());
+  out << "\n" << subr.params.size() << "\n";
+  for (auto & p : subr.params) {
+    writeString(out, p.name);
+    out << " " << p.size << "\n";
+  }
+  out << subr.vars.size() << "\n";
+  for (auto & v : subr.vars) {
+    writeString(out, v.name);
+    out << " " << v.size << "\n";
+  }
+  const instructionList & lins = subr.get_instructions();
+  out << lins.size() << "\n";
+  for (auto & inst : lins) {
+    out << int(inst.oper) << " ";
+    writeString(out, inst.arg1);
+    out << " ";
+    writeString(out, inst.arg2);
+    out << " ";
+    writeString(out, inst.arg3);
+    out << " " << inst.line << " " << inst.column
+        << " " << inst.bound << " " << inst.inRange << "\n";
+  }
+}
+
+bool CodeCache::read(std::istream & in, subroutine & subr) {
+  std::string name;
+  std::size_t n;
+  if (not readString(in, name) or not (in >> n)) return false;
+  subroutine result(name);
+  for (std::size_t i = 0; i < n; ++i) {
+    std::size_t size;
+    if (not readString(in, name) or not (in >> size)) return false;
+    result.add_param(name, size);
+  }
+  if (not (in >> n)) return false;
+  for (std::size_t i = 0; i < n; ++i) {
+    std::size_t size;
+    if (not readString(in, name) or not (in >> size)) return false;
+    result.add_var(name, size);
+  }
+  if (not (in >> n)) return false;
+  instructionList lins;
+  for (std::size_t i = 0; i < n; ++i) {
+    int oper;
+    std::string a1, a2, a3;
+    unsigned int line, column, bound;
+    bool inRange;
+    if (not (in >> oper) or oper < 0 or oper >= int(instruction::_INVALID) or
+        not readString(in, a1) or not readString(in, a2) or not readString(in, a3) or
+        not (in >> line >> column >> bound >> inRange))
+      return false;
+    lins.push_back(instruction(instruction::Operation(oper), a1, a2, a3));
+    lins.back().line = line;
+    lins.back().column = column;
+    lins.back().bound = bound;
+    lins.back().inRange = inRange;
+  }
+  result.set_instructions(lins);
+  subr = result;
+  return true;
+}
@@ -0,0 +1,101 @@
+/////////////////////////////////////////////////////////////////
+//
+//    CodeCache - On-disk cache of the generated code of the
+//                functions of Asl programs
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include <cstddef>    // std::size_t
+#include <cstdint>    // std::uint64_t
+
+#include "code.h"
+
+// using namespace std;
+
+
+////////////////////////////////////////////////////////////////
+// Class CodeCache: keeps the code generated for each function in a
+// directory, one file per function, so that the functions that did
+// not change from one compilation to the next do not have to be
+// type checked and generated again. The files are named after a key
+// that hashes everything the code of the function depends on (its
+// source text and the signatures of the functions it calls), so a
+// changed function just gets a new key and misses the cache. The
+// cache counts its hits, misses and stores.
+
+class CodeCache {
+
+public:
+
+  // Builds the key of a function from the strings it depends on
+  class Key {
+  public:
+    Key ();
+    void add (const std::string & part);
+    std::string str () const;
+  private:
+    std::uint64_t Hash;
+  };
+
+  // Constructor (creates the directory if it does not exist)
+  CodeCache (const std::string & directory);
+
+  // Returns true and sets subr if there is code for the key
+  bool lookup (const std::string & key, subroutine & subr);
+  // Saves the code of a function under the key. Returns false if the
+  // file can not be written (the cache is only an optimization, so
+  // the compilation goes on)
+  bool store (const std::string & key, const subroutine & subr);
+
+  // Statistics
+  std::size_t getHits   () const;
+  std::size_t getMisses () const;
+  std::size_t getStores () const;
+  void printStats (std::ostream & out) const;
+
+private:
+
+  static const unsigned int Version = 8;
+
+  // Attributes
+  std::string Directory;
+  std::size_t Hits = 0, Misses = 0, Stores = 0;
+
+  std::string fileName (const std::string & key) const;
+
+  // Text form of a subroutine in the cache files. The strings are
+  // written with their length first, so they can hold any character
+  static void write (std::ostream & out, const subroutine & subr);
+  static bool read  (std::istream & in, subroutine & subr);
+  static void writeString (std::ostream & out, const std::string & s);
+  static bool readString  (std::istream & in, std::string & s);
+
+};  // class CodeCache
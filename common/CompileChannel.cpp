@@ -0,0 +1,197 @@
+/////////////////////////////////////////////////////////////////
+//
+//    CompileChannel - Messages between the asl compile server
+//                     and its clients
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+////////////////////////////////////////////////////////////////
+
+#include "CompileChannel.h"
+
+#include <string>
+#include <vector>
+#include <sstream>
+
+#include <cstring>    // std::strncpy
+#include <cerrno>
+
+#include <unistd.h>   // read, close, unlink
+#include <sys/socket.h>
+#include <sys/un.h>   // sockaddr_un
+
+// using namespace std;
+
+
+const char * const CompileChannel::DefaultSocket = "/tmp/asl.sock";
+
+namespace {
+
+  bool socketAddress(const std::string & path, sockaddr_un & addr,
+                     std::string & error) {
+    addr = sockaddr_un();
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+      error = "socket path too long: " + path;
+      return false;
+    }
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    return true;
+  }
+
+}
+
+int CompileChannel::listen(const std::string & path, std::string & error) {
+  sockaddr_un addr;
+  if (not socketAddress(path, addr, error)) return -1;
+  int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    error = std::string("socket: ") + std::strerror(errno);
+    return -1;
+  }
+  ::unlink(path.c_str());
+  if (::bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 or
+      ::listen(fd, SOMAXCONN) < 0) {
+    error = "cannot listen at " + path + ": " + std::strerror(errno);
+    ::close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+int CompileChannel::connect(const std::string & path, std::string & error) {
+  sockaddr_un addr;
+  if (not socketAddress(path, addr, error)) return -1;
+  int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    error = std::string("socket: ") + std::strerror(errno);
+    return -1;
+  }
+  if (::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+    error = "cannot connect to " + path + ": " + std::strerror(errno);
+    ::close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+CompileChannel::CompileChannel(int fd) : Fd{fd} {
+}
+
+CompileChannel::~CompileChannel() {
+  if (Fd >= 0) ::close(Fd);
+}
+
+bool CompileChannel::sendRequest(const CompileRequest & request) {
+  std::ostringstream message;
+  message << "request " << request.args.size();
+  for (auto & arg : request.args) message << " " << arg.size();
+  message << " " << request.source.size() << "\n";
+  for (auto & arg : request.args) message << arg;
+  message << request.source;
+  return writeAll(message.str());
+}
+
+bool CompileChannel::receiveRequest(CompileRequest & request) {
+  std::vector<std::size_t> fields;
+  // (fields[0] + 2 could overflow)
+  if (not readHeader("request", fields) or fields.size() < 2 or
+      fields.size() - 2 != fields[0])
+    return false;
+  request.args.assign(fields[0], "");
+  for (std::size_t i = 0; i < fields[0]; ++i)
+    if (not readBytes(fields[i+1], request.args[i])) return false;
+  return readBytes(fields.back(), request.source);
+}
+
+bool CompileChannel::sendReply(const CompileReply & reply) {
+  std::ostringstream message;
+  message << "reply " << reply.status << " " << reply.out.size() << " "
+          << reply.err.size() << "\n" << reply.out << reply.err;
+  return writeAll(message.str());
+}
+
+bool CompileChannel::receiveReply(CompileReply & reply) {
+  std::vector<std::size_t> fields;
+  if (not readHeader("reply", fields) or fields.size() != 3) return false;
+  reply.status = int(fields[0]);
+  return readBytes(fields[1], reply.out) and readBytes(fields[2], reply.err);
+}
+
+// MSG_NOSIGNAL: a client that goes away must not kill the server
+bool CompileChannel::writeAll(const std::string & data) {
+  std::size_t done = 0;
+  while (done < data.size()) {
+    ssize_t n = ::send(Fd, data.data() + done, data.size() - done, MSG_NOSIGNAL);
+    if (n < 0 and errno == EINTR) continue;
+    if (n <= 0) return false;
+    done += n;
+  }
+  return true;
+}
+
+bool CompileChannel::fill() {
+  if (Pos > 0) {
+    Buffer.erase(0, Pos);
+    Pos = 0;
+  }
+  char chunk[64*1024];
+  ssize_t n;
+  do n = ::read(Fd, chunk, sizeof(chunk));
+  while (n < 0 and errno == EINTR);
+  if (n <= 0) return false;
+  Buffer.append(chunk, n);
+  return true;
+}
+
+bool CompileChannel::readLine(std::string & line) {
+  std::size_t end;
+  while ((end = Buffer.find('\n', Pos)) == std::string::npos) {
+    if (Buffer.size() - Pos > MaxHeader or not fill()) return false;
+  }
+  line = Buffer.substr(Pos, end - Pos);
+  Pos = end + 1;
+  return true;
+}
+
+bool CompileChannel::readBytes(std::size_t n, std::string & bytes) {
+  if (n > MaxMessage) return false;
+  while (Buffer.size() - Pos < n)
+    if (not fill()) return false;
+  bytes = Buffer.substr(Pos, n);
+  Pos += n;
+  return true;
+}
+
+bool CompileChannel::readHeader(const std::string & tag,
+                                std::vector<std::size_t> & fields) {
+  std::string line;
+  if (not readLine(line)) return false;
+  std::istringstream in(line);
+  std::string word;
+  if (not (in >> word) or word != tag) return false;
+  fields.clear();
+  std::size_t value;
+  while (in >> value) fields.push_back(value);
+  return in.eof();
+}
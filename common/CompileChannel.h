@@ -0,0 +1,111 @@
+/////////////////////////////////////////////////////////////////
+//
+//    CompileChannel - Messages between the asl compile server
+//                     and its clients
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <cstddef>    // std::size_t
+
+// using namespace std;
+
+
+////////////////////////////////////////////////////////////////
+// A request to the compile server: the options of asl (as in its
+// command line, but without the input file) and the source text.
+// The reply has what asl would have written to the standard output
+// and error, and its exit status.
+
+struct CompileRequest {
+  std::vector<std::string> args;
+  std::string              source;
+};
+
+struct CompileReply {
+  int         status = 0;
+  std::string out;
+  std::string err;
+};
+
+
+////////////////////////////////////////////////////////////////
+// Class CompileChannel: one end of a connection (a Unix socket)
+// between the compile server and a client, that can send and
+// receive any number of requests and replies. Each message is a
+// header line with the lengths of its strings, followed by them:
+//
+//    request <#args> <length of arg 1> ... <length of source>\n...
+//    reply <status> <length of out> <length of err>\n...
+
+class CompileChannel {
+
+public:
+
+  // Socket used when none is given
+  static const char * const DefaultSocket;
+
+  // Create a socket listening at path (removing an old one), or
+  // connect to it. Return the descriptor, or -1 (and a message in
+  // 'error') if it fails
+  static int listen  (const std::string & path, std::string & error);
+  static int connect (const std::string & path, std::string & error);
+
+  // Constructor: the channel owns the descriptor, and closes it
+  CompileChannel (int fd);
+  ~CompileChannel ();
+  CompileChannel (const CompileChannel &) = delete;
+  CompileChannel & operator= (const CompileChannel &) = delete;
+
+  // Each one returns false if the connection is closed or the
+  // message is malformed
+  bool sendRequest    (const CompileRequest & request);
+  bool receiveRequest (CompileRequest & request);
+  bool sendReply      (const CompileReply & reply);
+  bool receiveReply   (CompileReply & reply);
+
+private:
+
+  // Limits of a message, against broken or hostile peers
+  static const std::size_t MaxHeader  = 64*1024;
+  static const std::size_t MaxMessage = 256*1024*1024;
+
+  // Attributes
+  int         Fd;
+  std::string Buffer;    // received and not yet consumed
+  std::size_t Pos = 0;
+
+  bool writeAll  (const std::string & data);
+  bool fill      ();
+  bool readLine  (std::string & line);
+  bool readBytes (std::size_t n, std::string & bytes);
+  // Reads the header line: the tag and the numbers after it
+  bool readHeader (const std::string & tag, std::vector<std::size_t> & fields);
+
+};  // class CompileChannel
@@ -0,0 +1,893 @@
+/////////////////////////////////////////////////////////////////
+//
+//    Optimizer - Transformations on the generated t-code
+//                for the Asl programming language
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+////////////////////////////////////////////////////////////////
+
+#include "Optimizer.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <algorithm>
+#include <iterator>   // std::inserter
+
+#include <cctype>     // std::isdigit
+#include <cstddef>    // std::size_t
+#include <cstdint>    // INT32_MIN, INT32_MAX
+#include <cstdlib>    // std::strtoll
+
+// using namespace std;
+
+
+const std::string Optimizer::TailCallLabel = "tailcall";
+
+// Apply all the transformations to every subroutine of the program
+void Optimizer::optimize(code & program) const {
+  for (auto & subr : program.get_subroutines()) {
+    tailCallElimination(subr);
+    peephole(subr);
+    rangeAnalysis(subr);
+  }
+}
+
+// ----------------------------------------------------------------------
+// Tail call elimination. A self-recursive call like
+//     pushparam
+//     pushparam %4            ;;; arguments
+//     call f
+//     popparam
+//     popparam %5             ;;; result
+//     r = %5  ...  _result = r
+//     return
+// is rewritten as
+//     %9 = %4                 ;;; arguments
+//     n = %9                  ;;; parameters
+//     goto tailcall
+// where 'tailcall' labels the first instruction of f.
+
+void Optimizer::tailCallElimination(subroutine & subr) const {
+  const instructionList & lins = subr.get_instructions();
+  if (lins.empty()) return;
+
+  // parameters receiving the arguments (all but '_result')
+  std::vector<std::string> argParams;
+  for (auto & p : subr.params) {
+    if (p.name != "_result") argParams.push_back(p.name);
+  }
+
+  std::map<std::string, std::size_t> labels;
+  for (std::size_t pc = 0; pc < lins.size(); ++pc) {
+    if (lins[pc].oper == instruction::_LABEL) labels[lins[pc].arg1] = pc;
+  }
+  // restart at the label of the first instruction (if there is one)
+  std::string entry = TailCallLabel;
+  if (lins[0].oper == instruction::_LABEL) entry = lins[0].arg1;
+
+  std::vector<bool> removed(lins.size(), false);
+  std::map<std::size_t, instructionList> replaced;
+  int lastTemp = maxTempNumber(lins);
+  for (std::size_t pc = 0; pc < lins.size(); ++pc) {
+    if (lins[pc].oper != instruction::_CALL or lins[pc].arg1 != subr.get_name())
+      continue;
+    bool resultPopped;
+    if (not isTailPosition(lins, labels, argParams.size(), pc, resultPopped))
+      continue;
+    std::size_t first = (resultPopped ? 1 : 0);
+    std::vector<std::size_t> pushes;
+    if (not findCallPushes(lins, pc, argParams.size() + first, pushes))
+      continue;
+    if (resultPopped and not lins[pushes[0]].arg1.empty())
+      continue;
+
+    // Arguments are kept in new temporals until all of them are
+    // evaluated, since their computation may use the parameters
+    instructionList assign;
+    for (std::size_t i = first; i < pushes.size(); ++i) {
+      std::string temp = "%" + std::to_string(++lastTemp);
+      replaced[pushes[i]] = instruction::LOAD(temp, lins[pushes[i]].arg1);
+      replaced[pushes[i]].set_position(lins[pushes[i]].line, lins[pushes[i]].column);
+      assign = assign || instruction::LOAD(argParams[i - first], temp);
+    }
+    if (resultPopped) removed[pushes[0]] = true;
+    replaced[pc] = assign || instruction::UJUMP(entry);
+    replaced[pc].set_position(lins[pc].line, lins[pc].column);
+    // the rest of the straight-line code after the call is dead now
+    for (std::size_t k = pc + 1;
+         k < lins.size() and lins[k].oper != instruction::_LABEL; ++k)
+      removed[k] = true;
+  }
+  if (replaced.empty()) return;
+
+  instructionList code;
+  if (lins[0].oper != instruction::_LABEL) {
+    code = instruction::LABEL(entry);
+    code.set_position(lins[0].line, lins[0].column);
+  }
+  for (std::size_t pc = 0; pc < lins.size(); ++pc) {
+    auto it = replaced.find(pc);
+    if (it != replaced.end()) code = code || it->second;
+    else if (not removed[pc]) code.push_back(lins[pc]);
+  }
+  subr.set_instructions(code);
+}
+
+bool Optimizer::isTailPosition(const instructionList & lins,
+                               const std::map<std::string, std::size_t> & labels,
+                               std::size_t nArgs, std::size_t pc,
+                               bool & resultPopped) {
+  std::size_t k = pc + 1;
+  for (std::size_t i = 0; i < nArgs; ++i, ++k) {
+    if (k >= lins.size() or lins[k].oper != instruction::_POP or
+        not lins[k].arg1.empty())
+      return false;
+  }
+  // addresses currently holding the result of the call
+  std::set<std::string> holders;
+  resultPopped = (k < lins.size() and lins[k].oper == instruction::_POP and
+                  not lins[k].arg1.empty());
+  if (resultPopped) holders.insert(lins[k++].arg1);
+
+  bool resultSet = false;
+  // follow the execution (jumps included) until the return
+  for (std::size_t steps = 0; k < lins.size() and steps <= lins.size(); ++steps) {
+    const instruction & inst = lins[k];
+    if (inst.oper == instruction::_RETURN) {
+      return (not resultPopped or resultSet);
+    }
+    else if (inst.oper == instruction::_LABEL) {
+      ++k;
+    }
+    else if (inst.oper == instruction::_UJUMP) {
+      auto it = labels.find(inst.arg1);
+      if (it == labels.end()) return false;
+      k = it->second;
+    }
+    else if (isCopy(inst)) {
+      if (inst.arg1 == "_result")
+        resultSet = (holders.count(inst.arg2) > 0);
+      else if (holders.count(inst.arg2) > 0)
+        holders.insert(inst.arg1);
+      else
+        holders.erase(inst.arg1);
+      ++k;
+    }
+    else {
+      return false;
+    }
+  }
+  return false;
+}
+
+bool Optimizer::findCallPushes(const instructionList & lins, std::size_t pc,
+                               std::size_t nPushes, std::vector<std::size_t> & pushes) {
+  // going backwards, the pushparam/popparam of nested calls are balanced
+  int depth = 0;
+  for (std::size_t j = pc; j > 0 and pushes.size() < nPushes; --j) {
+    const instruction & inst = lins[j - 1];
+    switch (inst.oper) {
+    case instruction::_LABEL:
+    case instruction::_UJUMP:
+    case instruction::_FJUMP:
+    case instruction::_RETURN:
+      return false;
+    case instruction::_ALOAD:
+      // the address of a local would point into the reused frame
+      if (depth == 0) return false;
+      break;
+    case instruction::_POP:
+      ++depth;
+      break;
+    case instruction::_PUSH:
+      if (depth > 0) --depth;
+      else pushes.push_back(j - 1);
+      break;
+    default:
+      break;
+    }
+  }
+  if (pushes.size() != nPushes) return false;
+  std::reverse(pushes.begin(), pushes.end());
+  return true;
+}
+
+// ----------------------------------------------------------------------
+// Peephole optimization. The rules on windows of consecutive
+// instructions are kept in a table; 'locals' are the temporals given
+// by localTemporals (their value may be changed or not computed at
+// all as long as the instruction reading them is updated too).
+
+namespace {
+
+  typedef bool (*PeepholeRewrite) (const instruction * w,
+                                   const std::set<std::string> & locals,
+                                   instructionList & repl);
+
+  struct PeepholeRule {
+    const char *    name;
+    std::size_t     size;     // number of instructions in the window
+    PeepholeRewrite rewrite;
+  };
+
+  // returns true if inst is a comparison whose negation is another
+  // comparison with the operands swapped: not (a < b) == (b <= a)
+  bool isInvertible (const instruction & inst) {
+    return (inst.oper == instruction::_LT  or inst.oper == instruction::_LE or
+            inst.oper == instruction::_FLT or inst.oper == instruction::_FLE);
+  }
+
+  instruction invertCompare (const instruction & inst, const std::string & dest) {
+    switch (inst.oper) {
+    case instruction::_LT:  return instruction::LE(dest, inst.arg3, inst.arg2);
+    case instruction::_LE:  return instruction::LT(dest, inst.arg3, inst.arg2);
+    case instruction::_FLT: return instruction::FLE(dest, inst.arg3, inst.arg2);
+    default:                return instruction::FLT(dest, inst.arg3, inst.arg2);
+    }
+  }
+
+  // %1 = a <= b ; %1 = not %1   =>   %1 = b < a
+  bool notOfCompare (const instruction * w, const std::set<std::string> & locals,
+                     instructionList & repl) {
+    if (not isInvertible(w[0]) or w[1].oper != instruction::_NOT or
+        w[1].arg2 != w[0].arg1)
+      return false;
+    if (w[1].arg1 != w[0].arg1 and locals.count(w[0].arg1) == 0)
+      return false;
+    repl = invertCompare(w[0], w[1].arg1);
+    return true;
+  }
+
+  // %1 = not a ; %2 = not %1   =>   %2 = a
+  bool notOfNot (const instruction * w, const std::set<std::string> & locals,
+                 instructionList & repl) {
+    if (w[0].oper != instruction::_NOT or w[1].oper != instruction::_NOT or
+        w[1].arg2 != w[0].arg1 or w[0].arg2 == w[0].arg1)
+      return false;
+    if (w[1].arg1 != w[0].arg1 and locals.count(w[0].arg1) == 0)
+      return false;
+    if (w[1].arg1 != w[0].arg2)
+      repl = instruction::LOAD(w[1].arg1, w[0].arg2);
+    return true;
+  }
+
+  // %1 = a < b ; ifFalse %1 goto L1 ; goto L2 ; label L1
+  //     =>   %1 = b <= a ; ifFalse %1 goto L2 ; label L1
+  // %1 = not %2 ; ifFalse %1 goto L1 ; goto L2 ; label L1
+  //     =>   ifFalse %2 goto L2 ; label L1
+  bool branchOverJump (const instruction * w, const std::set<std::string> & locals,
+                       instructionList & repl) {
+    if (w[1].oper != instruction::_FJUMP or w[2].oper != instruction::_UJUMP or
+        w[3].oper != instruction::_LABEL or w[1].arg2 != w[3].arg1 or
+        w[1].arg1 != w[0].arg1 or locals.count(w[0].arg1) == 0)
+      return false;
+    if (isInvertible(w[0]))
+      repl = invertCompare(w[0], w[0].arg1) ||
+             instruction::FJUMP(w[0].arg1, w[2].arg1);
+    else if (w[0].oper == instruction::_NOT)
+      repl = instruction::FJUMP(w[0].arg2, w[2].arg1);
+    else
+      return false;
+    repl = repl || w[3];
+    return true;
+  }
+
+  // goto L ; label L   =>   label L
+  // ifFalse a goto L ; label L   =>   label L
+  bool jumpToNext (const instruction * w, const std::set<std::string> &,
+                   instructionList & repl) {
+    if ((w[0].oper != instruction::_UJUMP and w[0].oper != instruction::_FJUMP) or
+        w[1].oper != instruction::_LABEL)
+      return false;
+    std::string target = (w[0].oper == instruction::_UJUMP ? w[0].arg1 : w[0].arg2);
+    if (target != w[1].arg1)
+      return false;
+    repl = w[1];
+    return true;
+  }
+
+  const std::vector<PeepholeRule> PeepholeTable = {
+    { "branch-over-jump", 4, branchOverJump },
+    { "not-of-compare",   2, notOfCompare   },
+    { "not-of-not",       2, notOfNot       },
+    { "jump-to-next",     2, jumpToNext     },
+  };
+
+}  // namespace
+
+void Optimizer::peephole(subroutine & subr) const {
+  instructionList lins = subr.get_instructions();
+  bool changed = false;
+  bool again = true;
+  while (again) {
+    again = applyPeepholeTable(lins);
+    again = threadJumps(lins)        or again;
+    again = removeUnreachable(lins)  or again;
+    again = removeUnusedLabels(lins) or again;
+    changed = changed or again;
+  }
+  if (changed) subr.set_instructions(lins);
+}
+
+bool Optimizer::applyPeepholeTable(instructionList & lins) {
+  std::set<std::string> locals = localTemporals(lins);
+  instructionList code;
+  bool changed = false;
+  std::size_t pc = 0;
+  while (pc < lins.size()) {
+    bool matched = false;
+    for (auto & rule : PeepholeTable) {
+      instructionList repl;
+      if (pc + rule.size <= lins.size() and
+          rule.rewrite(&lins[pc], locals, repl)) {
+        // the new instructions come from the first one of the window
+        repl.set_position(lins[pc].line, lins[pc].column);
+        code = code || repl;
+        pc += rule.size;
+        matched = true;
+        break;
+      }
+    }
+    if (not matched) code.push_back(lins[pc++]);
+    changed = changed or matched;
+  }
+  if (changed) lins = code;
+  return changed;
+}
+
+// A jump to a label followed by 'goto L' goes directly to L, and a
+// 'goto' to a label followed by 'return' becomes a 'return'
+bool Optimizer::threadJumps(instructionList & lins) {
+  std::map<std::string, std::size_t> labels;
+  for (std::size_t pc = 0; pc < lins.size(); ++pc) {
+    if (lins[pc].oper == instruction::_LABEL) labels[lins[pc].arg1] = pc;
+  }
+  // first instruction executed after jumping to label
+  auto target = [&] (const std::string & label) -> std::size_t {
+    std::size_t pc = labels.at(label);
+    while (pc < lins.size() and lins[pc].oper == instruction::_LABEL) ++pc;
+    return pc;
+  };
+
+  bool changed = false;
+  for (auto & inst : lins) {
+    if (inst.oper != instruction::_UJUMP and inst.oper != instruction::_FJUMP)
+      continue;
+    std::string & label = (inst.oper == instruction::_UJUMP ? inst.arg1 : inst.arg2);
+    if (labels.count(label) == 0) continue;
+    // follow the chain (at most one step per label, to stop on cycles)
+    for (std::size_t steps = 0; steps < labels.size(); ++steps) {
+      std::size_t pc = target(label);
+      if (pc >= lins.size() or lins[pc].oper != instruction::_UJUMP or
+          lins[pc].arg1 == label or labels.count(lins[pc].arg1) == 0)
+        break;
+      label = lins[pc].arg1;
+      changed = true;
+    }
+    if (inst.oper == instruction::_UJUMP) {
+      std::size_t pc = target(label);
+      if (pc < lins.size() and lins[pc].oper == instruction::_RETURN) {
+        instruction ret = instruction::RETURN();
+        ret.line = inst.line;
+        ret.column = inst.column;
+        inst = ret;
+        changed = true;
+      }
+    }
+  }
+  return changed;
+}
+
+// Nothing after a 'goto' or a 'return' is executed until the next label
+bool Optimizer::removeUnreachable(instructionList & lins) {
+  instructionList code;
+  bool reachable = true;
+  for (auto & inst : lins) {
+    if (inst.oper == instruction::_LABEL) reachable = true;
+    if (reachable) code.push_back(inst);
+    if (inst.oper == instruction::_UJUMP or inst.oper == instruction::_RETURN)
+      reachable = false;
+  }
+  bool changed = (code.size() != lins.size());
+  if (changed) lins = code;
+  return changed;
+}
+
+bool Optimizer::removeUnusedLabels(instructionList & lins) {
+  std::set<std::string> used;
+  for (auto & inst : lins) {
+    if (inst.oper == instruction::_UJUMP) used.insert(inst.arg1);
+    else if (inst.oper == instruction::_FJUMP) used.insert(inst.arg2);
+  }
+  instructionList code;
+  for (auto & inst : lins) {
+    if (inst.oper != instruction::_LABEL or used.count(inst.arg1) > 0)
+      code.push_back(inst);
+  }
+  bool changed = (code.size() != lins.size());
+  if (changed) lins = code;
+  return changed;
+}
+
+// ----------------------------------------------------------------------
+// Range analysis. An abstract interpretation of the subroutine where
+// the state before each instruction gives an interval of values for
+// the integer addresses (those not given may have any value), plus
+// the comparisons whose result is held in a temporal. On each edge of
+// an 'ifFalse' the comparison narrows the intervals of its operands,
+// so in
+//     i = 0
+//     %1 = i < 10 ; ifFalse %1 goto endwhile1
+//     label loop2
+//     ...  %4 = %2 * i ; %5 = a[%4] ...
+//     i = i + 1
+//     %1 = i < 10 ; ifFalse %1 goto endwhile1 ; goto loop2
+// i is in [0, 9] inside the loop. At the labels the intervals are
+// widened to the next constant of the subroutine (and then to the
+// limits of an int), and once the iteration is stable a few rounds
+// without widening narrow them again. The integers wrap around, so
+// an operation that may overflow gives any value.
+//
+// Only the addresses whose address is never taken (with '&') are
+// followed; the other subroutines can only write this frame through
+// an array index, which is always checked or proved in range.
+
+namespace {
+
+  const long long MinInt = INT32_MIN, MaxInt = INT32_MAX;
+
+  struct Range {
+    long long lo, hi;
+    bool operator== (const Range & r) const { return lo == r.lo and hi == r.hi; }
+  };
+  const Range AnyValue = {MinInt, MaxInt};
+
+  // the value of a temporal is 'a oper b' (or its negation)
+  struct Condition {
+    instruction::Operation oper;    // _LT, _LE or _EQ
+    std::string a, b;
+    bool negated;
+    bool operator== (const Condition & c) const {
+      return oper == c.oper and a == c.a and b == c.b and negated == c.negated;
+    }
+  };
+
+  struct RangeState {
+    bool reachable = false;
+    std::map<std::string, Range>     ranges;
+    std::map<std::string, Condition> conditions;
+    bool operator== (const RangeState & s) const {
+      return reachable == s.reachable and ranges == s.ranges and
+             conditions == s.conditions;
+    }
+  };
+
+  // how the execution goes from an instruction to the next one
+  typedef enum {STEP, COND_TRUE, COND_FALSE} EdgeKind;
+  struct Edge {
+    std::size_t to;
+    EdgeKind    kind;
+  };
+
+  bool intConstant (const std::string & arg, long long & value) {
+    if (arg.empty() or not (std::isdigit(arg[0]) or arg[0] == '-' or arg[0] == '+'))
+      return false;
+    char *end;
+    value = std::strtoll(arg.c_str(), &end, 10);
+    return *end == '\0' and value >= MinInt and value <= MaxInt;
+  }
+
+  // interval of a result that has to fit in an int
+  Range fit (long long lo, long long hi) {
+    if (lo < MinInt or hi > MaxInt) return AnyValue;
+    return {lo, hi};
+  }
+
+  class RangeAnalysis {
+  public:
+    RangeAnalysis (const instructionList & lins) : lins(lins) {
+      std::map<std::string, std::size_t> labels;
+      for (std::size_t pc = 0; pc < lins.size(); ++pc) {
+        const instruction & inst = lins[pc];
+        if (inst.oper == instruction::_LABEL) labels[inst.arg1] = pc;
+        if (inst.oper == instruction::_ALOAD) untracked.insert(inst.arg2);
+        // limits for the widening
+        long long c;
+        for (const std::string * arg : {&inst.arg1, &inst.arg2, &inst.arg3})
+          if (intConstant(*arg, c))
+            for (long long t : {c - 1, c, c + 1}) thresholds.insert(t);
+        if (inst.bound > 0)
+          for (long long t : {0LL, (long long)(inst.bound) - 1})
+            thresholds.insert(t);
+      }
+      thresholds.insert(MinInt);
+      thresholds.insert(MaxInt);
+      edges.resize(lins.size());
+      for (std::size_t pc = 0; pc < lins.size(); ++pc) {
+        const instruction & inst = lins[pc];
+        if (inst.oper == instruction::_RETURN) continue;
+        if (inst.oper == instruction::_UJUMP) {
+          auto it = labels.find(inst.arg1);
+          if (it != labels.end()) edges[pc].push_back({it->second, STEP});
+          continue;
+        }
+        if (inst.oper == instruction::_FJUMP) {
+          auto it = labels.find(inst.arg2);
+          if (it != labels.end()) edges[pc].push_back({it->second, COND_FALSE});
+          if (pc + 1 < lins.size()) edges[pc].push_back({pc + 1, COND_TRUE});
+          continue;
+        }
+        if (pc + 1 < lins.size()) edges[pc].push_back({pc + 1, STEP});
+      }
+    }
+
+    // computes the state before each instruction. Returns false if
+    // it does not converge (then nothing can be assumed)
+    bool run () {
+      std::size_t n = lins.size();
+      before.assign(n, RangeState());
+      if (n == 0) return true;
+      before[0].reachable = true;
+      std::set<std::size_t> pending = {0};
+      for (std::size_t steps = 0; not pending.empty(); ++steps) {
+        if (steps > 100 * n) return false;
+        std::size_t pc = *pending.begin();
+        pending.erase(pending.begin());
+        for (auto & e : edges[pc]) {
+          RangeState out = after(pc, e);
+          if (not out.reachable) continue;
+          RangeState next = join(before[e.to], out);
+          if (lins[e.to].oper == instruction::_LABEL and before[e.to].reachable)
+            next = widen(before[e.to], next);
+          if (not (next == before[e.to])) {
+            before[e.to] = next;
+            pending.insert(e.to);
+          }
+        }
+      }
+      // narrowing
+      std::vector<std::vector<std::pair<std::size_t, Edge>>> preds(n);
+      for (std::size_t pc = 0; pc < n; ++pc)
+        for (auto & e : edges[pc]) preds[e.to].push_back({pc, e});
+      for (int round = 0; round < 4; ++round) {
+        bool changed = false;
+        for (std::size_t pc = 0; pc < n; ++pc) {
+          RangeState state;
+          state.reachable = (pc == 0);
+          for (auto & p : preds[pc])
+            if (before[p.first].reachable) state = join(state, after(p.first, p.second));
+          if (not (state == before[pc])) {
+            before[pc] = state;
+            changed = true;
+          }
+        }
+        if (not changed) break;
+      }
+      return true;
+    }
+
+    // true if the index of the xload/loadx in pc is within its bound
+    bool indexInRange (std::size_t pc) const {
+      const instruction & inst = lins[pc];
+      if (inst.bound == 0 or not before[pc].reachable) return false;
+      const std::string & index = (inst.oper == instruction::_XLOAD ? inst.arg2 : inst.arg3);
+      Range r = rangeOf(before[pc], index);
+      return r.lo >= 0 and r.hi < (long long)(inst.bound);
+    }
+
+  private:
+    const instructionList & lins;
+    std::set<std::string> untracked;
+    std::set<long long> thresholds;
+    std::vector<std::vector<Edge>> edges;
+    std::vector<RangeState> before;
+
+    Range rangeOf (const RangeState & s, const std::string & arg) const {
+      long long c;
+      if (intConstant(arg, c)) return {c, c};
+      auto it = s.ranges.find(arg);
+      return (it == s.ranges.end() ? AnyValue : it->second);
+    }
+
+    void setRange (RangeState & s, const std::string & addr, Range r) const {
+      long long c;
+      if (addr.empty() or intConstant(addr, c) or untracked.count(addr)) return;
+      if (r == AnyValue) s.ranges.erase(addr);
+      else s.ranges[addr] = r;
+    }
+
+    // forget the comparisons that depend on addr
+    static void forget (RangeState & s, const std::string & addr) {
+      s.conditions.erase(addr);
+      for (auto it = s.conditions.begin(); it != s.conditions.end(); ) {
+        if (it->second.a == addr or it->second.b == addr) it = s.conditions.erase(it);
+        else ++it;
+      }
+    }
+
+    // state after the instruction in pc, going through edge e
+    RangeState after (std::size_t pc, const Edge & e) const {
+      RangeState s = before[pc];
+      const instruction & inst = lins[pc];
+      Range a = rangeOf(s, inst.arg2), b = rangeOf(s, inst.arg3);
+      bool hasCondition = false;
+      Condition cond;
+      Range result = AnyValue;
+      switch (inst.oper) {
+      case instruction::_FJUMP:
+        restrict(s, inst.arg1, e.kind == COND_TRUE);
+        return s;
+      case instruction::_CLOAD:
+        // may write anything
+        s.ranges.clear();
+        s.conditions.clear();
+        return s;
+      case instruction::_XLOAD:
+        if (inst.bound == 0 and not inst.inRange) {
+          s.ranges.clear();
+          s.conditions.clear();
+        }
+        return s;
+      case instruction::_LOAD:
+      case instruction::_ILOAD:
+        result = a;
+        if (s.conditions.count(inst.arg2)) {
+          hasCondition = true;
+          cond = s.conditions[inst.arg2];
+        }
+        break;
+      case instruction::_ADD: result = fit(a.lo + b.lo, a.hi + b.hi); break;
+      case instruction::_SUB: result = fit(a.lo - b.hi, a.hi - b.lo); break;
+      case instruction::_MUL: {
+        long long p[4] = {a.lo * b.lo, a.lo * b.hi, a.hi * b.lo, a.hi * b.hi};
+        result = fit(*std::min_element(p, p + 4), *std::max_element(p, p + 4));
+        break;
+      }
+      case instruction::_NEG: result = fit(- a.hi, - a.lo); break;
+      case instruction::_LT:
+      case instruction::_LE:
+      case instruction::_EQ:
+        result = {0, 1};
+        hasCondition = true;
+        cond = {inst.oper, inst.arg2, inst.arg3, false};
+        break;
+      case instruction::_NOT:
+        result = {0, 1};
+        if (s.conditions.count(inst.arg2)) {
+          hasCondition = true;
+          cond = s.conditions[inst.arg2];
+          cond.negated = not cond.negated;
+        }
+        break;
+      case instruction::_AND: case instruction::_OR:
+      case instruction::_FEQ: case instruction::_FLT: case instruction::_FLE:
+        result = {0, 1};
+        break;
+      default:
+        break;
+      }
+      std::string dest = Optimizer::writtenAddress(inst);
+      if (dest.empty()) return s;
+      forget(s, dest);
+      setRange(s, dest, result);
+      if (hasCondition and cond.a != dest and cond.b != dest and
+          not untracked.count(dest) and not untracked.count(cond.a) and
+          not untracked.count(cond.b))
+        s.conditions[dest] = cond;
+      return s;
+    }
+
+    // the value of 'addr' is true (not zero) or false
+    void restrict (RangeState & s, const std::string & addr, bool value) const {
+      Range r = rangeOf(s, addr);
+      if (value) {
+        if (r.lo == 0 and r.hi == 0) { s.reachable = false; return; }
+      }
+      else {
+        if (r.lo > 0 or r.hi < 0) { s.reachable = false; return; }
+        setRange(s, addr, {0, 0});
+      }
+      auto it = s.conditions.find(addr);
+      if (it == s.conditions.end()) return;
+      const Condition & c = it->second;
+      bool holds = (value != c.negated);
+      Range x = rangeOf(s, c.a), y = rangeOf(s, c.b);
+      Range nx = x, ny = y;
+      switch (c.oper) {
+      case instruction::_LT:
+        if (holds) { nx.hi = std::min(x.hi, y.hi - 1); ny.lo = std::max(y.lo, x.lo + 1); }
+        else       { nx.lo = std::max(x.lo, y.lo);     ny.hi = std::min(y.hi, x.hi); }
+        break;
+      case instruction::_LE:
+        if (holds) { nx.hi = std::min(x.hi, y.hi);     ny.lo = std::max(y.lo, x.lo); }
+        else       { nx.lo = std::max(x.lo, y.lo + 1); ny.hi = std::min(y.hi, x.hi - 1); }
+        break;
+      default:  // _EQ
+        if (holds) {
+          nx.lo = ny.lo = std::max(x.lo, y.lo);
+          nx.hi = ny.hi = std::min(x.hi, y.hi);
+        }
+        break;
+      }
+      if (nx.lo > nx.hi or ny.lo > ny.hi) { s.reachable = false; return; }
+      std::string a = c.a, b = c.b;
+      setRange(s, a, nx);
+      setRange(s, b, ny);
+    }
+
+    static RangeState join (const RangeState & s1, const RangeState & s2) {
+      if (not s1.reachable) return s2;
+      if (not s2.reachable) return s1;
+      RangeState s;
+      s.reachable = true;
+      for (auto & r : s1.ranges) {
+        auto it = s2.ranges.find(r.first);
+        if (it != s2.ranges.end())
+          s.ranges[r.first] = {std::min(r.second.lo, it->second.lo),
+                               std::max(r.second.hi, it->second.hi)};
+      }
+      for (auto & c : s1.conditions) {
+        auto it = s2.conditions.find(c.first);
+        if (it != s2.conditions.end() and it->second == c.second)
+          s.conditions.insert(c);
+      }
+      return s;
+    }
+
+    // 'next' contains 'old': the bounds that grow jump to a threshold
+    RangeState widen (const RangeState & old, const RangeState & next) const {
+      RangeState s = next;
+      for (auto & r : s.ranges) {
+        const Range & o = old.ranges.at(r.first);
+        if (r.second.lo < o.lo)
+          r.second.lo = *std::prev(thresholds.upper_bound(r.second.lo));
+        if (r.second.hi > o.hi)
+          r.second.hi = *thresholds.lower_bound(r.second.hi);
+      }
+      return s;
+    }
+  };
+
+}  // namespace
+
+void Optimizer::rangeAnalysis(subroutine & subr) const {
+  instructionList lins = subr.get_instructions();
+  RangeAnalysis analysis(lins);
+  bool converged = analysis.run();
+  bool changed = false;
+  for (std::size_t pc = 0; pc < lins.size(); ++pc) {
+    instruction & inst = lins[pc];
+    if (inst.oper != instruction::_XLOAD and inst.oper != instruction::_LOADX)
+      continue;
+    bool inRange = converged and analysis.indexInRange(pc);
+    changed = changed or (inRange != inst.inRange);
+    inst.inRange = inRange;
+  }
+  if (changed) subr.set_instructions(lins);
+}
+
+// ----------------------------------------------------------------------
+// auxiliary methods
+
+std::vector<std::string> Optimizer::readAddresses(const instruction & inst) {
+  std::vector<std::string> addrs;
+  switch (inst.oper) {
+  case instruction::_FJUMP:
+  case instruction::_PUSH:
+  case instruction::_WRITEI:
+  case instruction::_WRITEF:
+  case instruction::_WRITEC:
+    addrs = {inst.arg1};
+    break;
+  case instruction::_ADD: case instruction::_SUB: case instruction::_MUL:
+  case instruction::_DIV: case instruction::_EQ:  case instruction::_LT:
+  case instruction::_LE:  case instruction::_AND: case instruction::_OR:
+  case instruction::_FADD: case instruction::_FSUB: case instruction::_FMUL:
+  case instruction::_FDIV: case instruction::_FEQ:  case instruction::_FLT:
+  case instruction::_FLE:  case instruction::_LOADX:
+    addrs = {inst.arg2, inst.arg3};
+    break;
+  case instruction::_NEG:  case instruction::_NOT:   case instruction::_FNEG:
+  case instruction::_FLOAT: case instruction::_LOAD: case instruction::_ILOAD:
+  case instruction::_FLOAD: case instruction::_ALOAD: case instruction::_LOADC:
+    addrs = {inst.arg2};
+    break;
+  case instruction::_XLOAD:
+    addrs = {inst.arg1, inst.arg2, inst.arg3};
+    break;
+  case instruction::_CLOAD:
+  case instruction::_COPY:
+    addrs = {inst.arg1, inst.arg2};
+    break;
+  default:  // the argument of CHLOAD is a literal
+    break;
+  }
+  addrs.erase(std::remove_if(addrs.begin(), addrs.end(),
+                             [] (const std::string & a) {
+                               return a.empty() or isConstant(a); }),
+              addrs.end());
+  return addrs;
+}
+
+std::string Optimizer::writtenAddress(const instruction & inst) {
+  switch (inst.oper) {
+  case instruction::_LABEL: case instruction::_UJUMP: case instruction::_FJUMP:
+  case instruction::_PUSH:  case instruction::_CALL:  case instruction::_RETURN:
+  case instruction::_XLOAD: case instruction::_CLOAD: case instruction::_COPY:
+  case instruction::_WRITEI: case instruction::_WRITEF: case instruction::_WRITEC:
+  case instruction::_WRITELN: case instruction::_NOOP: case instruction::_INVALID:
+    return "";
+  default:
+    return inst.arg1;
+  }
+}
+
+bool Optimizer::isTemporal(const std::string & arg) {
+  return (arg.size() > 1 and arg[0] == '%' and
+          std::all_of(arg.begin() + 1, arg.end(), ::isdigit));
+}
+
+std::set<std::string> Optimizer::localTemporals(const instructionList & lins) {
+  std::set<std::string> temps, nonLocal;
+  for (std::size_t pc = 0; pc < lins.size(); ++pc) {
+    for (auto & addr : readAddresses(lins[pc])) {
+      if (not isTemporal(addr)) continue;
+      temps.insert(addr);
+      if (pc == 0 or writtenAddress(lins[pc - 1]) != addr)
+        nonLocal.insert(addr);
+    }
+  }
+  std::set<std::string> locals;
+  std::set_difference(temps.begin(), temps.end(), nonLocal.begin(), nonLocal.end(),
+                      std::inserter(locals, locals.end()));
+  return locals;
+}
+
+bool Optimizer::isConstant(const std::string & arg) {
+  if (arg.empty()) return false;
+  if (std::isdigit(arg[0]) or arg[0] == '\'') return true;
+  return ((arg[0] == '-' or arg[0] == '+') and arg.size() > 1 and
+          std::isdigit(arg[1]));
+}
+
+bool Optimizer::isCopy(const instruction & inst) {
+  // ILOAD and FLOAD are also used to copy a temporal into '_result'
+  return ((inst.oper == instruction::_LOAD or
+           inst.oper == instruction::_ILOAD or
+           inst.oper == instruction::_FLOAD) and
+          not isConstant(inst.arg2));
+}
+
+int Optimizer::maxTempNumber(const instructionList & lins) {
+  int maxTemp = 0;
+  for (auto & inst : lins) {
+    for (const std::string * arg : {&inst.arg1, &inst.arg2, &inst.arg3}) {
+      if (isTemporal(*arg))
+        maxTemp = std::max(maxTemp, std::stoi(arg->substr(1)));
+    }
+  }
+  return maxTemp;
+}
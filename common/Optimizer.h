@@ -0,0 +1,123 @@
+/////////////////////////////////////////////////////////////////
+//
+//    Optimizer - Transformations on the generated t-code
+//                for the Asl programming language
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+
+#include <cstddef>    // std::size_t
+
+#include "code.h"
+
+// using namespace std;
+
+
+////////////////////////////////////////////////////////////////
+// Class Optimizer: transforms the code generated by the
+// CodeGenListener into equivalent, cheaper code. Every
+// transformation works on one subroutine at a time and only
+// relies on the shape of the t-code, so it can be applied to
+// any 'code' object once the code generation has finished.
+
+class Optimizer {
+
+public:
+
+  // Constructor
+  Optimizer() = default;
+
+  // Apply all the transformations to every subroutine of the program
+  void optimize (code & program) const;
+
+  // Rewrite the self-recursive calls in tail position (the result of
+  // the call flows directly to '_result' and then the subroutine
+  // returns) into an assignment of the parameters plus a jump to
+  // the beginning of the subroutine. The stack depth of the
+  // recursion becomes constant.
+  void tailCallElimination (subroutine & subr) const;
+
+  // Peephole optimization: applies the rules of the peephole table
+  // (NOT of a comparison, conditional jump over a jump, jumps to the
+  // next instruction...), threads jump chains and removes unreachable
+  // code and unused labels, until no more changes are possible
+  void peephole (subroutine & subr) const;
+
+  // Range analysis: finds an interval for the value of the integer
+  // addresses at each point of the subroutine (narrowed by the
+  // conditions of the jumps, so loops like 'while i < n' are
+  // understood), and marks the xload and loadx whose index is always
+  // within the size of the array, so the VM does not check them
+  void rangeAnalysis (subroutine & subr) const;
+
+  // Addresses read by an instruction (constants are not included)
+  static std::vector<std::string> readAddresses (const instruction & inst);
+  // Address written by an instruction ("" if none)
+  static std::string writtenAddress (const instruction & inst);
+
+private:
+
+  // Label placed at the beginning of a subroutine to restart it
+  static const std::string TailCallLabel;
+
+  // Returns true if the argument of a load is a constant (not an address)
+  static bool isConstant (const std::string & arg);
+  // Returns true if the instruction just copies a value between addresses
+  static bool isCopy (const instruction & inst);
+  // Returns the greatest number n used in a temporal "%n" of the list
+  static int maxTempNumber (const instructionList & lins);
+  // Returns true if arg is a temporal ("%n")
+  static bool isTemporal (const std::string & arg);
+  // Temporals whose every read is right after an instruction writing
+  // them, so their value never flows across instructions or jumps
+  static std::set<std::string> localTemporals (const instructionList & lins);
+
+  // Checks that the code executed after the call in position pc only
+  // moves the result of the call to '_result' and returns. The call
+  // must remove nArgs parameters; resultPopped tells if it also pops
+  // a result
+  static bool isTailPosition (const instructionList & lins,
+                              const std::map<std::string, std::size_t> & labels,
+                              std::size_t nArgs, std::size_t pc,
+                              bool & resultPopped);
+  // Finds the positions of the 'pushparam' belonging to the call in
+  // position pc (the result space first). Returns false if the
+  // arguments can not be safely reassigned to the parameters
+  static bool findCallPushes (const instructionList & lins, std::size_t pc,
+                              std::size_t nPushes, std::vector<std::size_t> & pushes);
+
+  // Each of the peephole steps; they return true if the code changed
+  static bool applyPeepholeTable (instructionList & lins);
+  static bool threadJumps (instructionList & lins);
+  static bool removeUnreachable (instructionList & lins);
+  static bool removeUnusedLabels (instructionList & lins);
+
+};  // class Optimizer
@@ -0,0 +1,147 @@
+/////////////////////////////////////////////////////////////////
+//
+//    PassManager - Pipeline of transformations on the t-code
+//                for the Asl programming language
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+////////////////////////////////////////////////////////////////
+
+#include "PassManager.h"
+#include "Optimizer.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <chrono>
+#include <iostream>
+#include <iomanip>    // std::setw
+
+// using namespace std;
+
+
+void PassManager::addPass(const std::string & name, Pass pass) {
+  PassInfo info;
+  info.name = name;
+  info.pass = pass;
+  Pipeline.push_back(info);
+}
+
+void PassManager::addOptimizationPasses(unsigned int level) {
+  Optimizer optimizer;
+  if (level >= 2)
+    addPass("tailcall", [optimizer] (subroutine & s) {
+        optimizer.tailCallElimination(s); });
+  if (level >= 1) {
+    addPass("peephole", [optimizer] (subroutine & s) {
+        optimizer.peephole(s); });
+    addPass("ranges", [optimizer] (subroutine & s) {
+        optimizer.rangeAnalysis(s); });
+  }
+}
+
+std::vector<std::string> PassManager::getPassNames() const {
+  std::vector<std::string> names;
+  for (auto & p : Pipeline) names.push_back(p.name);
+  return names;
+}
+
+void PassManager::setTimePasses(bool enable) {
+  TimePasses = enable;
+}
+
+void PassManager::setPrintAfter(const std::string & name) {
+  PrintAfter = name;
+}
+
+bool PassManager::run(code & program, std::ostream & out) {
+  for (auto & subr : program.get_subroutines()) {
+    if (not run(subr, out)) return false;
+  }
+  return true;
+}
+
+bool PassManager::run(subroutine & subr, std::ostream & out) {
+  typedef std::chrono::steady_clock Clock;
+  std::vector<std::string> errors;
+  for (auto & p : Pipeline) {
+    std::size_t before = subr.get_instructions().size();
+    Clock::time_point start = Clock::now();
+    p.pass(subr);
+    if (TimePasses) {
+      p.milliseconds +=
+        std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+      p.before += before;
+      p.after  += subr.get_instructions().size();
+    }
+    if (PrintAfter == p.name) {
+      out << ";;; code after pass " << p.name << std::endl;
+      subr.dump(out);
+    }
+    if (not verify(subr, errors)) {
+      for (auto & e : errors)
+        out << "Verifier error after pass " << p.name << ": " << e << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+void PassManager::printReport(std::ostream & out) const {
+  for (auto & p : Pipeline) {
+    long delta = long(p.after) - long(p.before);
+    out << "pass " << std::left << std::setw(12) << p.name << std::right
+        << std::fixed << std::setprecision(3) << std::setw(10) << p.milliseconds << " ms"
+        << std::setw(8) << p.before << " -> " << std::setw(6) << p.after
+        << " instructions (" << (delta > 0 ? "+" : "") << delta << ")"
+        << std::defaultfloat << std::endl;
+  }
+}
+
+bool PassManager::verify(const subroutine & subr, std::vector<std::string> & errors) {
+  std::size_t nErrors = errors.size();
+  const instructionList & lins = subr.get_instructions();
+  std::string where = "function " + subr.get_name() + ": ";
+  std::set<std::string> labels, written;
+  for (auto & inst : lins) {
+    if (inst.oper == instruction::_LABEL and not labels.insert(inst.arg1).second)
+      errors.push_back(where + "label " + inst.arg1 + " defined twice");
+    written.insert(Optimizer::writtenAddress(inst));
+  }
+  std::set<std::string> reported;
+  for (auto & inst : lins) {
+    if (inst.oper == instruction::_UJUMP or inst.oper == instruction::_FJUMP) {
+      const std::string & label =
+        (inst.oper == instruction::_UJUMP ? inst.arg1 : inst.arg2);
+      if (labels.count(label) == 0)
+        errors.push_back(where + "jump to undefined label " + label);
+    }
+    for (auto & addr : Optimizer::readAddresses(inst)) {
+      if (addr[0] == '%' and written.count(addr) == 0 and
+          reported.insert(addr).second)
+        errors.push_back(where + "temporal " + addr + " read but never written");
+    }
+  }
+  return errors.size() == nErrors;
+}
@@ -0,0 +1,109 @@
+/////////////////////////////////////////////////////////////////
+//
+//    PassManager - Pipeline of transformations on the t-code
+//                for the Asl programming language
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <iostream>
+
+#include <cstddef>    // std::size_t
+
+#include "code.h"
+
+// using namespace std;
+
+
+////////////////////////////////////////////////////////////////
+// Class PassManager: runs an ordered pipeline of named passes over
+// the subroutines of the generated code, either the whole program
+// or one subroutine at a time (as soon as it is generated). The
+// pipeline is usually built from an optimization level (-O0, -O1,
+// -O2). Optionally it accumulates the time and the change in the
+// number of instructions of each pass, and dumps the code after a
+// given pass. The verifier checks the labels and temporals of the
+// code after every pass.
+
+class PassManager {
+
+public:
+
+  // A pass transforms one subroutine
+  typedef std::function<void (subroutine &)> Pass;
+
+  // Constructor
+  PassManager() = default;
+
+  // Add a pass at the end of the pipeline
+  void addPass (const std::string & name, Pass pass);
+  // Add the passes of an optimization level:
+  //   0: none,  1: peephole + range analysis,
+  //   2: tail call elimination + peephole + range analysis
+  void addOptimizationPasses (unsigned int level);
+  // Names of the passes in the pipeline
+  std::vector<std::string> getPassNames () const;
+
+  // Accumulate time and instruction delta of each pass
+  void setTimePasses (bool enable);
+  // Dump the whole code to 'out' after the pass 'name'
+  void setPrintAfter (const std::string & name);
+
+  // Run the pipeline over every subroutine of the program, or over
+  // just one subroutine. Dumps go to 'out'. Returns false (and writes
+  // the errors to 'out') if the verifier finds malformed code after
+  // some pass
+  bool run (code & program, std::ostream & out = std::cerr);
+  bool run (subroutine & subr, std::ostream & out = std::cerr);
+  // Write the time and instruction delta of each pass (accumulated
+  // over all the runs)
+  void printReport (std::ostream & out) const;
+
+  // Check that every jump goes to a label defined once in the same
+  // subroutine and that every temporal read is written somewhere.
+  // The problems found are appended to 'errors'
+  static bool verify (const subroutine & subr, std::vector<std::string> & errors);
+
+private:
+
+  struct PassInfo {
+    std::string name;
+    Pass        pass;
+    // statistics
+    double      milliseconds = 0;
+    std::size_t before = 0, after = 0;
+  };
+
+  // Pipeline of passes (in execution order)
+  std::vector<PassInfo> Pipeline;
+  // Options
+  bool        TimePasses = false;
+  std::string PrintAfter;
+
+};  // class PassManager
@@ -0,0 +1,201 @@
+/////////////////////////////////////////////////////////////////
+//
+//    TVM - t-Code Virtual Machine
+//
+//    Copyright (C) 2017  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: Lluis Padro (padro@cs.upc.es)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.320 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+////////////////////////////////////////////////////////////////
+
+#include "Profiler.h"
+
+#include <string>
+#include <vector>
+#include <algorithm>  // std::sort
+#include <iostream>
+#include <sstream>
+#include <iomanip>    // std::setw
+
+using namespace std;
+
+
+namespace {
+
+  /// percentage of a count, for the reports
+  string percent(uint64_t n, uint64_t total) {
+    ostringstream s;
+    s << fixed << setprecision(2) << (total ? 100.0 * n / total : 0.0);
+    return s.str();
+  }
+
+  /// positions 0..n-1 sorted by decreasing key (ties in order)
+  template <class Key>
+  vector<uint32_t> by_decreasing(size_t n, Key key) {
+    vector<uint32_t> order(n);
+    for (size_t i = 0; i < n; ++i) order[i] = i;
+    stable_sort(order.begin(), order.end(),
+                [&key] (uint32_t a, uint32_t b) { return key(a) > key(b); });
+    return order;
+  }
+
+}
+
+
+/// constructor
+Profiler::Profiler(const BinaryCode &prog) : program(prog) { reset(); }
+/// destructor
+Profiler::~Profiler() {}
+
+/// forget the counts of the previous runs
+void Profiler::reset() {
+  const tbc::Header &h = program.header();
+  executed.assign(h.nInstrs, 0);
+  taken.assign(h.nInstrs, 0);
+  calls.assign(h.nSubroutines, 0);
+  inclusive.assign(h.nSubroutines, 0);
+  active.assign(h.nSubroutines, 0);
+  tree.assign(1, node{uint32_t(-1), 0, 0, {}});
+  stack.clear();
+  segment = 0;
+  total = 0;
+}
+
+uint64_t * Profiler::executed_counts() { return executed.data(); }
+uint64_t * Profiler::taken_counts() { return taken.data(); }
+
+/// a subroutine is called
+void Profiler::enter(uint32_t sub, uint64_t now) {
+  uint32_t parent = stack.empty() ? 0 : stack.back().node;
+  tree[parent].instrs += now - segment;
+  segment = now;
+  uint32_t n = 0;
+  for (uint32_t c : tree[parent].children)
+    if (tree[c].sub == sub) n = c;
+  if (n == 0) {
+    n = tree.size();
+    tree[parent].children.push_back(n);
+    tree.push_back(node{sub, parent, 0, {}});
+  }
+  stack.push_back({n, now});
+  ++calls[sub];
+  ++active[sub];
+}
+
+/// the current subroutine returns
+void Profiler::leave(uint64_t now) {
+  activation a = stack.back();
+  stack.pop_back();
+  tree[a.node].instrs += now - segment;
+  segment = now;
+  // recursive calls are counted once, by the outermost one
+  uint32_t sub = tree[a.node].sub;
+  if (--active[sub] == 0) inclusive[sub] += now - a.start;
+}
+
+/// the run has finished
+void Profiler::finish() {
+  uint64_t all = 0;
+  for (uint64_t n : executed) all += n;
+  uint64_t now = all - total;
+  while (not stack.empty()) leave(now);
+  segment = 0;
+  total = all;
+}
+
+uint64_t Profiler::exclusive(uint32_t sub) const {
+  const tbc::Subroutine &s = program.get_subroutine(sub);
+  uint64_t n = 0;
+  for (uint32_t pc = s.firstInstr; pc < s.firstInstr + s.nInstrs; ++pc) n += executed[pc];
+  return n;
+}
+
+string Profiler::stack_name(uint32_t n) const {
+  string name = program.get_string(program.get_subroutine(tree[n].sub).name);
+  if (tree[n].parent != 0) name = stack_name(tree[n].parent) + ";" + name;
+  return name;
+}
+
+/// write the flat profile
+void Profiler::print_flat(ostream &out) const {
+  const tbc::Header &h = program.header();
+  vector<uint32_t> subOf(h.nInstrs);
+  for (uint32_t k = 0; k < h.nSubroutines; ++k) {
+    const tbc::Subroutine &s = program.get_subroutine(k);
+    for (uint32_t pc = s.firstInstr; pc < s.firstInstr + s.nInstrs; ++pc) subOf[pc] = k;
+  }
+  auto name = [this, &subOf] (uint32_t pc) -> const char * {
+    return program.get_string(program.get_subroutine(subOf[pc]).name);
+  };
+
+  out << "Flat profile: " << total << " instructions executed" << endl;
+  out << endl << "     calls        self       %       total       %  function" << endl;
+  vector<uint64_t> self(h.nSubroutines);
+  for (uint32_t k = 0; k < h.nSubroutines; ++k) self[k] = exclusive(k);
+  for (uint32_t k : by_decreasing(h.nSubroutines, [&self] (uint32_t k) { return self[k]; })) {
+    if (calls[k] == 0) continue;
+    out << setw(10) << calls[k]
+        << setw(12) << self[k] << setw(8) << percent(self[k], total)
+        << setw(12) << inclusive[k] << setw(8) << percent(inclusive[k], total)
+        << "  " << program.get_string(program.get_subroutine(k).name) << endl;
+  }
+
+  // lines of the source (0 is the code with no line)
+  vector<uint64_t> perLine;
+  for (uint32_t pc = 0; pc < h.nInstrs; ++pc) {
+    uint32_t line = program.get_position(pc).line;
+    if (line >= perLine.size()) perLine.resize(line + 1, 0);
+    perLine[line] += executed[pc];
+  }
+  out << endl << "      line    executed       %" << endl;
+  for (uint32_t line : by_decreasing(perLine.size(), [&perLine] (uint32_t l) { return perLine[l]; })) {
+    if (perLine[line] == 0) break;
+    out << setw(10) << (line ? to_string(line) : "?")
+        << setw(12) << perLine[line] << setw(8) << percent(perLine[line], total) << endl;
+  }
+
+  out << endl << "  executed       %  function:pc  line:column  instruction" << endl;
+  const tbc::Instr *code = program.instructions();
+  for (uint32_t pc : by_decreasing(h.nInstrs, [this] (uint32_t pc) { return executed[pc]; })) {
+    if (executed[pc] == 0) break;
+    const tbc::Instr &I = code[pc];
+    instruction inst(instruction::Operation(I.oper), program.get_string(I.text[0]),
+                     program.get_string(I.text[1]), program.get_string(I.text[2]));
+    out << setw(10) << executed[pc] << setw(8) << percent(executed[pc], total)
+        << "  " << name(pc) << ":" << pc - program.get_subroutine(subOf[pc]).firstInstr
+        << "  " << program.position_string(pc) << " " << inst.dump() << endl;
+  }
+
+  out << endl << "  executed       jumps   falls through  function:pc  line:column" << endl;
+  for (uint32_t pc = 0; pc < h.nInstrs; ++pc) {
+    if (code[pc].oper != instruction::_FJUMP or executed[pc] == 0) continue;
+    out << setw(10) << executed[pc] << setw(12) << taken[pc]
+        << setw(16) << executed[pc] - taken[pc]
+        << "  " << name(pc) << ":" << pc - program.get_subroutine(subOf[pc]).firstInstr
+        << "  " << program.position_string(pc) << endl;
+  }
+}
+
+/// write one line per call stack
+void Profiler::print_collapsed(ostream &out) const {
+  for (uint32_t n = 1; n < tree.size(); ++n)
+    if (tree[n].instrs > 0) out << stack_name(n) << " " << tree[n].instrs << endl;
+}
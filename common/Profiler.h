@@ -0,0 +1,109 @@
+/////////////////////////////////////////////////////////////////
+//
+//    TVM - t-Code Virtual Machine
+//
+//    Copyright (C) 2017  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: Lluis Padro (padro@cs.upc.es)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.320 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include <cstddef>    // std::size_t
+#include <cstdint>    // std::uint64_t ...
+
+#include "BinaryCode.h"
+
+// using namespace std;
+
+
+////////////////////////////////////////////////////////////////////
+/// Class Profiler collects what a vmachine does while it runs a
+/// program: how many times each instruction is executed (and so each
+/// source line), how many times each ifFalse jumps, and the calls of
+/// each subroutine, with the instructions executed in it (self) and
+/// in it plus the subroutines it calls (total). The counts of the
+/// instructions are also kept per call stack, for flame graphs.
+///
+/// The counts add up over all the runs until reset.
+
+class Profiler {
+ public:
+  /// constructor and destructor
+  Profiler(const BinaryCode &prog);
+  ~Profiler();
+
+  /// forget the counts of the previous runs
+  void reset();
+
+  /// write the flat profile: subroutines, source lines, instructions
+  /// and branches, the most executed first
+  void print_flat(std::ostream &out) const;
+  /// write one line per call stack with the instructions executed in
+  /// it, as in "main;f;g 1234" (the input of flamegraph.pl)
+  void print_collapsed(std::ostream &out) const;
+
+  /// --- used by the vmachine while it runs ---
+  /// counters of each instruction (executed, and jumps taken)
+  std::uint64_t * executed_counts();
+  std::uint64_t * taken_counts();
+  /// a subroutine is called (or main starts), after 'executed'
+  /// instructions of this run
+  void enter(std::uint32_t sub, std::uint64_t executed);
+  /// the current subroutine returns
+  void leave(std::uint64_t executed);
+  /// the run has finished, maybe with a runtime error in the middle
+  /// of some calls, which are closed here
+  void finish();
+
+ private:
+  /// node of the calling context tree: one per different call stack
+  struct node {
+    std::uint32_t sub;
+    std::uint32_t parent;
+    std::uint64_t instrs;                  // executed in this stack
+    std::vector<std::uint32_t> children;
+  };
+  /// activation of a subroutine
+  struct activation {
+    std::uint32_t node;
+    std::uint64_t start;                   // executed when it began
+  };
+
+  const BinaryCode &program;
+  std::vector<std::uint64_t> executed, taken;       // per instruction
+  std::vector<std::uint64_t> calls, inclusive;      // per subroutine
+  std::vector<std::uint32_t> active;                // per subroutine
+  std::vector<node> tree;                           // [0] is the root
+  std::vector<activation> stack;
+  std::uint64_t segment;      // executed when the current node began
+  std::uint64_t total;        // executed in the previous runs
+
+  /// instructions executed in a subroutine itself
+  std::uint64_t exclusive(std::uint32_t sub) const;
+  /// name of the call stack ending in a node
+  std::string stack_name(std::uint32_t n) const;
+};
@@ -32,124 +32,144 @@
 
 #include <iostream>
 #include <string>
-#include <algorithm>
+#include <map>
+#include <utility>    // std::make_pair
 
 // using namespace std;
 
 
+SemErrors::SemErrors(std::ostream & out) : Output{&out} {
+}
+
 void SemErrors::print() {
-  std::sort(ErrorList.begin(), ErrorList.end(), less);  
-  for (auto & error : ErrorList) error.print();
+  for (auto & p : Pending) p.second.print(*Output);
+  Pending.clear();
 }
 
-bool SemErrors::less(const ErrorInfo & e1, const ErrorInfo & e2) {
-  return e1.getLine() < e2.getLine();
+void SemErrors::flush(std::size_t line) {
+  auto end = Pending.lower_bound(line);
+  for (auto it = Pending.begin(); it != end; ++it) it->second.print(*Output);
+  Pending.erase(Pending.begin(), end);
 }
 
 std::size_t SemErrors::getNumberOfSemanticErrors() const {
-  return ErrorList.size();
+  return NumErrors;
+}
+
+void SemErrors::setMaxErrors(std::size_t max) {
+  MaxErrors = max;
+}
+
+bool SemErrors::limitReached() const {
+  return MaxErrors > 0 and NumErrors >= MaxErrors;
+}
+
+void SemErrors::add(const ErrorInfo & error) {
+  if (limitReached()) return;
+  Pending.insert(std::make_pair(error.getLine(), error));
+  ++NumErrors;
 }
 
 void SemErrors::declaredIdent(antlr4::tree::TerminalNode *node) {
   ErrorInfo error(node->getSymbol()->getLine(), node->getSymbol()->getCharPositionInLine(), "Identifier '" + node->getSymbol()->getText() + "' already declared.");
-  ErrorList.push_back(error);
+  add(error);
 }
 
 void SemErrors::undeclaredIdent(antlr4::tree::TerminalNode *node) {
   ErrorInfo error(node->getSymbol()->getLine(), node->getSymbol()->getCharPositionInLine(), "Identifier '" + node->getSymbol()->getText() + "' is undeclared.");
-  ErrorList.push_back(error);
+  add(error);
 }
 
 void SemErrors::incompatibleAssignment(antlr4::tree::TerminalNode *node) {
   ErrorInfo error(node->getSymbol()->getLine(), node->getSymbol()->getCharPositionInLine(), "Assignment with incompatible types.");
-  ErrorList.push_back(error);
+  add(error);
 }
 
 void SemErrors::nonReferenceableLeftExpr(antlr4::ParserRuleContext *ctx) {
   ErrorInfo error(ctx->getStart()->getLine(), ctx->getStart()->getCharPositionInLine(), "Left expression of assignment is not referenceable.");
-  ErrorList.push_back(error);
+  add(error);
 }
 
 void SemErrors::incompatibleOperator(antlr4::Token* tok) {
   ErrorInfo error(tok->getLine(), tok->getCharPositionInLine(), "Operator '" + tok->getText() + "' with incompatible types.");
-  ErrorList.push_back(error);
+  add(error);
 }
 
 void SemErrors::nonArrayInArrayAccess(antlr4::ParserRuleContext *ctx) {
   ErrorInfo error(ctx->getStart()->getLine(), ctx->getStart()->getCharPositionInLine(), "Array access to a non array operand.");
-  ErrorList.push_back(error);
+  add(error);
 }
 
 void SemErrors::nonIntegerIndexInArrayAccess(antlr4::ParserRuleContext *ctx) {
   ErrorInfo error(ctx->getStart()->getLine(), ctx->getStart()->getCharPositionInLine(), "Array access witn non integer index.");
-  ErrorList.push_back(error);
+  add(error);
 }
 
 void SemErrors::booleanRequired(antlr4::ParserRuleContext *ctx) {
   ErrorInfo error(ctx->getStart()->getLine(), ctx->getStart()->getCharPositionInLine(), "Instruction '" + ctx->getStart()->getText() + "' requires a boolean condition.");
-  ErrorList.push_back(error);
+  add(error);
 }
 
 void SemErrors::isNotCallable(antlr4::ParserRuleContext *ctx) {
   ErrorInfo error(ctx->getStart()->getLine(), ctx->getStart()->getCharPositionInLine(), "Identifier '" + ctx->getStart()->getText() + "' is not a callable function.");
-  ErrorList.push_back(error);
+  add(error);
 }
 
 void SemErrors::isNotProcedure(antlr4::ParserRuleContext *ctx) {
   ErrorInfo error(ctx->getStart()->getLine(), ctx->getStart()->getCharPositionInLine(), "Identifier '" + ctx->getStart()->getText() + "' is not a procedure.");
-  ErrorList.push_back(error);
+  add(error);
 }
 
 void SemErrors::isNotFunction(antlr4::ParserRuleContext *ctx) {
   ErrorInfo error(ctx->getStart()->getLine(), ctx->getStart()->getCharPositionInLine(), "Identifier '" + ctx->getStart()->getText() + "' is a void returning function.");
-  ErrorList.push_back(error);
+  add(error);
 }
 
 void SemErrors::numberOfParameters(antlr4::ParserRuleContext *ctx) {
   ErrorInfo error(ctx->getStart()->getLine(), ctx->getStart()->getCharPositionInLine(), "The number of parameters in the call to '" + ctx->getStart()->getText() + "' does not match.");
-  ErrorList.push_back(error);
+  add(error);
 }
 
 void SemErrors::incompatibleParameter(antlr4::ParserRuleContext *pCtx,
 				      unsigned int n,
 				      antlr4::ParserRuleContext *cCtx) {
   ErrorInfo error(pCtx->getStart()->getLine(), pCtx->getStart()->getCharPositionInLine(), "Parameter #" + std::to_string(n) + " with incompatible types in call to '" + cCtx->getStart()->getText() + "'.");
-  ErrorList.push_back(error);
+  add(error);
 }
 
 void SemErrors::referenceableParameter(antlr4::ParserRuleContext *pCtx,
 				       unsigned int n,
 				       antlr4::ParserRuleContext *cCtx) {
   ErrorInfo error(pCtx->getStart()->getLine(), pCtx->getStart()->getCharPositionInLine(), "Parameter #" + std::to_string(n) + " is expected to be referenceable in call to '" + cCtx->getStart()->getText() + "'.");
-  ErrorList.push_back(error);
+  add(error);
 }
 
 void SemErrors::incompatibleReturn(antlr4::ParserRuleContext *ctx) {
   ErrorInfo error(ctx->getStart()->getLine(), ctx->getStart()->getCharPositionInLine(), "Return with incompatible type.");
-  ErrorList.push_back(error);
+  add(error);
 }
 
 void SemErrors::readWriteRequireBasic(antlr4::ParserRuleContext *ctx) {
   ErrorInfo error(ctx->getStart()->getLine(), ctx->getStart()->getCharPositionInLine(), "Basic type required in '" + ctx->getStart()->getText() + "'.");
-  ErrorList.push_back(error);
+  add(error);
 }
 
 void SemErrors::nonReferenceableExpression(antlr4::ParserRuleContext *ctx) {
   ErrorInfo error(ctx->getStart()->getLine(), ctx->getStart()->getCharPositionInLine(), "Referenceable expression required in '" + ctx->getStart()->getText() + "'.");
-  ErrorList.push_back(error);
+  add(error);
 }
 
 void SemErrors::noMainProperlyDeclared(antlr4::ParserRuleContext *ctx) {
   ErrorInfo error(ctx->getStop()->getLine(), ctx->getStop()->getCharPositionInLine(), "There is no 'main' function properly declared.");
-  ErrorList.push_back(error);
+  add(error);
 }
 
 SemErrors::ErrorInfo::ErrorInfo(std::size_t line, std::size_t coln, std::string message)
   : line{line}, coln{coln}, message{message} {
 }
 
-void SemErrors::ErrorInfo::print() const {
-  std::cout << "Line " << line << ":" << coln << " error: " << message << std::endl;
+void SemErrors::ErrorInfo::print(std::ostream & out) const {
+  out << "Line " << line << ":" << coln << " error: " << message << std::endl;
 }
 
 std::size_t SemErrors::ErrorInfo::getLine() const {
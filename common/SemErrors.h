@@ -31,7 +31,10 @@
 #include "antlr4-runtime.h"
 
 #include <string>
-#include <vector>
+#include <map>
+#include <iostream>
+
+#include <cstddef>    // std::size_t
 
 // using namespace std;
 
@@ -42,22 +45,32 @@
 // It is used by the semantic listeners:
 //   - SymbolsListener
 //   - TypeCheckListener
-// Semantic errors emitted are kept in a vector and when the
-// typecheck finishes they will be printed (sorted by line number)
+// Semantic errors emitted are kept ordered by line number, and
+// written as soon as the typecheck goes past their line (see flush),
+// or when it finishes. Optionally the number of errors is limited:
+// once the limit is reached no more errors are kept, and the walks
+// stop (see BoundedWalker)
 
 class SemErrors {
 
 public:
 
-  // Constructor
-  SemErrors() = default;
+  // Constructor: the errors are written to 'out'
+  SemErrors(std::ostream & out = std::cout);
 
-  // Write the semantic errors ordered by line number
+  // Write the semantic errors not yet written, ordered by line number
   void print ();
+  // Write (ordered by line number) the errors before the given line,
+  // once the typecheck has gone past it
+  void flush (std::size_t line);
 
   // Accessor to get the number of semantic errors
   std::size_t getNumberOfSemanticErrors () const;
 
+  // Limit of the number of errors (0, the default, means no limit)
+  void setMaxErrors (std::size_t max);
+  bool limitReached () const;
+
   // Methods that emit the error messages
   void declaredIdent                (antlr4::tree::TerminalNode *node);
   void undeclaredIdent              (antlr4::tree::TerminalNode *node);
@@ -90,16 +103,22 @@ private:
     ErrorInfo() = delete;
     ErrorInfo(std::size_t line, std::size_t coln, std::string message);
     std::size_t getLine() const;
-    void print() const;
+    void print(std::ostream & out) const;
   private:
     std::size_t line, coln;
     std::string message;
   };
 
-  // List of semantic errors
-  std::vector<ErrorInfo> ErrorList;
-
-  // Compare two errors to determine the order (needed in print)
-  static bool less(const ErrorInfo & e1, const ErrorInfo & e2);
+  // Semantic errors not yet written, by line number (the ones in the
+  // same line in the order they were emitted)
+  std::multimap<std::size_t, ErrorInfo> Pending;
+  // Where they are written
+  std::ostream * Output;
+  // Number of errors emitted, and limit
+  std::size_t NumErrors = 0;
+  std::size_t MaxErrors = 0;
+
+  // Keep an error (unless the limit has been reached)
+  void add(const ErrorInfo & error);
 
 };  // class SemErrors
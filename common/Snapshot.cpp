@@ -0,0 +1,111 @@
+/////////////////////////////////////////////////////////////////
+//
+//    TVM - t-Code Virtual Machine
+//
+//    Copyright (C) 2017  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: Lluis Padro (padro@cs.upc.es)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.320 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+////////////////////////////////////////////////////////////////
+
+#include "Snapshot.h"
+
+#include <string>
+#include <fstream>
+
+#include <cstring>    // std::memcmp
+
+#include <fcntl.h>    // open
+#include <unistd.h>   // close
+#include <sys/mman.h> // mmap, munmap
+#include <sys/stat.h> // fstat
+
+using namespace std;
+
+
+/// constructor
+Snapshot::Snapshot() : mapped(nullptr), mappedSize(0) {}
+/// destructor
+Snapshot::~Snapshot() { unmap(); }
+
+void Snapshot::unmap() {
+  if (mapped) munmap(mapped, mappedSize);
+  mapped = nullptr;
+  mappedSize = 0;
+}
+
+/// write a snapshot
+bool Snapshot::save(const string &fileName, const tvs::Header &h, const int32_t *cells) {
+  ofstream out(fileName, ios::binary);
+  out.write(reinterpret_cast<const char *>(&h), sizeof(h));
+  out.seekp(h.cellsOffset);
+  out.write(reinterpret_cast<const char *>(cells), h.sp * sizeof(int32_t));
+  return bool(out);
+}
+
+/// map a .tvs file
+bool Snapshot::load(const string &fileName, string &error) {
+  unmap();
+  int fd = open(fileName.c_str(), O_RDONLY);
+  if (fd < 0) {
+    error = "can not open " + fileName;
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 or size_t(st.st_size) < sizeof(tvs::Header)) {
+    close(fd);
+    error = fileName + " is not a snapshot file";
+    return false;
+  }
+  mappedSize = st.st_size;
+  mapped = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapped == MAP_FAILED) {
+    mapped = nullptr;
+    error = "can not map " + fileName;
+    return false;
+  }
+
+  // the frames are checked by the vmachine, against the program
+  const tvs::Header &h = header();
+  error = "";
+  if (memcmp(h.magic, tvs::Magic, sizeof(h.magic)) != 0)
+    error = fileName + " is not a snapshot file";
+  else if (h.version != tvs::Version)
+    error = fileName + ": unsupported version " + to_string(h.version) +
+            " (expected " + to_string(tvs::Version) + ")";
+  else if (h.cellsOffset < sizeof(tvs::Header) or h.cellsOffset % 4 != 0 or
+           h.cellsOffset + uint64_t(h.sp) * sizeof(int32_t) > mappedSize)
+    error = fileName + ": corrupted file";
+  if (not error.empty()) {
+    unmap();
+    return false;
+  }
+  return true;
+}
+
+const tvs::Header & Snapshot::header() const {
+  return *static_cast<const tvs::Header *>(mapped);
+}
+
+const int32_t * Snapshot::cells() const {
+  return reinterpret_cast<const int32_t *>(static_cast<const char *>(mapped) + header().cellsOffset);
+}
@@ -0,0 +1,98 @@
+/////////////////////////////////////////////////////////////////
+//
+//    TVM - t-Code Virtual Machine
+//
+//    Copyright (C) 2017  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: Lluis Padro (padro@cs.upc.es)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.320 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+
+#include <cstddef>    // std::size_t
+#include <cstdint>    // std::uint32_t ...
+
+// using namespace std;
+
+
+////////////////////////////////////////////////////////////////////
+/// Snapshot of a run of the VM (.tvs), taken when some subroutine is
+/// about to be called, to start later runs from there. As a .tbc, it
+/// is made of words in the byte order of the machine that wrote it,
+/// and can be used directly once mapped:
+///
+///    header | cells of the stack
+///
+/// The stack has the frames (with the links to the callers), so the
+/// header only needs the subroutine, pc, frame and depth of the call,
+/// and the chars of the input that had been read. The checksum of
+/// the program makes sure a snapshot is resumed with the same one.
+
+namespace tvs {
+
+  const char          Magic[4] = {'T', 'V', 'S', '\0'};
+  const std::uint32_t Version  = 1;
+
+  struct Header {
+    char          magic[4];
+    std::uint32_t version;
+    std::uint32_t program;          // BinaryCode::checksum
+    std::uint32_t sub, pc;          // the call about to be executed
+    std::uint32_t fp, sp, depth;
+    std::uint64_t instructions;     // executed before the call
+    std::uint64_t input;            // chars of the input read
+    std::uint32_t inputFailed;      // a read had failed (all give 0)
+    std::uint32_t cellsOffset;      // sp cells
+  };
+
+}  // namespace tvs
+
+
+////////////////////////////////////////////////////////////////////
+/// Class Snapshot maps a .tvs file (the vmachine writes them, see
+/// vmachine::set_snapshot, and resumes them).
+
+class Snapshot {
+ public:
+  /// constructor and destructor
+  Snapshot();
+  ~Snapshot();
+  Snapshot(const Snapshot &) = delete;
+  Snapshot & operator=(const Snapshot &) = delete;
+
+  /// write a snapshot with the first h.sp cells
+  static bool save(const std::string &fileName, const tvs::Header &h, const std::int32_t *cells);
+  /// map a .tvs file (read only). Returns false if it can not be
+  /// opened or has a wrong header
+  bool load(const std::string &fileName, std::string &error);
+
+  const tvs::Header & header() const;
+  const std::int32_t * cells() const;
+
+ private:
+  void *      mapped;
+  std::size_t mappedSize;
+
+  void unmap();
+};
@@ -41,6 +41,10 @@
 // using namespace std;
 
 
+// Definition of the static attributes
+const SymTable::IdentId SymTable::NoIdent;
+const std::size_t       SymTable::ScopeInfo::NoPos;
+
 // Constructor
 SymTable::SymTable(TypesMgr & Types) :
   Types{Types} {
@@ -50,7 +54,7 @@ SymTable::SymTable(TypesMgr & Types) :
 // and returns this ScopeId.
 SymTable::ScopeId SymTable::pushNewScope(const std::string & name) {
   ScopeId currScope = ScopesVec.size();
-  ScopesVec.push_back(ScopeInfo(name));
+  ScopesVec.push_back(ScopeInfo(intern(name)));
   ScopeIdsStack.push_back(currScope);
   return currScope;
 }
@@ -73,96 +77,187 @@ SymTable::ScopeId SymTable::topScope() const {
   return ScopeIdsStack.back();
 }
 
+// Hash function for the names of the identifiers (FNV-1a)
+std::size_t SymTable::hashIdent(const std::string & ident) {
+  std::size_t h = 2166136261u;
+  for (unsigned char c : ident)
+    h = (h ^ c) * 16777619u;
+  return h;
+}
+
+// Returns the IdentId of ident. The first time a name is seen it
+// gets a new IdentId.
+SymTable::IdentId SymTable::intern(const std::string & ident) {
+  IdentId id = lookupIdent(ident);
+  if (id != NoIdent)
+    return id;
+  // keep the table at most half full
+  if (2*(IdentNames.size() + 1) > IdentSlots.size()) {
+    std::size_t capacity = IdentSlots.empty() ? 64 : 2*IdentSlots.size();
+    IdentSlots.assign(capacity, NoIdent);
+    for (IdentId old = 0; old < IdentNames.size(); ++old) {
+      std::size_t i = IdentHashes[old] & (capacity - 1);
+      while (IdentSlots[i] != NoIdent)
+        i = (i + 1) & (capacity - 1);
+      IdentSlots[i] = old;
+    }
+  }
+  std::size_t h = hashIdent(ident);
+  std::size_t mask = IdentSlots.size() - 1;
+  std::size_t i = h & mask;
+  while (IdentSlots[i] != NoIdent)
+    i = (i + 1) & mask;
+  id = IdentNames.size();
+  IdentSlots[i] = id;
+  IdentNames.push_back(ident);
+  IdentHashes.push_back(h);
+  return id;
+}
+
+// Returns the IdentId of ident, or NoIdent if it was never interned.
+SymTable::IdentId SymTable::lookupIdent(const std::string & ident) const {
+  if (IdentSlots.empty())
+    return NoIdent;
+  std::size_t h = hashIdent(ident);
+  std::size_t mask = IdentSlots.size() - 1;
+  for (std::size_t i = h & mask; IdentSlots[i] != NoIdent; i = (i + 1) & mask) {
+    IdentId id = IdentSlots[i];
+    if (IdentHashes[id] == h and IdentNames[id] == ident)
+      return id;
+  }
+  return NoIdent;
+}
+
+// Returns the name of an interned identifier.
+const std::string & SymTable::identName(IdentId id) const {
+  assert(id < IdentNames.size());
+  return IdentNames[id];
+}
+
 // Returns true if ident occurs in the current scope (top of the stack)
 bool SymTable::findInCurrentScope(const std::string & ident) const {
+  return findInCurrentScope(lookupIdent(ident));
+}
+
+bool SymTable::findInCurrentScope(IdentId id) const {
   assert(not ScopeIdsStack.empty());
   ScopeId currScope = ScopeIdsStack.back();
   assert(currScope < ScopesVec.size());
-  return (ScopesVec[currScope].findSymbol(ident));
+  return (ScopesVec[currScope].findSymbol(id));
 }
 
-// Returns an iteger >= 0 if ident occurs in some of the scopes
-// of the stack. If it it occurs at the top (current scope) returns 0.
-// If it occurs in the scope below the top returns 1, and so on.
-// Returns -1 if te symbol is not found.
-int SymTable::findInStack(const std::string & ident) const {
+// Returns the scope of the stack where id is declared, or nullptr
+// if it is not found. In d returns the number of scopes skipped.
+const SymTable::ScopeInfo * SymTable::findScopeOf(IdentId id, int & d) const {
   assert(not ScopeIdsStack.empty());
-  int d = 0;
+  d = 0;
   for (int i = ScopeIdsStack.size() - 1; i >= 0; --i) {
     ScopeId sc = ScopeIdsStack[i];
     assert(sc < ScopesVec.size());
-    if (ScopesVec[sc].findSymbol(ident))
-      return d;
+    if (ScopesVec[sc].findSymbol(id))
+      return &ScopesVec[sc];
     ++d;
   }
-  return -1;
+  return nullptr;
+}
+
+// Returns an iteger >= 0 if ident occurs in some of the scopes
+// of the stack. If it it occurs at the top (current scope) returns 0.
+// If it occurs in the scope below the top returns 1, and so on.
+// Returns -1 if te symbol is not found.
+int SymTable::findInStack(const std::string & ident) const {
+  return findInStack(lookupIdent(ident));
+}
+
+int SymTable::findInStack(IdentId id) const {
+  int d;
+  if (findScopeOf(id, d) == nullptr)
+    return -1;
+  return d;
 }
 
 // Adds a new symbol in the current scope.
 void SymTable::addLocalVar(const std::string & ident, TypesMgr::TypeId type) {
+  addLocalVar(intern(ident), type);
+}
+void SymTable::addParameter(const std::string & ident, TypesMgr::TypeId type) {
+  addParameter(intern(ident), type);
+}
+void SymTable::addFunction(const std::string & ident, TypesMgr::TypeId type) {
+  addFunction(intern(ident), type);
+}
+
+void SymTable::addLocalVar(IdentId id, TypesMgr::TypeId type) {
   assert(not ScopeIdsStack.empty());
   ScopeId currScope = ScopeIdsStack.back();
   assert(currScope < ScopesVec.size());
-  ScopesVec[currScope].addLocalVar(ident, type);
+  ScopesVec[currScope].addLocalVar(id, type);
 }
-void SymTable::addParameter(const std::string & ident, TypesMgr::TypeId type) {
+void SymTable::addParameter(IdentId id, TypesMgr::TypeId type) {
   assert(not ScopeIdsStack.empty());
   ScopeId currScope = ScopeIdsStack.back();
   assert(currScope < ScopesVec.size());
-  ScopesVec[currScope].addParameter(ident, type);
+  ScopesVec[currScope].addParameter(id, type);
 }
-
-void SymTable::addFunction(const std::string & ident, TypesMgr::TypeId type) {
+void SymTable::addFunction(IdentId id, TypesMgr::TypeId type) {
   assert(not ScopeIdsStack.empty());
   ScopeId currScope = ScopeIdsStack.back();
   assert(currScope < ScopesVec.size());
-  ScopesVec[currScope].addFunction(ident, type);
+  ScopesVec[currScope].addFunction(id, type);
 }
 
 // Check the class of a symbol. If not found return false
 bool SymTable::isLocalVarClass(const std::string & ident) const {
-  assert(not ScopeIdsStack.empty());
-  for (int i = ScopeIdsStack.size() - 1; i >= 0; --i) {
-    ScopeId sc = ScopeIdsStack[i];
-    assert(sc < ScopesVec.size());
-    if (ScopesVec[sc].findSymbol(ident))
-      return ScopesVec[sc].isLocalVarClass(ident);
-  }
-  return false;
+  return isLocalVarClass(lookupIdent(ident));
 }
-
 bool SymTable::isParameterClass(const std::string & ident) const {
-  assert(not ScopeIdsStack.empty());
-  for (int i = ScopeIdsStack.size() - 1; i >= 0; --i) {
-    ScopeId sc = ScopeIdsStack[i];
-    assert(sc < ScopesVec.size());
-    if (ScopesVec[sc].findSymbol(ident))
-      return ScopesVec[sc].isParameterClass(ident);
-  }
-  return false;
+  return isParameterClass(lookupIdent(ident));
 }
-
 bool SymTable::isFunctionClass(const std::string & ident) const {
-  assert(not ScopeIdsStack.empty());
-  for (int i = ScopeIdsStack.size() - 1; i >= 0; --i) {
-    ScopeId sc = ScopeIdsStack[i];
-    assert(sc < ScopesVec.size());
-    if (ScopesVec[sc].findSymbol(ident))
-      return ScopesVec[sc].isFunctionClass(ident);
-  }
-  return false;
+  return isFunctionClass(lookupIdent(ident));
+}
+
+bool SymTable::isLocalVarClass(IdentId id) const {
+  int d;
+  const ScopeInfo *sc = findScopeOf(id, d);
+  return sc != nullptr and sc->isLocalVarClass(id);
+}
+bool SymTable::isParameterClass(IdentId id) const {
+  int d;
+  const ScopeInfo *sc = findScopeOf(id, d);
+  return sc != nullptr and sc->isParameterClass(id);
+}
+bool SymTable::isFunctionClass(IdentId id) const {
+  int d;
+  const ScopeInfo *sc = findScopeOf(id, d);
+  return sc != nullptr and sc->isFunctionClass(id);
 }
 
 // Get the TypeId of a symbol. If not found return type 'error'
 TypesMgr::TypeId SymTable::getType(const std::string & ident) const {
-  assert(not ScopeIdsStack.empty());
-  for (int i = ScopeIdsStack.size() - 1; i >= 0; --i) {
-    ScopeId sc = ScopeIdsStack[i];
-    assert(sc < ScopesVec.size());
-    if (ScopesVec[sc].findSymbol(ident))
-      return ScopesVec[sc].getType(ident);
-  }
-  return Types.createErrorTy();
+  return getType(lookupIdent(ident));
+}
+
+TypesMgr::TypeId SymTable::getType(IdentId id) const {
+  int d;
+  const ScopeInfo *sc = findScopeOf(id, d);
+  if (sc == nullptr)
+    return Types.createErrorTy();
+  return sc->getType(id);
+}
+
+// Resolves an identifier: finds the scope where it is declared
+// and returns its class, type and slot in that scope.
+SymTable::Binding SymTable::resolve(IdentId id) const {
+  Binding b;
+  b.ident = id;
+  b.type = Types.createErrorTy();
+  const ScopeInfo *sc = findScopeOf(id, b.depth);
+  if (sc == nullptr)
+    b.depth = -1;
+  else
+    sc->bind(id, b);
+  return b;
 }
 
 // Writes the contents of the current scope (top of the stack)
@@ -171,7 +266,7 @@ void SymTable::printCurrentScope() const {
   assert(not ScopeIdsStack.empty());
   ScopeId currScope = ScopeIdsStack.back();
   assert(currScope < ScopesVec.size());
-  ScopesVec[currScope].print(Types);
+  ScopesVec[currScope].print(Types, *this);
 }
 
 // Write the contents of the symbol table on the standard output
@@ -180,7 +275,7 @@ void SymTable::print() const {
   for (int i = ScopeIdsStack.size() - 1; i >= 0; --i) {
     ScopeId sc = ScopeIdsStack[i];
     assert(sc < ScopesVec.size());
-    ScopesVec[sc].print(Types);
+    ScopesVec[sc].print(Types, *this);
   }
   std::cout << "----------------" << std::endl;
 }
@@ -190,7 +285,7 @@ void SymTable::print() const {
 TypesMgr::TypeId SymTable::getCurrentFunctionTy() const {
   assert(not ScopeIdsStack.empty());
   ScopeId currScope = ScopeIdsStack.back();
-  std::string name = ScopesVec[currScope].getName();
+  IdentId name = ScopesVec[currScope].getName();
   return ScopesVec[0].getType(name);
 }
 
@@ -198,10 +293,11 @@ bool SymTable::noMainProperlyDeclared() const {
   assert(not ScopeIdsStack.empty());
   ScopeId currScope = ScopeIdsStack.back();
   assert(currScope < ScopesVec.size());
-  if ((not ScopesVec[currScope].findSymbol("main")) or
-      (not ScopesVec[currScope].isFunctionClass("main")))
+  IdentId mainId = lookupIdent("main");
+  if ((not ScopesVec[currScope].findSymbol(mainId)) or
+      (not ScopesVec[currScope].isFunctionClass(mainId)))
     return true;
-  TypesMgr::TypeId tid = ScopesVec[currScope].getType("main");
+  TypesMgr::TypeId tid = ScopesVec[currScope].getType(mainId);
   if (Types.isFunctionTy(tid) and
       (Types.getNumOfParameters(tid) == 0) and
       Types.isVoidFunction(tid))
@@ -213,71 +309,115 @@ bool SymTable::noMainProperlyDeclared() const {
 // class SymTable::ScopeInfo ==============================================================
 
 // Constructor
-SymTable::ScopeInfo::ScopeInfo(const std::string & name)
+SymTable::ScopeInfo::ScopeInfo(IdentId name)
   : name{name} { }
 
-// Accessors to work with the attributes: name, SymbolsMap, IdentsList
-std::string SymTable::ScopeInfo::getName() const {
+// Accessors to work with the attributes: name, Idents, Symbols
+SymTable::IdentId SymTable::ScopeInfo::getName() const {
   return name;
 }
 
+// Position of a symbol in Idents/Symbols (NoPos if not declared)
+std::size_t SymTable::ScopeInfo::findPos(IdentId id) const {
+  if (Slots.empty() or id == NoIdent)
+    return NoPos;
+  std::size_t mask = Slots.size() - 1;
+  for (std::size_t i = (id * 2654435761u) & mask; Slots[i] != 0; i = (i + 1) & mask) {
+    if (Idents[Slots[i] - 1] == id)
+      return Slots[i] - 1;
+  }
+  return NoPos;
+}
+
+// Adds a new symbol, keeping the table at most half full
+void SymTable::ScopeInfo::addSymbol(IdentId id, const SymbolInfo & info) {
+  assert(findPos(id) == NoPos);
+  if (2*(Idents.size() + 1) > Slots.size()) {
+    // grow the table and place again the symbols already declared
+    std::size_t capacity = Slots.empty() ? 16 : 2*Slots.size();
+    Slots.assign(capacity, 0);
+    for (std::size_t pos = 0; pos < Idents.size(); ++pos) {
+      std::size_t i = (Idents[pos] * 2654435761u) & (capacity - 1);
+      while (Slots[i] != 0)
+        i = (i + 1) & (capacity - 1);
+      Slots[i] = pos + 1;
+    }
+  }
+  Idents.push_back(id);
+  Symbols.push_back(info);
+  std::size_t mask = Slots.size() - 1;
+  std::size_t i = (id * 2654435761u) & mask;
+  while (Slots[i] != 0)
+    i = (i + 1) & mask;
+  Slots[i] = Idents.size();
+}
+
 // Mutators to add symbols to the scope
-void SymTable::ScopeInfo::addLocalVar(const std::string & ident, TypesMgr::TypeId type) {
-  assert(SymbolsMap.find(ident) == SymbolsMap.end());
-  SymbolsMap[ident] = SymbolInfo::createLocalVar(type);
-  IdentsList.push_back(ident);
+void SymTable::ScopeInfo::addLocalVar(IdentId id, TypesMgr::TypeId type) {
+  addSymbol(id, SymbolInfo::createLocalVar(type));
 }
-void SymTable::ScopeInfo::addParameter(const std::string & ident, TypesMgr::TypeId type) {
-  assert(SymbolsMap.find(ident) == SymbolsMap.end());
-  SymbolsMap[ident] = SymbolInfo::createParameter(type);
-  IdentsList.push_back(ident);
+void SymTable::ScopeInfo::addParameter(IdentId id, TypesMgr::TypeId type) {
+  addSymbol(id, SymbolInfo::createParameter(type));
 }
-void SymTable::ScopeInfo::addFunction(const std::string & ident, TypesMgr::TypeId type) {
-  assert(SymbolsMap.find(ident) == SymbolsMap.end());
-  SymbolsMap[ident] = SymbolInfo::createFunction(type);
-  IdentsList.push_back(ident);
+void SymTable::ScopeInfo::addFunction(IdentId id, TypesMgr::TypeId type) {
+  addSymbol(id, SymbolInfo::createFunction(type));
 }
 
 // Accessor to check the existence of a symbol
-bool SymTable::ScopeInfo::findSymbol(const std::string & ident) const {
-  return (SymbolsMap.find(ident) != SymbolsMap.end());
+bool SymTable::ScopeInfo::findSymbol(IdentId id) const {
+  return (findPos(id) != NoPos);
 }
 
 // Accessors to check the class of the symbol. If not found return false
-bool SymTable::ScopeInfo::isLocalVarClass(const std::string & ident) const {
-  auto const & it = SymbolsMap.find(ident);
-  if (it == SymbolsMap.end())
+bool SymTable::ScopeInfo::isLocalVarClass(IdentId id) const {
+  std::size_t pos = findPos(id);
+  if (pos == NoPos)
     return false;
-  return it->second.isLocalVarClass();
+  return Symbols[pos].isLocalVarClass();
 }
-bool SymTable::ScopeInfo::isParameterClass(const std::string & ident) const {
-  auto const & it = SymbolsMap.find(ident);
-  if (it == SymbolsMap.end())
+bool SymTable::ScopeInfo::isParameterClass(IdentId id) const {
+  std::size_t pos = findPos(id);
+  if (pos == NoPos)
     return false;
-  return it->second.isParameterClass();
+  return Symbols[pos].isParameterClass();
 }
-bool SymTable::ScopeInfo::isFunctionClass(const std::string & ident) const {
-  auto const & it = SymbolsMap.find(ident);
-  if (it == SymbolsMap.end())
+bool SymTable::ScopeInfo::isFunctionClass(IdentId id) const {
+  std::size_t pos = findPos(id);
+  if (pos == NoPos)
     return false;
-  return it->second.isFunctionClass();
+  return Symbols[pos].isFunctionClass();
 }
 
 // Accessor to get the TypeId of a symbol. The symbol MUST exist.
-TypesMgr::TypeId SymTable::ScopeInfo::getType(const std::string & ident) const {
-  assert(SymbolsMap.find(ident) != SymbolsMap.end());
-  auto const & it = SymbolsMap.find(ident);
-  return it->second.getType();
+TypesMgr::TypeId SymTable::ScopeInfo::getType(IdentId id) const {
+  std::size_t pos = findPos(id);
+  assert(pos != NoPos);
+  return Symbols[pos].getType();
+}
+
+// Fills the class, type and slot of a binding. The symbol MUST exist.
+void SymTable::ScopeInfo::bind(IdentId id, Binding & b) const {
+  std::size_t pos = findPos(id);
+  assert(pos != NoPos);
+  const SymbolInfo & info = Symbols[pos];
+  if (info.isLocalVarClass())
+    b.symClass = LocalVarClass;
+  else if (info.isParameterClass())
+    b.symClass = ParameterClass;
+  else if (info.isFunctionClass())
+    b.symClass = FunctionClass;
+  b.type = info.getType();
+  b.slot = pos;
 }
 
 // Writes the contents of the scope to the standard output.
-void SymTable::ScopeInfo::print(TypesMgr & Types) const {
-  std::cout << "---------------- scope name: " << name << std::endl;
-  for (auto & id : IdentsList) {
-    auto const & it = SymbolsMap.find(id);
-    std::cout << id << ":" << it->second.class2string();
-    if (not it->second.isErrorClass()) {
-      std::cout << "," << Types.to_string(it->second.getType());
+void SymTable::ScopeInfo::print(TypesMgr & Types, const SymTable & SymTab) const {
+  std::cout << "---------------- scope name: " << SymTab.identName(name) << std::endl;
+  for (std::size_t pos = 0; pos < Idents.size(); ++pos) {
+    const SymbolInfo & info = Symbols[pos];
+    std::cout << SymTab.identName(Idents[pos]) << ":" << info.class2string();
+    if (not info.isErrorClass()) {
+      std::cout << "," << Types.to_string(info.getType());
     }
     std::cout << std::endl;
   }
@@ -29,9 +29,9 @@
 #pragma once
 
 #include "TypesMgr.h"
+#include "Arena.h"
 
 #include <string>
-#include <map>
 #include <vector>
 
 #include <cstddef>    // std::size_t
@@ -57,6 +57,12 @@
 // scopes that determines which symbols are visible and
 // which are not. Entering in a function will push a new
 // scope to the stack and exiting will pop the stack.
+// The identifiers are interned: each different name gets an
+// IdentId and the scopes are open-addressing hash tables indexed
+// by IdentId, so a lookup compares integers instead of strings.
+// Every method taking an identifier has a string version (that
+// interns the name) and an IdentId version. The tables are
+// allocated in the current Arena, if there is one.
 
 class SymTable {
 
@@ -64,6 +70,30 @@ public:
 
   // The ScopeId is an index in a vector
   typedef std::size_t ScopeId;
+  // The IdentId is the index of an interned identifier
+  typedef std::size_t IdentId;
+  static const IdentId NoIdent = static_cast<IdentId>(-1);
+
+  // The resolution of an identifier at a use site: the symbol it
+  // refers to (its class and type) and its slot, that is, its
+  // position in the scope where it is declared (for a function
+  // scope the parameters come first and then the local variables,
+  // in declaration order). depth is the number of scopes skipped
+  // to find it, or -1 if the identifier is not declared (then its
+  // class is UndeclaredClass and its type is 'error').
+  enum SymbolClass {
+    UndeclaredClass,
+    LocalVarClass,
+    ParameterClass,
+    FunctionClass
+  };
+  struct Binding {
+    IdentId          ident    = NoIdent;
+    SymbolClass      symClass = UndeclaredClass;
+    TypesMgr::TypeId type     = 0;
+    std::size_t      slot     = 0;
+    int              depth    = -1;
+  };
 
   // Constructor
   SymTable(TypesMgr & Types);
@@ -80,25 +110,45 @@ public:
   //   - returns the current scope
   ScopeId topScope      ()                          const;
 
+  // Interned identifiers
+  //   - returns the IdentId of ident (a new one the first time)
+  IdentId             intern      (const std::string & ident);
+  //   - returns the IdentId of ident, or NoIdent if it was never interned
+  IdentId             lookupIdent (const std::string & ident) const;
+  //   - returns the name of an interned identifier
+  const std::string & identName   (IdentId id)                const;
+
   // Methods to find an ident
   //   - in the current scope (top of the stack)
   bool    findInCurrentScope (const std::string & ident)             const;
+  bool    findInCurrentScope (IdentId id)                            const;
   //   - in the whole stack. Returns the number of scopes skipped to
                           // find the symbol, or -1 if it is not found
   int     findInStack        (const std::string & ident)             const;
+  int     findInStack        (IdentId id)                            const;
 
   // Adds a new symbol in the current scope
   void addLocalVar  (const std::string & ident, TypesMgr::TypeId type);
   void addParameter (const std::string & ident, TypesMgr::TypeId type);
   void addFunction  (const std::string & ident, TypesMgr::TypeId type);
+  void addLocalVar  (IdentId id, TypesMgr::TypeId type);
+  void addParameter (IdentId id, TypesMgr::TypeId type);
+  void addFunction  (IdentId id, TypesMgr::TypeId type);
 
   // Accessors to check the class of the symbol. If not found return false
   bool isLocalVarClass  (const std::string & ident) const;
   bool isParameterClass (const std::string & ident) const;
   bool isFunctionClass  (const std::string & ident) const;
+  bool isLocalVarClass  (IdentId id)                const;
+  bool isParameterClass (IdentId id)                const;
+  bool isFunctionClass  (IdentId id)                const;
 
   // Accessor to get the TypeId of a symbol. If not found return type 'error'
   TypesMgr::TypeId getType (const std::string & ident) const;
+  TypesMgr::TypeId getType (IdentId id)                const;
+
+  // Resolves an identifier in the current stack of scopes
+  Binding resolve (IdentId id) const;
 
   // Print the symbols of a scope on the standard output
   //   - the symbols of the current scope (top of the stack)
@@ -117,9 +167,21 @@ private:
   class ScopeInfo;
 
   // Attributes:
-  TypesMgr               & Types;
-  std::vector<ScopeInfo>   ScopesVec;
-  std::vector<ScopeId>     ScopeIdsStack;
+  TypesMgr                 & Types;
+  std::vector<ScopeInfo, ArenaAllocator<ScopeInfo> > ScopesVec;
+  std::vector<ScopeId>       ScopeIdsStack;
+  //   - the interned identifiers: their names, the hash of each name
+  //     and an open-addressing table (linear probing) of IdentId's
+  std::vector<std::string, ArenaAllocator<std::string> > IdentNames;
+  std::vector<std::size_t, ArenaAllocator<std::size_t> > IdentHashes;
+  std::vector<IdentId,     ArenaAllocator<IdentId> >     IdentSlots;
+
+  // Hash function for the names of the identifiers
+  static std::size_t hashIdent (const std::string & ident);
+  // Returns the scope where id is declared searching the stack from
+  // the top, and sets d to the number of scopes skipped. Returns
+  // nullptr if id is not found
+  const ScopeInfo * findScopeOf (IdentId id, int & d) const;
 
   //////////////////////////////////////////////////////////////////
   // Class ScopeInfo: is declared inside SymTable and is private,
@@ -130,41 +192,53 @@ private:
   public:
     // Constructor
     ScopeInfo () = delete;
-    ScopeInfo (const std::string & name);
+    ScopeInfo (IdentId name);
 
     // Accessor to get the name of the scope
-    std::string getName () const;
+    IdentId getName () const;
 
     // Mutators to add symbols to the scope
-    void addLocalVar  (const std::string & ident, TypesMgr::TypeId type);
-    void addParameter (const std::string & ident, TypesMgr::TypeId type);
-    void addFunction  (const std::string & ident, TypesMgr::TypeId type);
+    void addLocalVar  (IdentId id, TypesMgr::TypeId type);
+    void addParameter (IdentId id, TypesMgr::TypeId type);
+    void addFunction  (IdentId id, TypesMgr::TypeId type);
 
     // Accessor to check the existence of a symbol
-    bool findSymbol (const std::string & ident) const;
+    bool findSymbol (IdentId id) const;
 
     // Accessors to check the class of the symbol. If not found return false
-    bool isLocalVarClass  (const std::string & ident) const;
-    bool isParameterClass (const std::string & ident) const;
-    bool isFunctionClass  (const std::string & ident) const;
+    bool isLocalVarClass  (IdentId id) const;
+    bool isParameterClass (IdentId id) const;
+    bool isFunctionClass  (IdentId id) const;
 
     // Accessor to get the TypeId of a symbol. The symbol MUST exist
-    TypesMgr::TypeId getType (const std::string & ident) const;
+    TypesMgr::TypeId getType (IdentId id) const;
+
+    // Fills the class, type and slot of a binding. The symbol MUST exist
+    void bind (IdentId id, Binding & b) const;
 
     // Writes the contents of the scope to the standard output
-    void print (TypesMgr & Types) const;
+    void print (TypesMgr & Types, const SymTable & SymTab) const;
 
   private:
 
     // Formard decration of class SymbolInfo
     class SymbolInfo;
 
+    // Position in Idents/Symbols of a symbol, or NoPos if not declared
+    static const std::size_t NoPos = static_cast<std::size_t>(-1);
+    std::size_t findPos (IdentId id) const;
+    // Adds a symbol (that must not exist) at the end of Idents/Symbols
+    void addSymbol (IdentId id, const SymbolInfo & info);
+
     // For the name of the scope
-    std::string name;
-    // The information associated to each identifier declared in this scope.
-    std::map<std::string, SymbolInfo> SymbolsMap;
-    // For remember the order in which the Ids where introduced.
-    std::vector<std::string> IdentsList;
+    IdentId name;
+    // The identifiers declared in this scope, in the order in which
+    // they were introduced, and the information of each one
+    std::vector<IdentId,     ArenaAllocator<IdentId> >     Idents;
+    std::vector<SymbolInfo,  ArenaAllocator<SymbolInfo> >  Symbols;
+    // Open-addressing table (linear probing): each used slot keeps
+    // the position in Idents/Symbols of a symbol, plus one (0 = empty)
+    std::vector<std::size_t, ArenaAllocator<std::size_t> > Slots;
 
 
     //////////////////////////////////////////////////////////////////
@@ -33,58 +33,65 @@
 #include "SymTable.h"
 #include "code.h"
 
-#include "antlr4-runtime.h"
 #include "antlr4-runtime.h"
 
 #include <string>
 
 
-// Getters:
+// Getters (a node without the attribute gets its default value):
 SymTable::ScopeId TreeDecoration::getScope(antlr4::ParserRuleContext *ctx) {
-  return ScopeDecor.get(ctx);
+  return lookup(ScopeDecor, ctx);
 }
 
 TypesMgr::TypeId TreeDecoration::getType(antlr4::ParserRuleContext *ctx) {
-  return TypeDecor.get(ctx);
+  return lookup(TypeDecor, ctx);
+}
+
+SymTable::Binding TreeDecoration::getBinding(antlr4::ParserRuleContext *ctx) {
+  return lookup(BindingDecor, ctx);
 }
 
 bool TreeDecoration::getIsLValue(antlr4::ParserRuleContext *ctx) {
-  return IsLValueDecor.get(ctx);
+  return lookup(IsLValueDecor, ctx);
 }
 
 std::string TreeDecoration::getAddr(antlr4::ParserRuleContext *ctx) {
-  return AddrDecor.get(ctx);
+  return lookup(AddrDecor, ctx);
 }
 
 std::string TreeDecoration::getOffset(antlr4::ParserRuleContext *ctx) {
-  return OffsetDecor.get(ctx);
+  return lookup(OffsetDecor, ctx);
 }
 
 instructionList TreeDecoration::getCode(antlr4::ParserRuleContext *ctx) {
-  return CodeDecor.get(ctx);
+  return lookup(CodeDecor, ctx);
 }
 
 // Setters:
 void TreeDecoration::putScope(antlr4::ParserRuleContext *ctx, SymTable::ScopeId s) {
-  ScopeDecor.put(ctx, s);
+  ScopeDecor[ctx] = s;
 }
 
 void TreeDecoration::putType(antlr4::ParserRuleContext *ctx, TypesMgr::TypeId t) {
-  TypeDecor.put(ctx, t);
+  TypeDecor[ctx] = t;
+}
+
+void TreeDecoration::putBinding(antlr4::ParserRuleContext *ctx, const SymTable::Binding & b) {
+  BindingDecor[ctx] = b;
 }
 
 void TreeDecoration::putIsLValue(antlr4::ParserRuleContext *ctx, bool b) {
-  IsLValueDecor.put(ctx, b);
+  IsLValueDecor[ctx] = b;
 }
 
 void TreeDecoration::putAddr(antlr4::ParserRuleContext *ctx, const std::string & a) {
-  AddrDecor.put(ctx, a);
+  AddrDecor[ctx] = a;
 }
 
 void TreeDecoration::putOffset(antlr4::ParserRuleContext *ctx, const std::string & o) {
-  OffsetDecor.put(ctx, o);
+  OffsetDecor[ctx] = o;
 }
 
 void TreeDecoration::putCode(antlr4::ParserRuleContext *ctx, const instructionList & c) {
-  CodeDecor.put(ctx, c);
+  CodeDecor[ctx] = c;
 }
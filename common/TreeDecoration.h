@@ -32,9 +32,14 @@
 #include "TypesMgr.h"
 #include "SymTable.h"
 #include "code.h"
+#include "Arena.h"
 
 #include "antlr4-runtime.h"
-#include "tree/ParseTreeProperty.h"
+
+#include <map>
+#include <string>
+#include <functional> // std::less
+#include <utility>    // std::pair
 
 // using namespace std;
 
@@ -44,10 +49,13 @@
 // by the antlr4 parser, whose base type is
 // antlr4::ParserRuleContext *, can have different attributes.
 // TreeDecoration groups all of them, and uses different
-// ParseTreeProperty to save this information.
-// Currently six kinds of attributes may be present:
+// maps (like ParseTreeProperty) to save this information. The
+// nodes of the maps are allocated in the current Arena.
+// Currently seven kinds of attributes may be present:
 //   - scope, for nodes like the program, or functions
 //   - type, for expressions or type especification
+//   - binding, for the nodes using an identifier (the symbol it
+//     refers to, resolved once during the type check)
 //   - isLValue, for expressions
 //   - addr, for expressions
 //   - offset, for expressions
@@ -60,10 +68,14 @@
 //       * access the scope attribute
 //       * set and access the type attribute (in expressions)
 //       * set and access the isLValue attribute (in expressions)
+//       * set the binding attribute (in identifier uses)
 //   - CodeGenListener     [Code Generation]
 //       * access the scope attribute
 //       * access the type attribute
+//       * access the binding attribute
 //       * set and access the addr, offset and code attributes
+//         (in a TreeDecoration of its own for each function, when
+//         the functions are generated in parallel)
 
 class TreeDecoration {
 
@@ -73,6 +85,7 @@ public:
   // Getters:
   SymTable::ScopeId getScope    (antlr4::ParserRuleContext *ctx);
   TypesMgr::TypeId  getType     (antlr4::ParserRuleContext *ctx);
+  SymTable::Binding getBinding  (antlr4::ParserRuleContext *ctx);
   bool              getIsLValue (antlr4::ParserRuleContext *ctx);
   std::string       getAddr     (antlr4::ParserRuleContext *ctx);
   std::string       getOffset   (antlr4::ParserRuleContext *ctx);
@@ -81,17 +94,34 @@ public:
   // Setters:
   void putScope    (antlr4::ParserRuleContext *ctx, SymTable::ScopeId s);
   void putType     (antlr4::ParserRuleContext *ctx, TypesMgr::TypeId t);
+  void putBinding  (antlr4::ParserRuleContext *ctx, const SymTable::Binding & b);
   void putIsLValue (antlr4::ParserRuleContext *ctx, bool b);
   void putAddr     (antlr4::ParserRuleContext *ctx, const std::string & a);
   void putOffset   (antlr4::ParserRuleContext *ctx, const std::string & o);
   void putCode     (antlr4::ParserRuleContext *ctx, const instructionList & c);
 
 private:
-  antlr4::tree::ParseTreeProperty<SymTable::ScopeId> ScopeDecor;
-  antlr4::tree::ParseTreeProperty<TypesMgr::TypeId>  TypeDecor;
-  antlr4::tree::ParseTreeProperty<bool>              IsLValueDecor;
-  antlr4::tree::ParseTreeProperty<std::string>       AddrDecor;
-  antlr4::tree::ParseTreeProperty<std::string>       OffsetDecor;
-  antlr4::tree::ParseTreeProperty<instructionList>   CodeDecor;
+  // A property of the nodes of the tree
+  template <typename T>
+  using Property = std::map<antlr4::tree::ParseTree *, T,
+                            std::less<antlr4::tree::ParseTree *>,
+                            ArenaAllocator<std::pair<antlr4::tree::ParseTree * const, T> > >;
+
+  Property<SymTable::ScopeId> ScopeDecor;
+  Property<TypesMgr::TypeId>  TypeDecor;
+  Property<SymTable::Binding> BindingDecor;
+  Property<bool>              IsLValueDecor;
+  Property<std::string>       AddrDecor;
+  Property<std::string>       OffsetDecor;
+  Property<instructionList>   CodeDecor;
+
+  // Value of a property in a node, or the default value if the node
+  // does not have it. It does not modify the map, so several threads
+  // can read the same decorations at the same time
+  template <typename T>
+  static T lookup (const Property<T> & prop, antlr4::ParserRuleContext *ctx) {
+    auto it = prop.find(ctx);
+    return it == prop.end() ? T() : it->second;
+  }
 
 };  // class TreeDecoration
@@ -31,6 +31,9 @@
 
 #include <vector>
 #include <string>
+#include <unordered_map>
+#include <utility>    // std::pair
+#include <algorithm>  // std::equal
 #include <iostream>
 
 #include <cstddef>    // std::size_t
@@ -47,15 +50,14 @@
 // ----------------------------------------------------------------------
 // constructor
 
-TypesMgr::TypesMgr() {
-  // Prebuilt and insert in TypesVec the Type's of the primitive types
-  TypesVec = std::vector<Type>(NumPrimitiveAndErrorTypes);
-  TypesVec[ErrorTyId]     = Type(TypeKind::ErrorKind);
-  TypesVec[IntegerTyId]   = Type(TypeKind::IntegerKind);
-  TypesVec[FloatTyId]     = Type(TypeKind::FloatKind);
-  TypesVec[BooleanTyId]   = Type(TypeKind::BooleanKind);
-  TypesVec[CharacterTyId] = Type(TypeKind::CharacterKind);
-  TypesVec[VoidTyId]      = Type(TypeKind::VoidKind);
+TypesMgr::TypesMgr() :
+  FunctionTypes(0, FunctionKeyHash{this}, FunctionKeyEqual{this}),
+  ProbeParams(nullptr) {
+  // Prebuilt the primitive types: the TypeId of each one is its kind
+  Kinds = { TypeKind::ErrorKind, TypeKind::IntegerKind, TypeKind::FloatKind,
+            TypeKind::BooleanKind, TypeKind::CharacterKind, TypeKind::VoidKind };
+  Info  = std::vector<std::size_t>(NumPrimitiveAndErrorTypes, 0);
+  assert(Kinds.size() == NumPrimitiveAndErrorTypes);
 }
 
 // ----------------------------------------------------------------------
@@ -87,14 +89,55 @@ TypesMgr::TypeId TypesMgr::createVoidTy() {
 
 TypesMgr::TypeId TypesMgr::createFunctionTy(const std::vector<TypeId> & paramsTypes,
 					    TypeId returnType) {
-  TypesVec.push_back(Type(paramsTypes, returnType));
-  return TypesVec.size()-1;
+  // look it up without copying the parameters
+  ProbeParams = &paramsTypes;
+  auto it = FunctionTypes.find(FunctionInfo{Probe, paramsTypes.size(), returnType});
+  ProbeParams = nullptr;
+  if (it != FunctionTypes.end())
+    return it->second;
+  TypeId tid = Kinds.size();
+  FunctionInfo f{ParamsPool.size(), paramsTypes.size(), returnType};
+  Kinds.push_back(TypeKind::FunctionKind);
+  Info.push_back(Functions.size());
+  Functions.push_back(f);
+  ParamsPool.insert(ParamsPool.end(), paramsTypes.begin(), paramsTypes.end());
+  FunctionTypes.emplace(f, tid);
+  return tid;
 }
 
 TypesMgr::TypeId TypesMgr::createArrayTy(unsigned int size,
 					 TypeId elemType) {
-  TypesVec.push_back(Type{size, elemType});
-  return TypesVec.size()-1;
+  auto key = std::make_pair(size, elemType);
+  auto it = ArrayTypes.find(key);
+  if (it != ArrayTypes.end())
+    return it->second;
+  TypeId tid = Kinds.size();
+  Kinds.push_back(TypeKind::ArrayKind);
+  Info.push_back(Arrays.size());
+  Arrays.push_back(ArrayInfo{size, elemType});
+  ArrayTypes.emplace(key, tid);
+  return tid;
+}
+
+// ----------------------------------------------------------------------
+// hash functions for the keys of the compound types
+
+std::size_t TypesMgr::ArrayKeyHash::operator() (const std::pair<unsigned int, TypeId> & k) const {
+  return std::hash<TypeId>()(k.second) * 31 + k.first;
+}
+
+std::size_t TypesMgr::FunctionKeyHash::operator() (const FunctionInfo & k) const {
+  std::size_t h = std::hash<TypeId>()(k.returnTy);
+  for (TypeId t : types->getKeyParams(k))
+    h = h * 31 + std::hash<TypeId>()(t);
+  return h;
+}
+
+bool TypesMgr::FunctionKeyEqual::operator() (const FunctionInfo & a, const FunctionInfo & b) const {
+  if (a.returnTy != b.returnTy or a.numParams != b.numParams)
+    return false;
+  TypeIdSpan pa = types->getKeyParams(a), pb = types->getKeyParams(b);
+  return std::equal(pa.begin(), pa.end(), pb.begin());
 }
 
 // ----------------------------------------------------------------------
@@ -142,97 +185,54 @@ bool TypesMgr::isPrimitiveNonVoidTy(TypeId tid) const {
 // accessors for working with function types
 
 bool TypesMgr::isFunctionTy(TypeId tid) const {
-  const Type & t = TypesVec.at(tid);
-  return t.isFunctionTy();
+  return Kinds.at(tid) == TypeKind::FunctionKind;
 }
 
-const std::vector<TypesMgr::TypeId> & TypesMgr::getFuncParamsTypes(TypeId tid) const {
-  const Type & t = TypesVec.at(tid);
-  assert(t.isFunctionTy());
-  return t.getFuncParamsTypes();
+TypesMgr::TypeIdSpan TypesMgr::getFuncParamsTypes(TypeId tid) const {
+  const FunctionInfo & f = getFunctionInfo(tid);
+  return TypeIdSpan(ParamsPool.data() + f.firstParam, f.numParams);
 }
 
 TypesMgr::TypeId TypesMgr::getFuncReturnType(TypeId tid) const {
-  const Type & t = TypesVec.at(tid);
-  assert(t.isFunctionTy());
-  return t.getFuncReturnType();
+  return getFunctionInfo(tid).returnTy;
 }
 
 std::size_t TypesMgr::getNumOfParameters(TypeId tid) const {
-  const Type & t = TypesVec.at(tid);
-  assert(t.isFunctionTy());
-  return t.getNumOfParameters();
+  return getFunctionInfo(tid).numParams;
 }
 
 TypesMgr::TypeId TypesMgr::getParameterType(TypeId tid, unsigned int i) const {
-  const Type & t = TypesVec.at(tid);
-  assert(t.isFunctionTy() and i < t.getNumOfParameters());
-  return t.getParameterType(i);
+  const FunctionInfo & f = getFunctionInfo(tid);
+  assert(i < f.numParams);
+  return ParamsPool[f.firstParam + i];
 }
 
 bool TypesMgr::isVoidFunction(TypeId tid) const {
-  const Type & t = TypesVec.at(tid);
-  assert(t.isFunctionTy());
-  TypeId tr = t.getFuncReturnType();
-  return isVoidTy(tr);
+  return isVoidTy(getFunctionInfo(tid).returnTy);
 }
 
 // ----------------------------------------------------------------------
 // accessors for working with array types
 
 bool TypesMgr::isArrayTy(TypeId tid) const {
-  const Type & t = TypesVec.at(tid);
-  return t.isArrayTy();
+  return Kinds.at(tid) == TypeKind::ArrayKind;
 }
 
 unsigned int TypesMgr::getArraySize(TypeId tid) const {
-  const Type & t = TypesVec.at(tid);
-  assert(t.isArrayTy());
-  return t.getArraySize();
+  return getArrayInfo(tid).size;
 }
 
 TypesMgr::TypeId TypesMgr::getArrayElemType(TypeId tid) const {
-  const Type & t = TypesVec.at(tid);
-  assert(t.isArrayTy());
-  return t.getArrayElemType();
+  return getArrayInfo(tid).elemTy;
 }
 
 // ----------------------------------------------------------------------
 // methods for checking different compatibilities of Types
 
 bool TypesMgr::equalTypes(TypeId tid1, TypeId tid2) const {
-  if (tid1 == tid2)
-    return true;
-  const Type & t1 = TypesVec.at(tid1);
-  const Type & t2 = TypesVec.at(tid2);
-  if (t1.getTypeKind() != t2.getTypeKind())
-    return false;
-  if (t1.isPrimitiveTy() and t2.isPrimitiveTy())
-    return true;
-  if (t1.isFunctionTy()) {  // or: if (t2.isFunctionTy()) {
-    if (t1.getNumOfParameters() != t2.getNumOfParameters())
-      return false;
-    TypeId tid1_aux;
-    TypeId tid2_aux;
-    for (unsigned int i = 0; i < t1.getNumOfParameters(); ++i) {
-      tid1_aux = t1.getParameterType(i);
-      tid2_aux = t2.getParameterType(i);
-      if (not equalTypes(tid1_aux, tid2_aux))
-	return false;
-    }
-    tid1_aux = t1.getFuncReturnType();
-    tid2_aux = t2.getFuncReturnType();
-    return equalTypes(tid1_aux, tid2_aux);
-  }
-  if (t1.isArrayTy()) {  // or: if (t2.isArrayTy()) {
-    if (t1.getArraySize() != t2.getArraySize()) {
-      return false;
-    }
-    TypeId tid1_aux = t1.getArrayElemType();
-    TypeId tid2_aux = t2.getArrayElemType();
-    return equalTypes(tid1_aux, tid2_aux);
-  }
-  return false;
+  // compound types are created only once (see createFunctionTy and
+  // createArrayTy), so structurally equal types have the same TypeId
+  return tid1 == tid2;
 }
 
 bool TypesMgr::comparableTypes(TypeId tid1, TypeId tid2,
@@ -262,10 +262,8 @@ bool TypesMgr::copyableTypes(TypeId tid1, TypeId tid2) const {
 std::size_t TypesMgr::getSizeOfType (TypeId tid) const {
   if (isPrimitiveNonVoidTy(tid)) return 1;
   if (isArrayTy(tid)) {
-    const Type & tArr = TypesVec.at(tid);
-    std::size_t nElems = tArr.getArraySize();
-    TypeId tElem = tArr.getArrayElemType();
-    return nElems * getSizeOfType(tElem);
+    const ArrayInfo & tArr = getArrayInfo(tid);
+    return tArr.size * getSizeOfType(tArr.elemTy);
   }
   return 0;
 }
@@ -284,26 +282,25 @@ std::string TypesMgr::to_string(TypeId tid) const {
     case VoidTyId:      return "void";
     }
   }
-  const Type & t = TypesVec.at(tid);
-  if (t.isFunctionTy()) {
+  if (isFunctionTy(tid)) {
     TypeId tid1;
     std::string s = "function<";
-    if (t.getNumOfParameters() > 0) {
-      tid1 = t.getParameterType(0);
+    if (getNumOfParameters(tid) > 0) {
+      tid1 = getParameterType(tid, 0);
       s = s + to_string(tid1);
     }
-    for (unsigned int i = 1; i < t.getNumOfParameters(); ++i) {
-      tid1 = t.getParameterType(i);
+    for (unsigned int i = 1; i < getNumOfParameters(tid); ++i) {
+      tid1 = getParameterType(tid, i);
       s = s + "," + to_string(tid1);
     }
-    tid1 = t.getFuncReturnType();
+    tid1 = getFuncReturnType(tid);
     s = s + ">:" + to_string(tid1);
     return s;
   }
-  else if (t.isArrayTy()) {
+  else if (isArrayTy(tid)) {
     TypeId tid1;
-    std::string s = "array<" + std::to_string(t.getArraySize()) + ",";
-    tid1 = t.getArrayElemType();
+    std::string s = "array<" + std::to_string(getArraySize(tid)) + ",";
+    tid1 = getArrayElemType(tid);
     s = s + to_string(tid1) +">";
     return s;
   }
@@ -317,119 +314,50 @@ void TypesMgr::dump(TypeId tid, std::ostream & os) const {
 }
 
 
-// ======================================================================
-// class TypesMgr::Type
-
 // ----------------------------------------------------------------------
-// constructors
+// access to the information of a compound type
 
-TypesMgr::Type::Type(TypeKind tid) : ID{tid} {
-  assert(TypeKind::FirstPrimitiveKind < ID and
-	 ID < TypeKind::LastPrimitiveKind);
+const TypesMgr::ArrayInfo & TypesMgr::getArrayInfo(TypeId tid) const {
+  assert(isArrayTy(tid));
+  return Arrays[Info[tid]];
 }
 
-TypesMgr::Type::Type(const std::vector<TypeId> & paramsTypes, TypeId returnType) :
-  ID{TypesMgr::TypeKind::FunctionKind},
-  funcParamsTy{paramsTypes},
-  funcReturnTy{returnType} {
-  }
-
-TypesMgr::Type::Type(unsigned int arraySize, TypeId arrayElemType) :
-  ID{TypesMgr::TypeKind::ArrayKind},
-  arraySize{arraySize},
-  arrayElemTy{arrayElemType} {
-  }
-
-// ----------------------------------------------------------------------
-// accesor to get the kind
-
-TypesMgr::TypeKind TypesMgr::Type::getTypeKind () const {
-  return ID;
+const TypesMgr::FunctionInfo & TypesMgr::getFunctionInfo(TypeId tid) const {
+  assert(isFunctionTy(tid));
+  return Functions[Info[tid]];
 }
 
-// ----------------------------------------------------------------------
-// accessors for working with primitive types
-
-bool TypesMgr::Type::isErrorTy() const {
-  return ID == TypeKind::ErrorKind;
+TypesMgr::TypeIdSpan TypesMgr::getKeyParams(const FunctionInfo & k) const {
+  if (k.firstParam == Probe)
+    return TypeIdSpan(ProbeParams->data(), k.numParams);
+  return TypeIdSpan(ParamsPool.data() + k.firstParam, k.numParams);
 }
 
-bool TypesMgr::Type::isIntegerTy() const {
-  return ID == TypeKind::IntegerKind;
-}
-
-bool TypesMgr::Type::isFloatTy() const {
-  return ID == TypeKind::FloatKind;
-}
-
-bool TypesMgr::Type::isBooleanTy() const {
-  return ID == TypeKind::BooleanKind;
-}
-
-bool TypesMgr::Type::isCharacterTy() const {
-  return ID == TypeKind::CharacterKind;
-}
 
-bool TypesMgr::Type::isVoidTy() const {
-  return ID == TypeKind::VoidKind;
-}
-
-bool TypesMgr::Type::isNumericTy() const {
-  return (ID == TypeKind::IntegerKind or
-	  ID == TypeKind::FloatKind);
-}
-
-bool TypesMgr::Type::isPrimitiveTy() const {
-  return (ID == TypeKind::IntegerKind or
-	  ID == TypeKind::FloatKind or
-	  ID == TypeKind::BooleanKind or
-	  ID == TypeKind::CharacterKind or
-	  ID == TypeKind::VoidKind);
-}
-
-bool TypesMgr::Type::isPrimitiveNonVoidTy() const {
-  return (isPrimitiveTy() and not isVoidTy());
-}
-
-// ----------------------------------------------------------------------
-// accessors for working with function types
-
-bool TypesMgr::Type::isFunctionTy() const {
-  return ID == TypeKind::FunctionKind;
-}
-
-const std::vector<TypesMgr::TypeId> & TypesMgr::Type::getFuncParamsTypes() const {
-  return funcParamsTy;
-}
-
-TypesMgr::TypeId TypesMgr::Type::getFuncReturnType() const {
-  return funcReturnTy;
-}
+// ======================================================================
+// class TypesMgr::TypeIdSpan
 
-std::size_t TypesMgr::Type::getNumOfParameters() const {
-  return getFuncParamsTypes().size();
+TypesMgr::TypeIdSpan::TypeIdSpan(const TypeId *first, std::size_t n) :
+  first{first}, n{n} {
 }
 
-TypesMgr::TypeId TypesMgr::Type::getParameterType(unsigned int i) const {
-  assert(i < getNumOfParameters());
-  return getFuncParamsTypes()[i];
+const TypesMgr::TypeId * TypesMgr::TypeIdSpan::begin() const {
+  return first;
 }
 
-bool TypesMgr::Type::isVoidFunction() const {
-  return getFuncReturnType() == TypeKind::VoidKind;
+const TypesMgr::TypeId * TypesMgr::TypeIdSpan::end() const {
+  return first + n;
 }
 
-// ----------------------------------------------------------------------
-// accessors for working with array types
-
-bool TypesMgr::Type::isArrayTy() const {
-  return ID == TypeKind::ArrayKind;
+std::size_t TypesMgr::TypeIdSpan::size() const {
+  return n;
 }
 
-unsigned int TypesMgr::Type::getArraySize() const {
-  return arraySize;
+bool TypesMgr::TypeIdSpan::empty() const {
+  return n == 0;
 }
 
-TypesMgr::TypeId TypesMgr::Type::getArrayElemType() const {
-  return arrayElemTy;
+TypesMgr::TypeId TypesMgr::TypeIdSpan::operator[](std::size_t i) const {
+  assert(i < n);
+  return first[i];
 }
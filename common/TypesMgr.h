@@ -30,6 +30,8 @@
 
 #include <vector>
 #include <string>
+#include <unordered_map>
+#include <utility>    // std::pair
 #include <iostream>
 
 #include <cstddef>    // std::size_t
@@ -54,8 +56,27 @@ public:
   // The TypeId is an index in a vector
   typedef std::size_t TypeId;
 
-  // Constructor
+  // Read-only view of the parameter types of a function type. It
+  // points into the TypesMgr, so it must not be kept while new
+  // function types are being created
+  class TypeIdSpan {
+  public:
+    TypeIdSpan (const TypeId *first, std::size_t n);
+    const TypeId * begin      ()              const;
+    const TypeId * end        ()              const;
+    std::size_t    size       ()              const;
+    bool           empty      ()              const;
+    TypeId         operator[] (std::size_t i) const;
+  private:
+    const TypeId *first;
+    std::size_t   n;
+  };
+
+  // Constructor (the intern map of the function types refers to
+  // this object, so it can not be copied)
   TypesMgr ();
+  TypesMgr (const TypesMgr &) = delete;
+  TypesMgr & operator= (const TypesMgr &) = delete;
 
   // Methods to create a Type and return its TypeId
   //   - Primitive and error types
@@ -84,7 +105,7 @@ public:
 
   // Accessors to work with function types
   bool                        isFunctionTy       (TypeId tid)     const;
-  const std::vector<TypeId> & getFuncParamsTypes (TypeId tid)     const;
+  TypeIdSpan                  getFuncParamsTypes (TypeId tid)     const;
   TypeId                      getFuncReturnType  (TypeId tid)     const;
   std::size_t                 getNumOfParameters (TypeId tid)     const;
   TypeId                      getParameterType   (TypeId tid,
@@ -97,7 +118,7 @@ public:
   TypeId       getArrayElemType (TypeId tid) const;
 
   // Methods to check different compatibilities of types
-  //   - structurally equal?
+  //   - structurally equal? (types are unique, so it compares TypeId's)
   bool equalTypes      (TypeId tid1, TypeId tid2)     const;
   //   - comparable with the relational operator op?
   bool comparableTypes (TypeId tid1, TypeId tid2,
@@ -115,12 +136,6 @@ public:
 
 
 private:
-  // Forward declaration of class Type
-  class Type;
-
-  // Attributes:
-  //   - vector to save the Types
-  std::vector<Type> TypesVec;
 
   // There are eight kinds of types:
   //   - an especial kind error,
@@ -155,66 +170,59 @@ private:
   //   - number of primitive and 'error' types
   static const unsigned int NumPrimitiveAndErrorTypes = LastPrimitiveKind - FirstPrimitiveKind - 1;
 
+  // Information of the compound types
+  struct ArrayInfo {
+    unsigned int size;
+    TypeId       elemTy;
+  };
+  struct FunctionInfo {
+    std::size_t  firstParam;   // position in ParamsPool
+    std::size_t  numParams;
+    TypeId       returnTy;
+  };
 
-  //////////////////////////////////////////////////////////////////
-  // Class Type: is declared inside TypeMgr and is private,
-  // so only the TypeMgr can operate with Type objects.
-  // It keeps the information of any type. When a type is
-  // compound, the subtypes (for example the types of the parameters
-  // of a function, or the type of the elements of an array) are
-  // referenced by their respective TypeId's.
-  class Type {
-
-  public:
-    // Constructors for primitive, function and array Types
-    Type (TypeKind                    tid = TypeKind::VoidKind);
-    Type (const std::vector<TypeId> & paramsTypes,
-	  TypeId                      returnType);
-    Type (unsigned int                arraySize,
-	  TypeId                      arrayElemType);
-
-    // Destructor
-    ~Type () = default;
-
-    // Accesor to get the kind
-    TypeKind getTypeKind () const;
-
-    // Accessors to work with primitive and 'error' types
-    bool isErrorTy            () const;
-    bool isIntegerTy          () const;
-    bool isFloatTy            () const;
-    bool isBooleanTy          () const;
-    bool isCharacterTy        () const;
-    bool isVoidTy             () const;
-    bool isNumericTy          () const;
-    bool isPrimitiveTy        () const;
-    bool isPrimitiveNonVoidTy () const;
-
-    // Accessors to work with function types
-    bool                        isFunctionTy       ()               const;
-    const std::vector<TypeId> & getFuncParamsTypes ()               const;
-    TypeId                      getFuncReturnType  ()               const;
-    std::size_t                 getNumOfParameters ()               const;
-    TypeId                      getParameterType   (unsigned int i) const;
-    bool                        isVoidFunction     ()               const;
-
-    // Accessors to work with array types
-    bool         isArrayTy        () const;
-    unsigned int getArraySize     () const;
-    TypeId       getArrayElemType () const;
-
-  private:
-
-    // Atributes:
-    //   - the kind of type
-    TypeKind ID;
-    //   - to represent the type of a function:
-    std::vector<TypeId> funcParamsTy;
-    TypeId funcReturnTy;
-    //   - to represent the type of an array:
-    unsigned int arraySize;
-    TypeId arrayElemTy;
-
-  };  // class Type
+  // Hash functions for the keys of the compound types
+  struct ArrayKeyHash {
+    std::size_t operator() (const std::pair<unsigned int, TypeId> & k) const;
+  };
+  //   - a function type is keyed by its span in ParamsPool and its
+  //     return type, so its parameters are stored only once. The
+  //     key of a type being looked up has firstParam == Probe, and
+  //     its parameters in ProbeParams
+  struct FunctionKeyHash {
+    const TypesMgr * types;
+    std::size_t operator() (const FunctionInfo & k) const;
+  };
+  struct FunctionKeyEqual {
+    const TypesMgr * types;
+    bool operator() (const FunctionInfo & a, const FunctionInfo & b) const;
+  };
+  static const std::size_t Probe = std::size_t(-1);
+
+  // Attributes: the types are stored as a structure of arrays
+  //   - the kind of each type (indexed by TypeId)
+  std::vector<TypeKind>     Kinds;
+  //   - for compound types, the position of its information in
+  //     Arrays or Functions (indexed by TypeId)
+  std::vector<std::size_t>  Info;
+  //   - information of the array and function types
+  std::vector<ArrayInfo>    Arrays;
+  std::vector<FunctionInfo> Functions;
+  //   - the parameter types of all the functions, one after another
+  std::vector<TypeId>       ParamsPool;
+  //   - compound types already created (hash-consing): structurally
+  //     identical types share their TypeId, so they are equal iff
+  //     their TypeId's are equal
+  std::unordered_map<std::pair<unsigned int, TypeId>,
+                     TypeId, ArrayKeyHash>    ArrayTypes;
+  std::unordered_map<FunctionInfo, TypeId,
+                     FunctionKeyHash, FunctionKeyEqual> FunctionTypes;
+  const std::vector<TypeId> * ProbeParams;
+
+  // Access to the information of a compound type
+  const ArrayInfo    & getArrayInfo    (TypeId tid) const;
+  const FunctionInfo & getFunctionInfo (TypeId tid) const;
+  // Parameter types of a key of FunctionTypes
+  TypeIdSpan           getKeyParams    (const FunctionInfo & k) const;
 
 };  // class TypesMgr
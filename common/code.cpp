@@ -27,6 +27,9 @@
 ////////////////////////////////////////////////////////////////
 
 #include <iostream>
+#include <sstream>
+#include <algorithm>  // std::max
+#include <cstdlib>    // std::atoi
 #include "code.h"
 
 using namespace std;
@@ -41,6 +44,10 @@ instruction::instruction(Operation op,
   arg1 = a1;
   arg2 = a2;
   arg3 = a3;
+  line = 0;
+  column = 0;
+  bound = 0;
+  inRange = false;
 }
 
 instruction instruction::LABEL(const std::string &a1) { return instruction(_LABEL, a1); }
@@ -74,8 +81,18 @@ instruction instruction::LOAD(const std::string &a1, const std::string &a2) { re
 instruction instruction::ILOAD(const std::string &a1, const std::string &a2) { return instruction(_ILOAD, a1, a2); }
 instruction instruction::CHLOAD(const std::string &a1, const std::string &a2) { return instruction(_CHLOAD, a1, a2); }
 instruction instruction::FLOAD(const std::string &a1, const std::string &a2) { return instruction(_FLOAD, a1, a2); }
-instruction instruction::XLOAD(const std::string &a1, const std::string &a2, const std::string &a3) { return instruction(_XLOAD, a1, a2, a3); }
-instruction instruction::LOADX(const std::string &a1, const std::string &a2, const std::string &a3) { return instruction(_LOADX, a1, a2, a3); }
+instruction instruction::XLOAD(const std::string &a1, const std::string &a2, const std::string &a3,
+                               unsigned int bound) {
+  instruction inst(_XLOAD, a1, a2, a3);
+  inst.bound = bound;
+  return inst;
+}
+instruction instruction::LOADX(const std::string &a1, const std::string &a2, const std::string &a3,
+                               unsigned int bound) {
+  instruction inst(_LOADX, a1, a2, a3);
+  inst.bound = bound;
+  return inst;
+}
 instruction instruction::ALOAD(const std::string &a1, const std::string &a2) { return instruction(_ALOAD, a1, a2); }
 instruction instruction::LOADC(const std::string &a1, const std::string &a2) { return instruction(_LOADC, a1, a2); }
 instruction instruction::CLOAD(const std::string &a1, const std::string &a2) { return instruction(_CLOAD, a1, a2); }
@@ -86,6 +103,8 @@ instruction instruction::WRITEI(const std::string &a1) { return instruction(_WRI
 instruction instruction::WRITEF(const std::string &a1) { return instruction(_WRITEF, a1); }
 instruction instruction::WRITEC(const std::string &a1) { return instruction(_WRITEC, a1); }
 instruction instruction::WRITELN() { return instruction(_WRITELN); }
+instruction instruction::WRITES(const std::string &a1, const std::string &a2) { return instruction(_WRITES, a1, a2); }
+instruction instruction::COPY(const std::string &a1, const std::string &a2, const std::string &a3) { return instruction(_COPY, a1, a2, a3); }
 instruction instruction::NOOP() { return instruction(_NOOP); }
 
 
@@ -93,57 +112,62 @@ instruction instruction::NOOP() { return instruction(_NOOP); }
 instruction::~instruction() {}
 
 string instruction::dump() const {
-  string s;
-  string ind="   ";
+  ostringstream s;
+  dump(s);
+  return s.str();
+}
+
+void instruction::dump(std::ostream &out) const {
+  if (oper != instruction::_LABEL) out << "   ";
   switch (oper) {
-  case instruction::_LABEL : { s = "label " + arg1 + " :"; ind = ""; break; }
-  case instruction::_UJUMP : { s = "goto " + arg1; break; }
-  case instruction::_FJUMP : { s = "ifFalse " + arg1 + " goto " +arg2; break; }
+  case instruction::_LABEL : { out << "label " << arg1 << " :"; break; }
+  case instruction::_UJUMP : { out << "goto " << arg1; break; }
+  case instruction::_FJUMP : { out << "ifFalse " << arg1 << " goto " << arg2; break; }
   case instruction::_LOAD : 
   case instruction::_FLOAD : 
-  case instruction::_ILOAD : { s = arg1 + " = " + arg2; break; } 
-  case instruction::_CHLOAD : { s = arg1 + " = '" + arg2 +"'"; break; } 
-  case instruction::_PUSH : { s = "pushparam " + (arg1.empty()? "" : arg1); break; }
-  case instruction::_POP : { s = "popparam " + (arg1.empty()? "" : arg1); break; }
-  case instruction::_CALL : { s = "call " + arg1; break; }
-  case instruction::_RETURN : { s = "return"; break; }
-  case instruction::_XLOAD : { s = arg1 + "[" + arg2 + "] = " + arg3; break; }
-  case instruction::_LOADX : { s = arg1 + " = " + arg2 + "[" + arg3 + "]"; break; }
-  case instruction::_ALOAD : { s = arg1 + " = &" + arg2; break; }
-  case instruction::_LOADC : { s = arg1 + " = *" + arg2; break; }
-  case instruction::_CLOAD : { s = "*" + arg1 + " = " + arg2; break; }
-  case instruction::_READI : { s = "readi " + arg1; break; }
-  case instruction::_READF : { s = "readf " + arg1; break; }
-  case instruction::_READC : { s = "readc " + arg1; break; }
-  case instruction::_WRITEI : { s = "writei " + arg1; break; }
-  case instruction::_WRITEF : { s = "writef " + arg1; break; }
-  case instruction::_WRITEC : { s = "writec " + arg1; break; }
-  case instruction::_WRITELN : { s = "writeln"; break; }
-  case instruction::_ADD : { s = arg1 + " = " + arg2 + " + " + arg3; break; }
-  case instruction::_SUB : { s = arg1 + " = " + arg2 + " - " + arg3; break; }
-  case instruction::_MUL : { s = arg1 + " = " + arg2 + " * " + arg3; break; }
-  case instruction::_DIV : { s = arg1 + " = " + arg2 + " / " + arg3; break; }
-  case instruction::_AND : { s = arg1 + " = " + arg2 + " and " + arg3; break; }
-  case instruction::_OR : { s = arg1 + " = " + arg2 + " or " + arg3; break; }
-  case instruction::_EQ : { s = arg1 + " = " + arg2 + " == " + arg3; break; }
-  case instruction::_LT : { s = arg1 + " = " + arg2 + " < " + arg3; break; }
-  case instruction::_LE : { s = arg1 + " = " + arg2 + " <= " + arg3; break; }
-  case instruction::_NOT : { s = arg1 + " = not " + arg2; break; }
-  case instruction::_NEG : { s = arg1 + " = - " + arg2; break; }
-  case instruction::_FADD : { s = arg1 + " = " + arg2 + " +. " + arg3; break; }
-  case instruction::_FSUB : { s = arg1 + " = " + arg2 + " -. " + arg3; break; }
-  case instruction::_FMUL : { s = arg1 + " = " + arg2 + " *. " + arg3; break; }
-  case instruction::_FDIV : { s = arg1 + " = " + arg2 + " /. " + arg3; break; }
-  case instruction::_FEQ : { s = arg1 + " = " + arg2 + " ==. " + arg3; break; }
-  case instruction::_FLT : { s = arg1 + " = " + arg2 + " <. " + arg3; break; }
-  case instruction::_FLE : { s =  arg1 + " = " + arg2 + " <=. " + arg3; break; }
-  case instruction::_FNEG : { s =  arg1 + " = -. " + arg2; break; }
-  case instruction::_FLOAT : { s = arg1 + " = float " + arg2; break; }
-  case instruction::_NOOP : { s = "noop"; break; }
-  default : { s = "????"; break; }
+  case instruction::_ILOAD : { out << arg1 << " = " << arg2; break; } 
+  case instruction::_CHLOAD : { out << arg1 << " = '" << arg2 << "'"; break; } 
+  case instruction::_PUSH : { out << "pushparam " << arg1; break; }
+  case instruction::_POP : { out << "popparam " << arg1; break; }
+  case instruction::_CALL : { out << "call " << arg1; break; }
+  case instruction::_RETURN : { out << "return"; break; }
+  case instruction::_XLOAD : { out << arg1 << "[" << arg2 << "] = " << arg3; break; }
+  case instruction::_LOADX : { out << arg1 << " = " << arg2 << "[" << arg3 << "]"; break; }
+  case instruction::_ALOAD : { out << arg1 << " = &" << arg2; break; }
+  case instruction::_LOADC : { out << arg1 << " = *" << arg2; break; }
+  case instruction::_CLOAD : { out << "*" << arg1 << " = " << arg2; break; }
+  case instruction::_READI : { out << "readi " << arg1; break; }
+  case instruction::_READF : { out << "readf " << arg1; break; }
+  case instruction::_READC : { out << "readc " << arg1; break; }
+  case instruction::_WRITEI : { out << "writei " << arg1; break; }
+  case instruction::_WRITEF : { out << "writef " << arg1; break; }
+  case instruction::_WRITEC : { out << "writec " << arg1; break; }
+  case instruction::_WRITELN : { out << "writeln"; break; }
+  case instruction::_WRITES : { out << "writes " << arg2; break; }
+  case instruction::_COPY : { out << "copy " << arg1 << " = " << arg2 << " (" << arg3 << ")"; break; }
+  case instruction::_ADD : { out << arg1 << " = " << arg2 << " + " << arg3; break; }
+  case instruction::_SUB : { out << arg1 << " = " << arg2 << " - " << arg3; break; }
+  case instruction::_MUL : { out << arg1 << " = " << arg2 << " * " << arg3; break; }
+  case instruction::_DIV : { out << arg1 << " = " << arg2 << " / " << arg3; break; }
+  case instruction::_AND : { out << arg1 << " = " << arg2 << " and " << arg3; break; }
+  case instruction::_OR : { out << arg1 << " = " << arg2 << " or " << arg3; break; }
+  case instruction::_EQ : { out << arg1 << " = " << arg2 << " == " << arg3; break; }
+  case instruction::_LT : { out << arg1 << " = " << arg2 << " < " << arg3; break; }
+  case instruction::_LE : { out << arg1 << " = " << arg2 << " <= " << arg3; break; }
+  case instruction::_NOT : { out << arg1 << " = not " << arg2; break; }
+  case instruction::_NEG : { out << arg1 << " = - " << arg2; break; }
+  case instruction::_FADD : { out << arg1 << " = " << arg2 << " +. " << arg3; break; }
+  case instruction::_FSUB : { out << arg1 << " = " << arg2 << " -. " << arg3; break; }
+  case instruction::_FMUL : { out << arg1 << " = " << arg2 << " *. " << arg3; break; }
+  case instruction::_FDIV : { out << arg1 << " = " << arg2 << " /. " << arg3; break; }
+  case instruction::_FEQ : { out << arg1 << " = " << arg2 << " ==. " << arg3; break; }
+  case instruction::_FLT : { out << arg1 << " = " << arg2 << " <. " << arg3; break; }
+  case instruction::_FLE : { out << arg1 << " = " << arg2 << " <=. " << arg3; break; }
+  case instruction::_FNEG : { out << arg1 << " = -. " << arg2; break; }
+  case instruction::_FLOAT : { out << arg1 << " = float " << arg2; break; }
+  case instruction::_NOOP : { out << "noop"; break; }
+  default : { out << "????"; break; }
   }
-
-  return ind + s;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -171,11 +195,23 @@ instructionList instructionList::operator||(const instructionList &lst) const {
   return newlist;
 }
 
+// set the source position of the instructions that have none yet
+void instructionList::set_position(unsigned int line, unsigned int column) {
+  for (auto &inst : *this) {
+    if (inst.line != 0) continue;
+    inst.line = line;
+    inst.column = column;
+  }
+}
+
 // print instructionList (for debugging)
 string instructionList::dump() const {
-  string s;  
-  for (auto i : *this ) s += i.dump() + "\n";
-  return s;
+  ostringstream s;
+  dump(s);
+  return s.str();
+}
+void instructionList::dump(std::ostream &out) const {
+  for (auto &i : *this ) { i.dump(out); out << "\n"; }
 }
 
 
@@ -210,7 +246,7 @@ string subroutine::get_name() const { return name; };
 /// add new variable
 void subroutine::add_var(const std::string &name, size_t sz) { vars.push_back(var(name,sz)); }
 /// add new parameter
-void subroutine::add_param(const std::string &name) { params.push_back(var(name,0)); }
+void subroutine::add_param(const std::string &name, size_t sz) { params.push_back(var(name,sz)); }
 /// add new instruction
 void subroutine::add_instruction(const instruction &inst) {
   if (inst.oper == instruction::_LABEL) labels.insert(make_pair(inst.arg1,instructions.size()));
@@ -224,8 +260,81 @@ void subroutine::add_instructions(const instructionList &lins) {
 /// set instruction list (overwritting current instructions)
 void subroutine::set_instructions(const instructionList &lins) {
   instructions.clear();
+  labels.clear();
   this->add_instructions(lins);
 }
+/// replace the instructions that tvm does not know by equivalent code
+void subroutine::expand_for_tvm() {
+  // new temporals are numbered after the ones in use
+  int lastTemp = 0;
+  for (auto &inst : instructions)
+    for (const string *a : {&inst.arg1, &inst.arg2, &inst.arg3})
+      if (a->size() > 1 and (*a)[0] == '%')
+        lastTemp = max(lastTemp, atoi(a->c_str() + 1));
+  auto newTemp = [&lastTemp] () { return "%" + to_string(++lastTemp); };
+
+  instructionList lins;
+  bool changed = false;
+  for (auto &inst : instructions) {
+    if (inst.oper == instruction::_COPY) {
+      // a1[i] = a2[i] for i in 0 .. a3-1
+      string i = newTemp(), n = newTemp(), one = newTemp(), cond = newTemp(), v = newTemp();
+      string loop = "copy" + i.substr(1), end = "endcopy" + i.substr(1);
+      unsigned int size = atoi(inst.arg3.c_str());
+      // tvm indexes a param itself: the array it refers to is indexed
+      // through a temporal holding its address (as asl does)
+      instructionList code;
+      string dst = inst.arg1, src = inst.arg2;
+      for (string *a : {&dst, &src}) {
+        for (auto &p : params) {
+          if (p.name != *a) continue;
+          *a = newTemp();
+          code = code || instruction::LOAD(*a, p.name);
+          break;
+        }
+      }
+      code = code ||
+        instruction::ILOAD(i, "0") || instruction::ILOAD(n, inst.arg3) ||
+        instruction::ILOAD(one, "1") || instruction::LABEL(loop) ||
+        instruction::LT(cond, i, n) || instruction::FJUMP(cond, end) ||
+        instruction::LOADX(v, src, i, size) || instruction::XLOAD(dst, i, v, size) ||
+        instruction::ADD(i, i, one) || instruction::UJUMP(loop) || instruction::LABEL(end);
+      code.set_position(inst.line, inst.column);
+      lins.insert(lins.end(), code.begin(), code.end());
+      changed = true;
+      continue;
+    }
+    if (inst.oper != instruction::_WRITES) {
+      lins.push_back(inst);
+      continue;
+    }
+    // the literal keeps its quotes and escape sequences
+    const string &s = inst.arg2, &temp = inst.arg1;
+    instructionList code;
+    size_t i = 1;
+    while (i + 1 < s.size()) {
+      if (s[i] == '\\' and i + 2 < s.size() and s[i+1] == 'n') {
+        code = code || instruction::WRITELN();
+        i += 2;
+      }
+      else if (s[i] == '\\' and i + 2 < s.size() and
+               (s[i+1] == 't' or s[i+1] == '"' or s[i+1] == '\\')) {
+        code = code || instruction::CHLOAD(temp, s.substr(i,2)) || instruction::WRITEC(temp);
+        i += 2;
+      }
+      else {
+        code = code || instruction::CHLOAD(temp, s.substr(i,1)) || instruction::WRITEC(temp);
+        i += 1;
+      }
+    }
+    code.set_position(inst.line, inst.column);
+    lins.insert(lins.end(), code.begin(), code.end());
+    changed = true;
+  }
+  if (changed) set_instructions(lins);
+}
+/// get the current instruction list
+const instructionList & subroutine::get_instructions() const { return instructions; }
 /// get instruction at given program counter
 instruction subroutine::get_instruction_at(size_t pc) const {
   if (pc>=instructions.size()) return instruction(instruction::_INVALID);
@@ -235,24 +344,28 @@ instruction subroutine::get_instruction_at(size_t pc) const {
 size_t subroutine::get_label_pc(std::string &lab) const { return labels.find(lab)->second; }
 /// print (for debugging)
 string subroutine::dump() const {
-  string s;
-  s = "function " + name + "\n";
+  ostringstream s;
+  dump(s);
+  return s.str();
+}
+void subroutine::dump(std::ostream &out) const {
+  out << "function " << name << "\n";
   if (not params.empty()) {
-    s += "  params\n" ;
-    for (auto p : params) s += "    " + p.dump() + "\n";
-    s += "  endparams\n\n";
+    out << "  params\n" ;
+    // (a param takes one cell, whatever array it refers to)
+    for (auto &p : params) out << "    " << p.name << "\n";
+    out << "  endparams\n\n";
   }
   if (not vars.empty()) {
-    s += "  vars\n";
-    for (auto v : vars) s += "    " + v.dump() + "\n";
-    s += "  endvars\n\n";
+    out << "  vars\n";
+    for (auto &v : vars) out << "    " << v.dump() << "\n";
+    out << "  endvars\n\n";
   }
 
-  string ind = "  ";
+  const char *ind = "  ";
   if (labels.empty()) ind="";
-  for (auto i : instructions) s += ind + i.dump() + "\n";  
-  s += "endfunction\n\n";
-  return s;
+  for (auto &i : instructions) { out << ind; i.dump(out); out << "\n"; }
+  out << "endfunction\n\n";
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -275,19 +388,30 @@ void code::add_subroutine(const subroutine &s) {
   subs.push_back(s);
   names.insert(make_pair(s.get_name(), subs.size()-1));
 }
+/// remove the last subroutine (e.g. once it has been written)
+void code::remove_last_subroutine() {
+  names.erase(subs.back().get_name());
+  subs.pop_back();
+}
+/// get all subroutines
+vector<subroutine> & code::get_subroutines() { return subs; }
+const vector<subroutine> & code::get_subroutines() const { return subs; }
 /// print (for debugging)
 string code::dump() const {
-  string c;
-  for (auto s : subs) c += s.dump();
-  return c;
+  ostringstream c;
+  dump(c);
+  return c.str();
+}
+void code::dump(std::ostream &out) const {
+  for (auto &s : subs) s.dump(out);
 }
 
 
 ////////////////////////////////////////////////////////////////////
 /// Static methods to manage counters
-int counters::countIF = 0;
-int counters::countWHILE = 0;
-int counters::countTEMP = 0;
+thread_local int counters::countIF = 0;
+thread_local int counters::countWHILE = 0;
+thread_local int counters::countTEMP = 0;
 
 string counters::newLabelIF() { return std::to_string(++countIF); }
 string counters::newLabelWHILE() { return std::to_string(++countWHILE); }
@@ -31,6 +31,10 @@
 #include <map>
 #include <list>
 #include <vector>
+#include <string>
+#include <iostream>
+
+#include "Arena.h"
 
 /// predeclaration
 class instructionList;
@@ -46,12 +50,19 @@ class instruction {
                 _ADD, _SUB, _MUL, _DIV, _EQ, _LT, _LE, _NEG, _NOT, _AND, _OR, _FLOAT,
                 _FADD, _FSUB, _FMUL, _FDIV, _FEQ, _FLT, _FLE, _FNEG,
                 _LOAD, _ILOAD, _CHLOAD, _FLOAD, _XLOAD, _LOADX, _ALOAD, _LOADC, _CLOAD,
-                _READI, _READF, _READC, _WRITEI, _WRITEF, _WRITEC, _WRITELN, _NOOP, _INVALID} Operation;
+                _READI, _READF, _READC, _WRITEI, _WRITEF, _WRITEC, _WRITELN, _WRITES, _COPY, _NOOP, _INVALID} Operation;
   
   /// instruction code
   Operation oper;
   /// arguments
   std::string arg1, arg2, arg3;
+  /// position in the source that produced it (line 0 if unknown)
+  unsigned int line, column;
+  /// xload and loadx: number of cells of the indexed array (0 if
+  /// unknown), and whether the index has been proved to be in range
+  /// (see Optimizer::rangeAnalysis) so the VM does not check it
+  unsigned int bound;
+  bool inRange;
   
   /// constructor
   instruction(Operation op,
@@ -127,10 +138,12 @@ class instruction {
   static instruction CHLOAD(const std::string &a1, const std::string &a2);
   // create new instruction "a1 = a2" (where a2 is a float constant)
   static instruction FLOAD(const std::string &a1, const std::string &a2);
-  // create new instruction "a1[a2] = a3" 
-  static instruction XLOAD(const std::string &a1, const std::string &a2, const std::string &a3);
-  // create new instruction "a1 = a2[a3]" 
-  static instruction LOADX(const std::string &a1, const std::string &a2, const std::string &a3);
+  // create new instruction "a1[a2] = a3" (where a1 has 'bound' cells, 0 if unknown)
+  static instruction XLOAD(const std::string &a1, const std::string &a2, const std::string &a3,
+                           unsigned int bound=0);
+  // create new instruction "a1 = a2[a3]" (where a2 has 'bound' cells, 0 if unknown)
+  static instruction LOADX(const std::string &a1, const std::string &a2, const std::string &a3,
+                           unsigned int bound=0);
   // create new instruction "a1 = &a2" 
   static instruction ALOAD(const std::string &a1, const std::string &a2);
   // create new instruction "a1 = *a2" 
@@ -151,17 +164,25 @@ class instruction {
   static instruction WRITEC(const std::string &a1);
   // create new instruction "writeln" 
   static instruction WRITELN();
+  // create new instruction "writes a2" (where a2 is a string literal, and
+  // a1 the temporal used when it is expanded, see expand_for_tvm)
+  static instruction WRITES(const std::string &a1, const std::string &a2);
+  // create new instruction "copy a1 = a2 (a3)": copies the a3 elements of
+  // array a2 to array a1 (where a3 is an integer constant)
+  static instruction COPY(const std::string &a1, const std::string &a2, const std::string &a3);
   // create new instruction "noop" (not really needed) 
   static instruction NOOP();
   
   // print instruction
   std::string dump() const;   
+  void dump(std::ostream &out) const;
 };
 
 ////////////////////////////////////////////////////////////////////
-/// Class instructionList stores a list of instructions
+/// Class instructionList stores a list of instructions.
+/// Its memory comes from the current Arena, if there is one.
 
-class instructionList : public std::vector<instruction> {
+class instructionList : public std::vector<instruction, ArenaAllocator<instruction> > {
  public:
    // constructor
    instructionList();
@@ -173,8 +194,12 @@ class instructionList : public std::vector<instruction> {
    // concatenation of lists (or list+instruction, via automatic coertion)
    instructionList operator||(const instructionList &lst) const;
 
+   // set the source position of the instructions that have none yet
+   void set_position(unsigned int line, unsigned int column);
+
    // print instructionList
    std::string dump() const;   
+   void dump(std::ostream &out) const;
 };
 
 
@@ -221,15 +246,23 @@ class subroutine {
   std::string get_name() const;
   /// add a local var to subroutine
   void add_var(const std::string &name, size_t sz);
-  /// add a parameter (size is always 1)
-  void add_param(const std::string &name);
+  /// add a parameter (it takes one cell: an array is passed by
+  /// reference, and then 'sz' is the number of cells of the array)
+  void add_param(const std::string &name, size_t sz = 0);
   /// add an instruction
   void add_instruction(const instruction &inst);
   /// add instruction list to current instructions
   void add_instructions(const instructionList &lins);
   /// set instruction list (overwritting current instructions)
   void set_instructions(const instructionList &lins);
+  /// get the current instruction list
+  const instructionList & get_instructions() const;
   
+  /// replace the instructions that tvm does not know by equivalent
+  /// code: each 'writes' by the 'writec' and 'writeln' of its
+  /// characters, and each 'copy' by a loop copying the elements
+  void expand_for_tvm();
+
   /// get instruction at given program counter in subroutine
   instruction get_instruction_at(size_t pc) const;
   /// get program counter in subroutine for given label
@@ -237,6 +270,7 @@ class subroutine {
 
   // print subroutine (params, vars, and instructions)
   std::string dump() const;
+  void dump(std::ostream &out) const;
 };
 
 ////////////////////////////////////////////////////////////////////
@@ -260,20 +294,28 @@ class code {
   const subroutine& get_subroutine(const std::string &name) const;
   /// add new subroutine
   void add_subroutine(const subroutine &s);
+  /// remove the most recently added subroutine (e.g. once it has been written)
+  void remove_last_subroutine();
+  /// get all the subroutines (e.g. to transform them)
+  std::vector<subroutine> & get_subroutines();
+  const std::vector<subroutine> & get_subroutines() const;
 
   // print code (all info for all subroutines)
   std::string dump() const;
+  void dump(std::ostream &out) const;
 };
 
 
 ////////////////////////////////////////////////////////////////////
 /// Class counters manages temporal and labels counters
+/// (one set of counters per thread, so several functions can be
+/// generated at the same time)
 
 class counters {
  private:
-   static int countIF;
-   static int countWHILE;
-   static int countTEMP;
+   static thread_local int countIF;
+   static thread_local int countWHILE;
+   static thread_local int countTEMP;
   
  public:
    // return id for new label or temp (id is a number, but returned as string
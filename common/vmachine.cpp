@@ -0,0 +1,547 @@
+/////////////////////////////////////////////////////////////////
+//
+//    TVM - t-Code Virtual Machine
+//
+//    Copyright (C) 2017  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: Lluis Padro (padro@cs.upc.es)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.320 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+////////////////////////////////////////////////////////////////
+
+#include "vmachine.h"
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+
+#include <cstring>    // std::memcpy, std::memmove, std::strlen
+
+using namespace std;
+
+
+namespace {
+
+  inline float as_float(int32_t v) { float f; memcpy(&f, &v, sizeof(f)); return f; }
+  inline int32_t as_int(float f) { int32_t v; memcpy(&v, &f, sizeof(v)); return v; }
+
+  /// message of the index i of an array of 'bound' cells
+  string index_error(int32_t i, uint32_t bound) {
+    // otherwise the index was right, but not the base of the array
+    bool index = (bound == tbc::UnknownBound ? i < 0 :
+                  not (bound & tbc::InRange) and uint32_t(i) >= bound);
+    if (not index) return "invalid memory access";
+    string size = (bound == tbc::UnknownBound ? "?" : to_string(bound));
+    return "array index " + to_string(i) + " out of range (size " + size + ")";
+  }
+
+}
+
+
+/// constructor
+vmachine::vmachine(const BinaryCode &prog) :
+  program(prog), maxCells(0), profiler(nullptr), snapshotSub(NoSubroutine) {}
+/// destructor
+vmachine::~vmachine() {}
+
+/// message of the last runtime error
+const string & vmachine::get_error() const { return status.message; }
+
+/// how the last run ended
+const vmachine::Status & vmachine::get_status() const { return status; }
+
+/// limit the next runs
+void vmachine::set_limits(const Limits &l) { limits = l; }
+
+/// profile the next runs
+void vmachine::set_profiler(Profiler *p) { profiler = p; }
+
+void vmachine::reserve(size_t n) {
+  // the memory limit has been checked: do not double past it
+  if (n > memory.size()) memory.resize(max(n, min(2*memory.size(), maxCells)));
+}
+
+string vmachine::where(uint32_t pc) const {
+  // find the subroutine containing pc
+  const tbc::Header &h = program.header();
+  string w;
+  for (uint32_t k = 0; k < h.nSubroutines; ++k) {
+    const tbc::Subroutine &s = program.get_subroutine(k);
+    if (pc >= s.firstInstr and pc < s.firstInstr + s.nInstrs)
+      w = string(program.get_string(s.name)) + ", pc " + to_string(pc - s.firstInstr);
+  }
+  if (program.get_position(pc).line != 0)
+    w += " (line " + program.position_string(pc) + ")";
+  return w;
+}
+
+bool vmachine::stop(Outcome why, const string &msg, uint32_t pc, uint32_t sub,
+                    size_t fp, size_t depth, uint64_t executed) {
+  status.outcome = why;
+  status.instructions = executed;
+  status.depth = depth;
+  switch (why) {
+  case InstructionLimit:
+    status.message = "instruction limit of " + to_string(limits.instructions) + " exceeded";
+    break;
+  case DepthLimit:
+    status.message = "call depth limit of " + to_string(limits.depth) + " exceeded";
+    break;
+  case MemoryLimit:
+    status.message = "memory limit of " + to_string(limits.memory) + " bytes exceeded";
+    break;
+  default:
+    status.message = msg;
+  }
+  status.message = "Runtime error in " + where(pc) + ": " + status.message;
+
+  // the callers, through the links in the stack. The pc of each one
+  // is its call, just before the return pc
+  status.stack.clear();
+  status.stack.push_back(where(pc));
+  for (size_t d = depth; d > 0 and status.stack.size() < StackFrames; --d) {
+    size_t link = fp + program.get_subroutine(sub).frameSize;
+    if (link + LinkCells > memory.size()) break;
+    sub = uint32_t(memory[link + LinkSub]);
+    pc = uint32_t(memory[link + LinkPc]) - 1;
+    fp = uint32_t(memory[link + LinkFp]);
+    // (a corrupted stack, or a crafted snapshot, can have anything)
+    if (sub >= program.header().nSubroutines or pc >= program.header().nInstrs) break;
+    status.stack.push_back(where(pc));
+  }
+  return false;
+}
+
+vmachine::Value::Value(int32_t i) : cell(i) {}
+vmachine::Value::Value(float f) : cell(::as_int(f)) {}
+vmachine::Value::Value(double f) : cell(::as_int(float(f))) {}
+vmachine::Value::Value(bool b) : cell(b) {}
+vmachine::Value::Value(char c) : cell((unsigned char)c) {}
+int32_t vmachine::Value::as_int() const { return cell; }
+float vmachine::Value::as_float() const { return ::as_float(cell); }
+bool vmachine::Value::as_bool() const { return cell != 0; }
+char vmachine::Value::as_char() const { return char(cell); }
+
+/// run the program from 'main'
+bool vmachine::execute(istream &in, ostream &out) {
+  return start(program.header().mainSubroutine, vector<Value>(), nullptr, in, out);
+}
+
+/// take a snapshot at the first call of a subroutine
+void vmachine::set_snapshot(const string &fileName, uint32_t sub) {
+  snapshotFile = fileName;
+  snapshotSub = (fileName.empty() ? NoSubroutine : sub);
+}
+
+/// go on with the run of a snapshot
+bool vmachine::resume(const Snapshot &snapshot, istream &in, ostream &out) {
+  status = Status();
+  const tvs::Header &h = snapshot.header();
+  status.outcome = RuntimeError;
+  if (h.program != program.checksum())
+    status.message = "Runtime error: the snapshot is of another program";
+  else if (h.sub >= program.header().nSubroutines or
+           h.pc < program.get_subroutine(h.sub).firstInstr or
+           h.pc >= program.get_subroutine(h.sub).firstInstr + program.get_subroutine(h.sub).nInstrs or
+           program.instructions()[h.pc].oper != instruction::_CALL or
+           uint64_t(h.fp) + program.get_subroutine(h.sub).frameSize + LinkCells > h.sp)
+    status.message = "Runtime error: corrupted snapshot";
+  else
+    return start(h.sub, vector<Value>(), &snapshot, in, out);
+  return false;
+}
+
+bool vmachine::save_snapshot(uint32_t sub, uint32_t pc, size_t fp, size_t sp, size_t depth,
+                             uint64_t executed, const InputBuffer &input) {
+  tvs::Header h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, tvs::Magic, sizeof(h.magic));
+  h.version = tvs::Version;
+  h.program = program.checksum();
+  h.sub = sub;
+  h.pc = pc;
+  h.fp = fp;
+  h.sp = sp;
+  h.depth = depth;
+  h.instructions = executed;
+  h.input = input.position();
+  h.inputFailed = input.has_failed();
+  h.cellsOffset = sizeof(h);
+  return Snapshot::save(snapshotFile, h, memory.data());
+}
+
+/// call a subroutine
+bool vmachine::call(const string &name, const vector<Value> &args, Value &result,
+                    istream &in, ostream &out) {
+  status = Status();
+  int k = program.find_subroutine(name);
+  if (k < 0) {
+    status.outcome = RuntimeError;
+    status.message = "Runtime error: there is no subroutine " + name;
+    return false;
+  }
+  // a function has _result before its params
+  const tbc::Subroutine &s = program.get_subroutine(k);
+  bool function = (s.nParams > 0 and
+                   string(program.get_string(program.get_var(s.firstVar).name)) == "_result");
+  if (s.nParams != args.size() + function) {
+    status.outcome = RuntimeError;
+    status.message = "Runtime error: " + name + " has " +
+                     to_string(s.nParams - function) + " parameters, not " + to_string(args.size());
+    return false;
+  }
+  // an array param would be taken as an address in the stack
+  for (uint32_t p = function; p < s.nParams; ++p) {
+    const tbc::Var &v = program.get_var(s.firstVar + p);
+    if (v.size != 0) {
+      status.outcome = RuntimeError;
+      status.message = "Runtime error: parameter " + string(program.get_string(v.name)) +
+                       " of " + name + " is an array, it can not be passed";
+      return false;
+    }
+  }
+  vector<Value> params;
+  if (function) params.push_back(Value());
+  params.insert(params.end(), args.begin(), args.end());
+  if (not start(k, params, nullptr, in, out)) return false;
+  // the frame of the subroutine is at the bottom of the stack
+  result = Value(function ? memory[0] : 0);
+  return true;
+}
+
+bool vmachine::start(uint32_t sub, const vector<Value> &params, const Snapshot *from,
+                     istream &in, ostream &out) {
+  if (not profiler) return run<false>(sub, params, from, in, out);
+  bool ok = run<true>(sub, params, from, in, out);
+  profiler->finish();
+  return ok;
+}
+
+template <bool Profile>
+bool vmachine::run(uint32_t sub, const vector<Value> &params, const Snapshot *from,
+                   istream &in, ostream &out) {
+  const tbc::Instr *code = program.instructions();
+  const uint32_t nSubroutines = program.header().nSubroutines;
+  status = Status();
+  const uint64_t maxInstructions = (limits.instructions ? limits.instructions : UINT64_MAX);
+  const size_t maxDepth = (limits.depth ? limits.depth : SIZE_MAX);
+  maxCells = (limits.memory ? limits.memory / sizeof(int32_t) : SIZE_MAX);
+  // the cells above sp are never read, so only the first frame has
+  // to be cleared (a host calling many times reuses the memory)
+  if (memory.size() > maxCells) memory.clear();
+  if (memory.empty()) memory.resize(min(size_t(1024), maxCells));
+
+  // the link of the first subroutine is not used. A snapshot brings
+  // its own stack, and goes on from the call where it was taken
+  const tbc::Subroutine *s = &program.get_subroutine(sub);
+  size_t depth = (from ? from->header().depth : 0);
+  size_t fp = (from ? from->header().fp : 0);
+  size_t sp = (from ? from->header().sp : s->frameSize + LinkCells);
+  uint32_t pc = (from ? from->header().pc : s->firstInstr);
+  if (sp > maxCells) return stop(MemoryLimit, "", pc, sub, fp, 0, 0);
+  reserve(sp);
+  int32_t *m = memory.data();
+  if (from) memcpy(m, from->cells(), sp * sizeof(int32_t));
+  else fill(m, m + sp, 0);
+  int32_t *frame = m + fp;
+  for (size_t k = 0; k < params.size(); ++k) frame[k] = params[k].cell;
+  // instructions executed before 'mark', where the straight run of
+  // code being executed has started
+  uint64_t count = (from ? from->header().instructions : 0);
+  uint32_t mark = pc;
+  OutputBuffer output(out);
+  InputBuffer input(in);
+  if (from) input.restore(from->header().input, from->header().inputFailed);
+  // it is taken once, and not again in the run resumed from it
+  uint32_t snapshotAt = (from ? uint32_t(NoSubroutine) : snapshotSub);
+
+  // profiling counters
+  uint64_t *executed = nullptr, *taken = nullptr;
+  uint64_t steps = 0;
+  if (Profile) {
+    executed = profiler->executed_counts();
+    taken = profiler->taken_counts();
+    // the calls of a snapshot are entered from the outermost one
+    vector<uint32_t> calls(1, sub);
+    for (size_t d = depth, f = fp; d > 0; --d) {
+      size_t link = f + program.get_subroutine(calls.back()).frameSize;
+      if (link + LinkCells > sp or uint32_t(m[link + LinkSub]) >= nSubroutines) break;
+      calls.push_back(m[link + LinkSub]);
+      f = uint32_t(m[link + LinkFp]);
+    }
+    for (auto k = calls.rbegin(); k != calls.rend(); ++k) profiler->enter(*k, 0);
+  }
+
+  // operands: value, written cell, and base address of an array
+#define VAL(a)  (I.kind[a] == tbc::IMM ? I.value[a] : frame[I.value[a]])
+#define FVAL(a) as_float(VAL(a))
+#define DST     frame[I.value[0]]
+#define BASE(a) (I.kind[a] == tbc::ADDR ? int64_t(fp) + I.value[a] : int64_t(frame[I.value[a]]))
+#define EXECUTED (count + (pc + 1 - mark))
+#define FAIL(why, msg) return stop(why, msg, pc, sub, fp, depth, EXECUTED)
+  // the control goes to 'target', which starts another straight run
+#define TRANSFER(target) count = EXECUTED; mark = (target)
+  // the limits are only checked at backward jumps, calls and returns
+#define CHECK_BUDGET \
+  if (__builtin_expect(EXECUTED > maxInstructions, 0)) FAIL(InstructionLimit, "")
+#define CHECK_ADDR(x) if ((x) < 0 or size_t(x) >= sp) FAIL(RuntimeError, "invalid memory access")
+  // index i of an array with base b (operand k), at address a. A proved
+  // index is not checked, but a base read from memory always is: all the
+  // array must be in the stack
+  // (the failure is marked unlikely, or gcc lays out the hot loop worse)
+#define CHECK_INDEX(i, k, b, a) \
+  if (__builtin_expect(I.bound != tbc::Unchecked and \
+                       (I.bound == tbc::UnknownBound ? \
+                          (i) < 0 or (a) < 0 or size_t(a) >= sp : \
+                          (not (I.bound & tbc::InRange) and uint32_t(i) >= I.bound) or \
+                          (I.kind[k] != tbc::ADDR and \
+                           ((b) < 0 or size_t(b) + (I.bound & ~tbc::InRange) > sp))), 0)) \
+    FAIL(RuntimeError, index_error(i, I.bound))
+
+  while (true) {
+    const tbc::Instr &I = code[pc];
+    uint32_t next = pc + 1;
+    if (Profile) {
+      ++executed[pc];
+      ++steps;
+    }
+    switch (I.oper) {
+    case instruction::_LABEL:
+    case instruction::_NOOP:
+      break;
+    case instruction::_UJUMP:
+      next = I.value[0];
+      if (next <= pc) CHECK_BUDGET;
+      TRANSFER(next);
+      break;
+    case instruction::_FJUMP:
+      if (not VAL(0)) {
+        next = I.value[1];
+        if (Profile) ++taken[pc];
+        if (next <= pc) CHECK_BUDGET;
+        TRANSFER(next);
+      }
+      break;
+
+    case instruction::_PUSH: {
+      int32_t v = (I.kind[0] == tbc::NONE ? 0 : VAL(0));
+      if (sp == memory.size()) {
+        if (sp + 1 > maxCells) FAIL(MemoryLimit, "");
+        reserve(sp + 1);
+        m = memory.data();
+        frame = m + fp;
+      }
+      m[sp++] = v;
+      break;
+    }
+    case instruction::_POP:
+      if (sp <= fp + s->frameSize + LinkCells) FAIL(RuntimeError, "popparam with no parameter");
+      --sp;
+      if (I.kind[0] != tbc::NONE) DST = m[sp];
+      break;
+    case instruction::_CALL: {
+      if (__builtin_expect(uint32_t(I.value[0]) == snapshotAt, 0)) {
+        snapshotAt = NoSubroutine;
+        if (not save_snapshot(sub, pc, fp, sp, depth, EXECUTED - 1, input))
+          FAIL(RuntimeError, "can not write the snapshot " + snapshotFile);
+      }
+      const tbc::Subroutine *callee = &program.get_subroutine(I.value[0]);
+      if (sp < fp + s->frameSize + LinkCells + callee->nParams)
+        FAIL(RuntimeError, "missing parameters in call to " +
+                           string(program.get_string(callee->name)));
+      CHECK_BUDGET;
+      if (depth >= maxDepth) FAIL(DepthLimit, "");
+      // the params are already in place: the rest of the frame is
+      // cleared and the link goes after it
+      size_t calleeFp = sp - callee->nParams;
+      size_t link = calleeFp + callee->frameSize;
+      if (link + LinkCells > maxCells) FAIL(MemoryLimit, "");
+      if (Profile) profiler->enter(I.value[0], steps);
+      reserve(link + LinkCells);
+      m = memory.data();
+      for (size_t p = sp; p < link; ++p) m[p] = 0;
+      m[link + LinkSub] = sub;
+      m[link + LinkPc] = next;
+      m[link + LinkFp] = int32_t(fp);
+      sp = link + LinkCells;
+      fp = calleeFp;
+      frame = m + fp;
+      ++depth;
+      sub = I.value[0];
+      s = callee;
+      next = s->firstInstr;
+      TRANSFER(next);
+      break;
+    }
+    case instruction::_RETURN: {
+      if (depth > 0) CHECK_BUDGET;
+      if (Profile) profiler->leave(steps);
+      if (depth == 0) {
+        status.instructions = EXECUTED;
+        return true;
+      }
+      // the params are left for the popparams of the caller
+      const int32_t *link = frame + s->frameSize;
+      uint32_t callerSub = link[LinkSub], returnPc = link[LinkPc];
+      size_t callerFp = uint32_t(link[LinkFp]);
+      if (callerSub >= nSubroutines or callerFp >= fp)
+        FAIL(RuntimeError, "corrupted stack");
+      const tbc::Subroutine *caller = &program.get_subroutine(callerSub);
+      if (returnPc < caller->firstInstr or returnPc >= caller->firstInstr + caller->nInstrs or
+          callerFp + caller->frameSize + LinkCells > fp)
+        FAIL(RuntimeError, "corrupted stack");
+      sp = fp + s->nParams;
+      sub = callerSub;
+      s = caller;
+      next = returnPc;
+      TRANSFER(next);
+      fp = callerFp;
+      frame = m + fp;
+      --depth;
+      break;
+    }
+
+    // the integer operations wrap around: they are computed unsigned,
+    // since a signed overflow is undefined in C++
+    case instruction::_ADD: DST = int32_t(uint32_t(VAL(1)) + uint32_t(VAL(2))); break;
+    case instruction::_SUB: DST = int32_t(uint32_t(VAL(1)) - uint32_t(VAL(2))); break;
+    case instruction::_MUL: DST = int32_t(uint32_t(VAL(1)) * uint32_t(VAL(2))); break;
+    case instruction::_DIV: {
+      int32_t d = VAL(2);
+      if (d == 0) FAIL(RuntimeError, "division by zero");
+      // INT32_MIN / -1 traps on x86: it wraps to INT32_MIN
+      if (d == -1) DST = int32_t(0u - uint32_t(VAL(1)));
+      else DST = VAL(1) / d;
+      break;
+    }
+    case instruction::_EQ:  DST = (VAL(1) == VAL(2)); break;
+    case instruction::_LT:  DST = (VAL(1) <  VAL(2)); break;
+    case instruction::_LE:  DST = (VAL(1) <= VAL(2)); break;
+    case instruction::_AND: DST = (VAL(1) and VAL(2)); break;
+    case instruction::_OR:  DST = (VAL(1) or VAL(2)); break;
+    case instruction::_NOT: DST = not VAL(1); break;
+    case instruction::_NEG: DST = int32_t(0u - uint32_t(VAL(1))); break;
+
+    case instruction::_FLOAT: DST = as_int(float(VAL(1))); break;
+    case instruction::_FADD: DST = as_int(FVAL(1) + FVAL(2)); break;
+    case instruction::_FSUB: DST = as_int(FVAL(1) - FVAL(2)); break;
+    case instruction::_FMUL: DST = as_int(FVAL(1) * FVAL(2)); break;
+    case instruction::_FDIV: DST = as_int(FVAL(1) / FVAL(2)); break;
+    case instruction::_FEQ:  DST = (FVAL(1) == FVAL(2)); break;
+    case instruction::_FLT:  DST = (FVAL(1) <  FVAL(2)); break;
+    case instruction::_FLE:  DST = (FVAL(1) <= FVAL(2)); break;
+    case instruction::_FNEG: DST = as_int(- FVAL(1)); break;
+
+    case instruction::_LOAD:
+    case instruction::_ILOAD:
+    case instruction::_CHLOAD:
+    case instruction::_FLOAD:
+      DST = VAL(1);
+      break;
+    case instruction::_ALOAD:
+      DST = int32_t(fp + I.value[1]);
+      break;
+    case instruction::_XLOAD: {
+      int32_t i = VAL(1);
+      int64_t b = BASE(0), a = b + i;
+      CHECK_INDEX(i, 0, b, a);
+      m[a] = VAL(2);
+      break;
+    }
+    case instruction::_LOADX: {
+      int32_t i = VAL(2);
+      int64_t b = BASE(1), a = b + i;
+      CHECK_INDEX(i, 1, b, a);
+      DST = m[a];
+      break;
+    }
+    case instruction::_COPY: {
+      int64_t dst = BASE(0), src = BASE(1), n = VAL(2);
+      if (n <= 0) break;
+      CHECK_ADDR(dst);
+      CHECK_ADDR(dst + n - 1);
+      CHECK_ADDR(src);
+      CHECK_ADDR(src + n - 1);
+      // memmove, since a = a is valid
+      memmove(&m[dst], &m[src], n * sizeof(int32_t));
+      break;
+    }
+    case instruction::_LOADC: {
+      int64_t a = VAL(1);
+      CHECK_ADDR(a);
+      DST = m[a];
+      break;
+    }
+    case instruction::_CLOAD: {
+      int64_t a = VAL(0);
+      CHECK_ADDR(a);
+      m[a] = VAL(1);
+      break;
+    }
+
+    // what has been written is shown before waiting for the input
+    case instruction::_READI: {
+      if (not input.has_input()) output.flush();
+      int32_t v;
+      input.read_int(v);
+      DST = v;
+      break;
+    }
+    case instruction::_READF: {
+      if (not input.has_input()) output.flush();
+      float f;
+      input.read_float(f);
+      DST = as_int(f);
+      break;
+    }
+    case instruction::_READC: {
+      if (not input.has_input()) output.flush();
+      char c;
+      input.read_char(c);
+      DST = (unsigned char)c;
+      break;
+    }
+    case instruction::_WRITEI:  output.put_int(VAL(0)); break;
+    case instruction::_WRITEF:  output.put_float(FVAL(0)); break;
+    case instruction::_WRITEC:  output.put_char(char(VAL(0))); break;
+    case instruction::_WRITELN: output.put_char('\n'); break;
+    case instruction::_WRITES: {
+      const char *text = program.get_string(I.value[1]);
+      output.put_string(text, strlen(text));
+      break;
+    }
+
+    default:
+      FAIL(RuntimeError, "invalid instruction");
+    }
+    pc = next;
+  }
+#undef VAL
+#undef FVAL
+#undef DST
+#undef BASE
+#undef EXECUTED
+#undef FAIL
+#undef TRANSFER
+#undef CHECK_BUDGET
+#undef CHECK_ADDR
+#undef CHECK_INDEX
+}
@@ -0,0 +1,197 @@
+/////////////////////////////////////////////////////////////////
+//
+//    TVM - t-Code Virtual Machine
+//
+//    Copyright (C) 2017  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: Lluis Padro (padro@cs.upc.es)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.320 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include <cstddef>    // std::size_t
+#include <cstdint>    // std::int32_t
+
+#include "BinaryCode.h"
+#include "Profiler.h"
+#include "BufferedIO.h"
+#include "Snapshot.h"
+
+// using namespace std;
+
+
+////////////////////////////////////////////////////////////////////
+/// Class vmachine executes a program in binary t-code form. All the
+/// names are already resolved in the BinaryCode, so the instructions
+/// are run directly from the (possibly mapped) image.
+///
+/// The memory is one stack of 32-bit cells (floats are kept as their
+/// bits), and each activation of a subroutine is one block of it:
+///
+///    params | vars (arrays inline) | temporals | link | pushed values
+///
+/// The params are the values pushed by the caller, the slots of the
+/// rest come precomputed in the BinaryCode, and the link keeps the
+/// subroutine, return pc and frame of the caller. So a call just
+/// moves the frame pointer, and a variable is frame + offset.
+/// Addresses are positions in this stack. The index of an
+/// array is checked against its size, unless asl has proved it is
+/// always in range.
+///
+/// The output is buffered and written when the program ends or has
+/// to wait for input, so a prompt is seen before the program reads.
+///
+/// Besides running 'main', a host program can call any subroutine
+/// with values of its own, and get its _result. Arrays can not be
+/// passed (the call fails), since asl passes them by reference. A
+/// vmachine does not change its BinaryCode, so many of them (e.g.
+/// one per thread) can run the same program at the same time.
+///
+/// A run can leave a Snapshot when some subroutine is called for
+/// the first time (e.g. the one doing the real work, after a long
+/// initialization), and later runs can resume from it. What was read
+/// before is skipped in the input of the resumed run, and only what
+/// is written after the call is written again.
+///
+/// With a Profiler, the machine counts what it executes (the loop
+/// is compiled twice, so there is no cost when it is not used).
+///
+/// A run can be limited in instructions, depth of calls and bytes
+/// of stack, to run programs that are not trusted. The instructions
+/// are counted when the control is transferred, and the limits are
+/// only checked at backward jumps, calls and returns, so a program
+/// may go a few instructions (never a loop) past its budget. When a
+/// run stops, get_status tells why, where, and the calls it was in.
+
+class vmachine {
+ public:
+  /// how a run ended
+  enum Outcome { Finished, RuntimeError, InstructionLimit, DepthLimit, MemoryLimit };
+
+  /// limits of a run (0 is no limit)
+  struct Limits {
+    std::uint64_t instructions = 0;   ///< instructions executed
+    std::size_t depth = 0;            ///< nested calls below 'main'
+    std::size_t memory = 0;           ///< bytes of the stack
+  };
+
+  /// how and where the last run ended
+  struct Status {
+    Outcome outcome = Finished;
+    std::string message;              ///< empty if finished
+    std::uint64_t instructions = 0;   ///< executed in the run
+    std::size_t depth = 0;            ///< of the calls when it stopped
+    /// the innermost calls when it stopped ("fib, pc 12 (line 7)"),
+    /// from the instruction that stopped to its callers
+    std::vector<std::string> stack;
+  };
+
+  /// a value passed to or returned by a subroutine: one cell, which
+  /// the host reads with the type it knows it has
+  struct Value {
+    Value(std::int32_t i = 0);
+    Value(float f);
+    Value(double f);    // kept as a float
+    Value(bool b);
+    Value(char c);
+    std::int32_t as_int() const;
+    float as_float() const;
+    bool as_bool() const;
+    char as_char() const;
+
+    std::int32_t cell;
+  };
+
+  /// constructor and destructor
+  vmachine(const BinaryCode &prog);
+  ~vmachine();
+
+  /// run the program from 'main'. Returns false if a runtime error
+  /// or a limit stops the execution (see get_status)
+  bool execute(std::istream &in, std::ostream &out);
+  /// run the subroutine 'name' with the values of its params (not
+  /// _result) and leave its _result (0 for a procedure) in 'result'.
+  /// Returns false if it does not exist, the number of values is not
+  /// the one of its params, or the execution stops (see get_status)
+  bool call(const std::string &name, const std::vector<Value> &args, Value &result,
+            std::istream &in, std::ostream &out);
+  /// message of the last runtime error
+  const std::string & get_error() const;
+  /// how the last run ended
+  const Status & get_status() const;
+  /// limit the next runs
+  void set_limits(const Limits &l);
+  /// profile the next runs in 'p' (none if null)
+  void set_profiler(Profiler *p);
+  /// in the next runs, write a snapshot to 'fileName' (none if empty)
+  /// when subroutine 'sub' is called for the first time. The run goes
+  /// on after writing it
+  void set_snapshot(const std::string &fileName, std::uint32_t sub);
+  /// go on from a snapshot taken with the same program, until 'main'
+  /// returns. Returns false as execute does, or if the snapshot does
+  /// not fit the program
+  bool resume(const Snapshot &snapshot, std::istream &in, std::ostream &out);
+
+ private:
+  /// cells of the link of an activation, after its temporals
+  enum { LinkSub, LinkPc, LinkFp, LinkCells };
+  /// no subroutine to take a snapshot at
+  enum : std::uint32_t { NoSubroutine = 0xFFFFFFFF };
+
+  /// frames kept in Status::stack
+  static const std::size_t StackFrames = 32;
+
+  const BinaryCode &program;
+  std::vector<std::int32_t> memory;
+  std::size_t maxCells;
+  Limits limits;
+  Status status;
+  Profiler *profiler;
+  std::string snapshotFile;
+  std::uint32_t snapshotSub;
+
+  /// run subroutine 'sub', with the given values in its first cells
+  /// (or go on from a snapshot), with or without profiling
+  bool start(std::uint32_t sub, const std::vector<Value> &params, const Snapshot *from,
+             std::istream &in, std::ostream &out);
+  /// the execution loop
+  template <bool Profile>
+  bool run(std::uint32_t sub, const std::vector<Value> &params, const Snapshot *from,
+           std::istream &in, std::ostream &out);
+  /// write the snapshot of a call about to be executed
+  bool save_snapshot(std::uint32_t sub, std::uint32_t pc, std::size_t fp, std::size_t sp,
+                     std::size_t depth, std::uint64_t executed, const InputBuffer &input);
+
+  /// make room for at least n cells of memory
+  void reserve(std::size_t n);
+  /// "name, pc N (line L)" of an instruction
+  std::string where(std::uint32_t pc) const;
+  /// stop the execution in the instruction pc of subroutine sub,
+  /// with its frame at fp and the given depth, after 'executed'
+  /// instructions. The message of a limit is made here
+  bool stop(Outcome why, const std::string &msg, std::uint32_t pc, std::uint32_t sub,
+            std::size_t fp, std::size_t depth, std::uint64_t executed);
+};
@@ -0,0 +1,66 @@
+#!/bin/bash
+# Times the vm on calls: the recursive fib and Ackermann functions of
+# examples/calls_01 and calls_02, compiled by asl, with the inputs in
+# bench/ (<program>_<args>.in). It prints the best of RUNS runs of
+# each input for every vm given (./vm by default), so that two builds
+# can be compared:
+#     ./bench.sh ./vm /tmp/old/vm
+# Then it times BATCH inputs of fib(15) run by --batch with 1, 2 and 4
+# threads, and by one vm process per input.
+
+cd "$(dirname "$0")"
+RUNS=${RUNS:-5}
+BATCH=${BATCH:-2000}
+ASL=${ASL:-../asl/asl}
+VMS=("$@")
+[ ${#VMS[@]} -eq 0 ] && VMS=(./vm)
+
+dir=$(mktemp -d)
+trap 'rm -rf bench/*.tbc "$dir"' EXIT
+$ASL -O2 -o bench/fib.tbc ../examples/calls_01.asl || exit 1
+$ASL -O2 -o bench/ack.tbc ../examples/calls_02.asl || exit 1
+
+# best wall time of RUNS runs of a command, in ms
+best() {
+    local b=
+    for r in $(seq $RUNS); do
+        local t0=$(date +%s%N)
+        "$@" > /dev/null || return 1
+        local t=$((($(date +%s%N) - t0) / 1000000))
+        [ -z "$b" ] || [ $t -lt $b ] && b=$t
+    done
+    echo $b
+}
+# a run of a vm (1) on a program (2) with an input (3)
+run() {
+    "$1" "$2" < "$3"
+}
+# a vm process (1) per input (the rest) of fib
+each() {
+    local vm=$1
+    shift
+    for input in "$@"; do "$vm" bench/fib.tbc < "$input" || return 1; done
+}
+report() {
+    local name=$1 vm=$2 t
+    shift 2
+    t=$(best "$@") && t="$t ms" || t=failed
+    printf "%-24s %-20s %11s\n" "$name" "$vm" "$t"
+}
+
+for input in bench/*.in; do
+    name=$(basename "$input" .in)
+    for vm in "${VMS[@]}"; do
+        report $name "$vm" run "$vm" bench/${name%%_*}.tbc "$input"
+    done
+done
+
+echo "$BATCH inputs of fib(15), $(nproc) cores:"
+mkdir "$dir/out"
+for i in $(seq $BATCH); do echo 15 > "$dir/$i.in"; done
+for vm in "${VMS[@]}"; do
+    for j in 1 2 4; do
+        report "  --batch -j $j" "$vm" "$vm" --batch="$dir/out" -j $j bench/fib.tbc "$dir"/*.in
+    done
+    RUNS=1 report "  a process per input" "$vm" each "$vm" "$dir"/*.in
+done
@@ -0,0 +1,239 @@
+/////////////////////////////////////////////////////////////////
+//
+//    TVM - t-Code Virtual Machine
+//
+//    Copyright (C) 2017  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: Lluis Padro (padro@cs.upc.es)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.320 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+////////////////////////////////////////////////////////////////
+
+#include "../common/code.h"
+#include "../common/BinaryCode.h"
+#include "../common/vmachine.h"
+#include "../common/Profiler.h"
+#include "../common/Snapshot.h"
+#include "../common/BatchRunner.h"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <map>
+
+#include <cstdlib>    // EXIT_FAILURE, EXIT_SUCCESS
+#include <cstdio>     // std::remove
+
+// using namespace std;
+
+
+// The file of a batch for an input: dir/name.out for .../name.in
+static std::string batchFile(const std::string & dir, const std::string & input,
+                             const std::string & extension) {
+  std::string name = input.substr(input.find_last_of('/') + 1);
+  if (name.size() > 3 and name.compare(name.size() - 3, 3, ".in") == 0)
+    name.resize(name.size() - 3);
+  return dir + "/" + name + extension;
+}
+
+// Run the program on each input with a pool of threads, writing
+// the outputs (and the errors) in 'dir'
+static int runBatch(const BinaryCode & program, const vmachine::Limits & limits,
+                    const std::string & dir, unsigned int threads,
+                    const std::vector<std::string> & inputs) {
+  // the outputs are named after the inputs, without their directory
+  std::vector<std::string> outputs;
+  std::map<std::string, std::string> written;
+  for (auto & in : inputs) {
+    outputs.push_back(batchFile(dir, in, ".out"));
+    auto it = written.insert({outputs.back(), in});
+    if (not it.second) {
+      std::cerr << it.first->second << " and " << in << " would both write "
+                << outputs.back() << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  BatchRunner runner(program, threads);
+  runner.set_limits(limits);
+  std::vector<BatchRunner::Result> results = runner.run(inputs, outputs);
+  std::size_t failed = 0;
+  for (std::size_t k = 0; k < inputs.size(); ++k) {
+    std::string errFile = batchFile(dir, inputs[k], ".err");
+    if (results[k].ok) {
+      std::remove(errFile.c_str());
+      continue;
+    }
+    ++failed;
+    std::ofstream err(errFile);
+    err << results[k].error << std::endl;
+    std::cerr << inputs[k] << ": " << results[k].error << std::endl;
+  }
+  if (failed > 0)
+    std::cerr << failed << " of " << inputs.size() << " inputs failed" << std::endl;
+  return failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+// value of a limit, maybe with a K, M or G suffix. False if malformed
+static bool parseLimit(const std::string & text, unsigned long long & value) {
+  std::size_t end = 0;
+  try { value = std::stoull(text, &end); }
+  catch (...) { return false; }
+  std::string suffix = text.substr(end);
+  if (suffix == "K" or suffix == "k") value <<= 10;
+  else if (suffix == "M" or suffix == "m") value <<= 20;
+  else if (suffix == "G" or suffix == "g") value <<= 30;
+  else if (suffix != "") return false;
+  return text[0] != '-';
+}
+
+// most threads of a batch (-j): more would only waste memory
+const unsigned long long MaxThreads = 1024;
+
+
+int main(int argc, const char* argv[]) {
+  // check the correct use of the program
+  bool dump = false;
+  std::string fileName, profileFile, stacksFile;
+  std::string snapshotFile, snapshotAt, restoreFile;
+  std::string batchDir;
+  unsigned int threads = 0;
+  std::vector<std::string> inputs;
+  vmachine::Limits limits;
+  unsigned long long value;
+  // a wrong option is not forgotten when the program comes after it
+  bool valid = true;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--dump")
+      dump = true;
+    else if (arg.compare(0, 19, "--max-instructions=") == 0 and parseLimit(arg.substr(19), value))
+      limits.instructions = value;
+    else if (arg.compare(0, 12, "--max-depth=") == 0 and parseLimit(arg.substr(12), value))
+      limits.depth = value;
+    else if (arg.compare(0, 13, "--max-memory=") == 0 and parseLimit(arg.substr(13), value))
+      limits.memory = value;
+    else if (arg.compare(0, 11, "--snapshot=") == 0)
+      snapshotFile = arg.substr(11);
+    else if (arg.compare(0, 14, "--snapshot-at=") == 0)
+      snapshotAt = arg.substr(14);
+    else if (arg.compare(0, 10, "--restore=") == 0)
+      restoreFile = arg.substr(10);
+    else if (arg.compare(0, 8, "--batch=") == 0)
+      batchDir = arg.substr(8);
+    else if (arg == "-j" and i+1 < argc and parseLimit(argv[i+1], value) and
+             value > 0 and value <= MaxThreads) {
+      threads = value;
+      ++i;
+    }
+    else if (arg.compare(0, 10, "--profile=") == 0)
+      profileFile = arg.substr(10);
+    else if (arg.compare(0, 17, "--profile-stacks=") == 0)
+      stacksFile = arg.substr(17);
+    else if (fileName.empty() and arg != "" and arg[0] != '-')
+      fileName = arg;
+    else if (batchDir != "" and arg != "" and arg[0] != '-')
+      inputs.push_back(arg);
+    else
+      valid = false;
+  }
+  if (snapshotFile.empty() != snapshotAt.empty()) valid = false;
+  if (batchDir != "" and (inputs.empty() or snapshotFile != "" or restoreFile != "" or
+                          profileFile != "" or stacksFile != "" or dump))
+    valid = false;
+  if (batchDir == "" and threads > 0) valid = false;
+  if (not valid or fileName.empty()) {
+    std::cout << "Usage: ./vm [--dump] [--profile=<file>] [--profile-stacks=<file>]"
+              << " [--max-instructions=<n>] [--max-depth=<n>] [--max-memory=<bytes>[K|M|G]]"
+              << " [--snapshot=<file.tvs> --snapshot-at=<function> | --restore=<file.tvs>]"
+              << " <program.tbc>" << std::endl
+              << "       ./vm --batch=<dir> [-j <threads>] [--max-...] <program.tbc> <input>..."
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // map the binary program
+  BinaryCode program;
+  std::string error;
+  if (not program.load(fileName, error)) {
+    std::cerr << error << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // print it back in text form (the same as asl without -o)
+  if (dump) {
+    code text = program.to_code();
+    for (auto & subr : text.get_subroutines()) subr.expand_for_tvm();
+    std::cout << text.dump() << std::endl;
+    return EXIT_SUCCESS;
+  }
+
+  // the vm does its own buffering
+  std::ios::sync_with_stdio(false);
+  if (batchDir != "") return runBatch(program, limits, batchDir, threads, inputs);
+  vmachine vm(program);
+  vm.set_limits(limits);
+  // the snapshot is taken when the function is called the first time
+  if (snapshotAt != "") {
+    int sub = program.find_subroutine(snapshotAt);
+    if (sub < 0) {
+      std::cerr << "There is no function " << snapshotAt << std::endl;
+      return EXIT_FAILURE;
+    }
+    vm.set_snapshot(snapshotFile, sub);
+  }
+  Snapshot snapshot;
+  if (restoreFile != "" and not snapshot.load(restoreFile, error)) {
+    std::cerr << error << std::endl;
+    return EXIT_FAILURE;
+  }
+  Profiler profiler(program);
+  bool profiling = (profileFile != "" or stacksFile != "");
+  if (profiling) vm.set_profiler(&profiler);
+  bool ok = (restoreFile != "" ? vm.resume(snapshot, std::cin, std::cout)
+                                : vm.execute(std::cin, std::cout));
+  const vmachine::Status & status = vm.get_status();
+  if (not ok) {
+    std::cout << std::flush;
+    std::cerr << status.message << std::endl;
+    // where a program that has run out of a limit was
+    if (status.outcome != vmachine::RuntimeError) {
+      std::cerr << "  after " << status.instructions << " instructions, "
+                << status.depth << " calls deep" << std::endl;
+      for (auto & frame : status.stack)
+        std::cerr << "  in " << frame << std::endl;
+      if (status.stack.size() <= status.depth)
+        std::cerr << "  ..." << std::endl;
+    }
+  }
+
+  // the profile is written even if the program has failed
+  if (profileFile != "") {
+    std::ofstream out(profileFile);
+    profiler.print_flat(out);
+  }
+  if (stacksFile != "") {
+    std::ofstream out(stacksFile);
+    profiler.print_collapsed(out);
+  }
+  // a limit is told apart from an error of the program
+  if (ok) return EXIT_SUCCESS;
+  return status.outcome == vmachine::RuntimeError ? EXIT_FAILURE : 2;
+}